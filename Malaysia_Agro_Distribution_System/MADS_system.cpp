@@ -10,6 +10,43 @@
 #include <cmath>     // For mathematical calculations
 #include <limits>    // For handling numeric limits
 #include <unordered_map> // For hash table-based maps
+#include <deque>     // For containers whose elements never move when they grow
+#include <cstdint>   // For fixed-width integer types used in the binary snapshot
+#include <cstring>   // For memcpy when encoding and decoding binary records
+#include <cstdio>    // For renaming and removing files
+#include <filesystem> // For truncating a torn journal tail
+#include <string_view> // For zero-copy views into mapped files
+#include <charconv>  // For parsing numbers straight out of mapped memory
+#include <array>     // For fixed-size digests
+#include <thread>    // For verifying the chain on several cores
+#include <chrono>    // For timing route planning
+#include <atomic>    // For sharing work between routing threads
+#include <mutex>     // For serialising stock, credit and ledger updates
+#include <shared_mutex> // For letting order batches share the entity lists and contract plan
+#include <condition_variable> // For waking the blockchain writer thread
+#include <memory>    // For owning ring buffer storage
+#include <random>    // For reproducible synthetic benchmark data
+#include <future>    // For loading data files concurrently
+#include <numeric>   // For ranking order planner candidates
+#include <cctype>    // For checking what follows a number typed at a prompt
+
+// Platform headers for memory-mapping files
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX // Keep windows.h from defining min/max macros
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>   // For reading peak memory use in benchmark mode
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h> // For reading peak memory use in benchmark mode
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // Forward declarations of classes
 class Block;
@@ -21,1468 +58,7775 @@ class Transporter;
 class Transaction;
 class SmartContract;
 
-// Utility function to get the current timestamp
-std::string getCurrentTimestamp() {
-    time_t now = time(0);                 // Get current time
-    std::tm* timeinfo = localtime(&now);  // Convert to local time format
+// Utility function to format an epoch time as the system's timestamp text (YYYYMMDD:HH:MM)
+std::string formatTimestamp(int64_t epochSeconds) {
+    time_t time = static_cast<time_t>(epochSeconds);
+    std::tm timeinfo;                     // Local time, filled per call so order threads can format at once
+#ifdef _WIN32
+    localtime_s(&timeinfo, &time);
+#else
+    localtime_r(&time, &timeinfo);
+#endif
     char buffer[80];                      // Buffer to store formatted time
-    strftime(buffer, sizeof(buffer), "%Y%m%d:%H:%M", timeinfo); // Format timestamp
+    strftime(buffer, sizeof(buffer), "%Y%m%d:%H:%M", &timeinfo); // Format timestamp
     return std::string(buffer);           // Convert buffer to string and return
 }
 
-// Utility function to generate a random hash (dummy function, not cryptographically secure)
-std::string generateHash() {
-    const char alphanum[] = "0123456789abcdefghijklmnopqrstuvwxyz"; // Character set for hash
-    std::string hash = "";  // Initialize empty hash string
-    for (int i = 0; i < 10; i++) { // Generate 10-character hash
-        hash += alphanum[rand() % (sizeof(alphanum) - 1)]; // Append random character
+// Utility function to get the current timestamp
+std::string getCurrentTimestamp() {
+    return formatTimestamp(static_cast<int64_t>(time(0)));
+}
+
+// Utility function to parse timestamp text (YYYYMMDD:HH:MM) back into an epoch time.
+// Returns 0 if the text is not in that format. Records loaded in bulk mostly share the
+// minute of their neighbour, so the last result is remembered per thread to skip mktime.
+int64_t parseTimestamp(std::string_view text) {
+    if (text.size() != 14 || text[8] != ':' || text[11] != ':') {
+        return 0;
+    }
+    thread_local char lastText[14] = {};
+    thread_local int64_t lastTime = 0;
+    if (lastTime != 0 && std::memcmp(lastText, text.data(), sizeof(lastText)) == 0) {
+        return lastTime;
     }
-    return hash; // Return generated hash
+    auto field = [text](size_t offset, size_t length, int& value) {
+        const char* first = text.data() + offset;
+        auto result = std::from_chars(first, first + length, value);
+        return result.ec == std::errc() && result.ptr == first + length;
+    };
+    int year, month, day, hour, minute;
+    if (!field(0, 4, year) || !field(4, 2, month) || !field(6, 2, day) ||
+        !field(9, 2, hour) || !field(12, 2, minute)) {
+        return 0;
+    }
+    std::tm timeinfo = {};
+    timeinfo.tm_year = year - 1900;
+    timeinfo.tm_mon = month - 1;
+    timeinfo.tm_mday = day;
+    timeinfo.tm_hour = hour;
+    timeinfo.tm_min = minute;
+    timeinfo.tm_isdst = -1; // Let the C library work out daylight saving time
+    time_t time = mktime(&timeinfo);
+    if (time == static_cast<time_t>(-1)) {
+        return 0;
+    }
+    std::memcpy(lastText, text.data(), sizeof(lastText));
+    lastTime = static_cast<int64_t>(time);
+    return lastTime;
 }
 
-// Function to calculate the approximate distance between two geographical points
-// This uses Euclidean distance; a real-world implementation should use the Haversine formula
-double calculateDistance(double lat1, double lon1, double lat2, double lon2) {
-    return sqrt(pow(lat2 - lat1, 2) + pow(lon2 - lon1, 2)) * 111.0; // Convert degrees to km
+// Hot-path instrumentation
+// Scoped timers record into per-thread histograms that are merged when metrics are read,
+// so recording never contends between threads. Build with -DMADS_DISABLE_METRICS to compile
+// the timers down to empty objects.
+#ifdef MADS_DISABLE_METRICS
+const bool metricsEnabled = false;
+#else
+const bool metricsEnabled = true;
+#endif
+
+// MetricId enum
+// Instrumented operations
+enum class MetricId : uint8_t {
+    OrderResolve,     // Entity lookup and pricing of an order batch
+    OrderValidate,    // Smart contract validation of an order batch
+    OrderPlan,        // Choosing the cheapest supplier and transporter for one order
+    OrderApply,       // Stock and credit updates of an order batch
+    OrderStore,       // History and journal update of an order batch, blockchain submit included
+    BlockAppend,      // Hashing and linking one block on the writer thread
+    ChainPersist,     // Appending new blocks to the chain file
+    JournalFlush,     // Making the journal durable
+    Checkpoint,       // Capturing a snapshot, and writing it when the checkpoint is synchronous
+    SnapshotWrite,    // Writing a captured snapshot on the snapshot writer thread
+    SaveData,         // A whole saveData call
+    Count
+};
+
+const size_t metricCount = static_cast<size_t>(MetricId::Count);
+const size_t metricBucketCount = 32; // Bucket b counts durations below 2^b ns; the last is open-ended
+
+// Utility function to get the name of a metric as used in reports and exports
+const char* metricName(MetricId metric) {
+    switch (metric) {
+        case MetricId::OrderResolve: return "order_resolve";
+        case MetricId::OrderValidate: return "order_validate";
+        case MetricId::OrderPlan: return "order_plan";
+        case MetricId::OrderApply: return "order_apply";
+        case MetricId::OrderStore: return "order_store";
+        case MetricId::BlockAppend: return "block_append";
+        case MetricId::ChainPersist: return "chain_persist";
+        case MetricId::JournalFlush: return "journal_flush";
+        case MetricId::Checkpoint: return "checkpoint";
+        case MetricId::SnapshotWrite: return "snapshot_write";
+        case MetricId::SaveData: return "save_data";
+        case MetricId::Count: break;
+    }
+    return "unknown";
 }
 
-// Class representing a block in the blockchain
-class Block {
-private:
-    int blockNumber;         // Block index in the chain
-    std::string currentHash; // Hash of the current block
-    std::string previousHash;// Hash of the previous block
-    std::string timestamp;   // Time when the block was created
-    std::string data;        // Data stored in the block
+// MetricHistogram struct
+// Merged duration histogram of one operation
+struct MetricHistogram {
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    std::array<uint64_t, metricBucketCount> buckets{};
 
-public:
-    // Constructor to initialize a block
-    Block(int blockNum, const std::string& prevHash, const std::string& blockData) 
-        : blockNumber(blockNum), previousHash(prevHash), data(blockData) {
-        timestamp = getCurrentTimestamp(); // Get and store current timestamp
-        currentHash = generateHash();      // Generate and store block hash
+    // Function to estimate a percentile as the upper bound of the bucket that reaches it
+    double percentileNs(double fraction) const {
+        uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * count));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < metricBucketCount; ++b) {
+            seen += buckets[b];
+            if (seen >= rank && seen > 0) {
+                return std::ldexp(1.0, static_cast<int>(b));
+            }
+        }
+        return 0.0;
     }
+};
 
-    // Getters for block attributes
-    std::string getCurrentHash() const { return currentHash; }
-    std::string getPreviousHash() const { return previousHash; }
-    int getBlockNumber() const { return blockNumber; }
-    std::string getTimestamp() const { return timestamp; }
-    std::string getData() const { return data; }
+// MetricsRegistry class
+// Owns every thread's counters. Each thread writes only its own counters (relaxed atomics,
+// no read-modify-write), readers sum them, and a thread's counts are folded into the
+// retired totals when it exits.
+class MetricsRegistry {
+private:
+    struct ThreadCounters {
+        std::array<std::array<std::atomic<uint64_t>, metricBucketCount>, metricCount> buckets{};
+        std::array<std::atomic<uint64_t>, metricCount> totalNs{};
+    };
 
-    // Overloading the output stream operator to display block information
-    friend std::ostream& operator<<(std::ostream& os, const Block& block) {
-        os << "Block " << block.blockNumber << " | " 
-           << block.currentHash << " | " 
-           << block.previousHash << " | " 
-           << block.timestamp << " | " 
-           << block.data;
-        return os;
+    // Registers the calling thread's counters on first use and retires them at thread exit
+    struct ThreadSlot {
+        ThreadCounters counters;
+        ThreadSlot() { instance().attach(&counters); }
+        ~ThreadSlot() { instance().detach(&counters); }
+    };
+
+    std::mutex mutex;
+    std::vector<ThreadCounters*> live; // Counters of running threads
+    std::array<MetricHistogram, metricCount> retired; // Counts of threads that have exited
+
+    void attach(ThreadCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        live.push_back(counters);
     }
 
-    // Serialize block data into a string format for file storage
-    std::string serialize() const {
-        std::stringstream ss;
-        ss << blockNumber << "|" << currentHash << "|" << previousHash << "|" << timestamp << "|" << data;
-        return ss.str();
+    void detach(ThreadCounters* counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        addTo(*counters, retired);
+        live.erase(std::remove(live.begin(), live.end(), counters), live.end());
     }
 
-    // Deserialize a block from a stored string format
-    static Block deserialize(const std::string& str) {
-        std::stringstream ss(str);
-        std::string item;
-        std::vector<std::string> parts;
-        
-        while (std::getline(ss, item, '|')) { // Split string by '|'
-            parts.push_back(item);
+    static void addTo(const ThreadCounters& counters, std::array<MetricHistogram, metricCount>& totals) {
+        for (size_t m = 0; m < metricCount; ++m) {
+            for (size_t b = 0; b < metricBucketCount; ++b) {
+                uint64_t bucket = counters.buckets[m][b].load(std::memory_order_relaxed);
+                totals[m].buckets[b] += bucket;
+                totals[m].count += bucket;
+            }
+            totals[m].totalNs += counters.totalNs[m].load(std::memory_order_relaxed);
         }
+    }
 
-        if (parts.size() < 5) { // Validate correct format
-            throw std::runtime_error("Invalid block data format");
+    // Helper function to get the bucket of a duration: the number of bits it needs
+    static size_t bucketOf(uint64_t ns) {
+#if defined(__GNUC__)
+        size_t bits = ns == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(ns));
+#else
+        size_t bits = 0;
+        for (uint64_t value = ns; value != 0; value >>= 1) {
+            ++bits;
         }
-
-        int blockNum = std::stoi(parts[0]); // Convert block number to integer
-        Block block(blockNum, parts[2], parts[4]); // Create block instance
-        block.currentHash = parts[1]; // Restore hash
-        block.timestamp = parts[3];   // Restore timestamp
-        
-        return block;
+#endif
+        return std::min(bits, metricBucketCount - 1);
     }
-};
 
-// Blockchain class managing a chain of blocks
-class Blockchain {
-private:
-    std::vector<Block> chain; // Vector storing blocks in the chain
-    
 public:
-    // Constructor to initialize blockchain with a genesis block
-    Blockchain() {
-        createGenesisBlock(); // Create the first block in the blockchain
+    // Function to get the process-wide registry
+    static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
     }
 
-    // Function to create the genesis block (first block in the chain)
-    void createGenesisBlock() {
-        std::string genesisHash = generateHash(); // Generate a unique hash
-        Block genesisBlock(0, genesisHash, "Genesis Block"); // Create genesis block
-        chain.push_back(genesisBlock); // Add genesis block to chain
+    // Record one duration against the calling thread's counters
+    static void record(MetricId metric, uint64_t ns) {
+        thread_local ThreadSlot slot;
+        size_t m = static_cast<size_t>(metric);
+        std::atomic<uint64_t>& bucket = slot.counters.buckets[m][bucketOf(ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic<uint64_t>& total = slot.counters.totalNs[m];
+        total.store(total.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
     }
 
-    // Function to get the latest block in the chain
-    Block getLatestBlock() const {
-        if (chain.empty()) { // Check if blockchain is empty
-            throw std::runtime_error("Blockchain is empty");
+    // Function to merge every thread's counters into one histogram per metric
+    std::array<MetricHistogram, metricCount> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::array<MetricHistogram, metricCount> totals = retired;
+        for (const ThreadCounters* counters : live) {
+            addTo(*counters, totals);
         }
-        return chain.back(); // Return the last block in the chain
+        return totals;
     }
+};
 
-    // Function to add a new block to the chain
-    void addBlock(const std::string& data) {
-        try {
-            Block latestBlock = getLatestBlock(); // Get last block
-            Block newBlock(latestBlock.getBlockNumber() + 1, latestBlock.getCurrentHash(), data); // Create new block
-            chain.push_back(newBlock); // Add block to chain
-        }
-        catch (const std::exception& e) {
-            std::cerr << "Error adding block: " << e.what() << std::endl;
-            throw;
+// ScopedTimer class
+// Records the time from construction to stop() or destruction against a metric
+#ifdef MADS_DISABLE_METRICS
+class ScopedTimer {
+public:
+    explicit ScopedTimer(MetricId) {}
+    void stop() {}
+};
+#else
+class ScopedTimer {
+private:
+    MetricId metric;
+    std::chrono::steady_clock::time_point start;
+    bool running = true;
+
+public:
+    explicit ScopedTimer(MetricId timedMetric) : metric(timedMetric), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { stop(); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    // Record now instead of at the end of the scope
+    void stop() {
+        if (running) {
+            running = false;
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            MetricsRegistry::record(metric, static_cast<uint64_t>(elapsed.count()));
         }
     }
+};
+#endif
 
-    // Function to check blockchain integrity
-    bool isChainValid() const {
-        for (size_t i = 1; i < chain.size(); i++) {
-            if (chain[i].getPreviousHash() != chain[i-1].getCurrentHash()) { // Verify hash linkage
-                return false;
-            }
+// Utility function to write the metrics in the Prometheus text exposition format
+void writePrometheusMetrics(std::ostream& out) {
+    std::array<MetricHistogram, metricCount> histograms = MetricsRegistry::instance().snapshot();
+    out << "# HELP mads_operation_seconds Time spent in instrumented MADS operations\n";
+    out << "# TYPE mads_operation_seconds histogram\n";
+    for (size_t m = 0; m < metricCount; ++m) {
+        const MetricHistogram& histogram = histograms[m];
+        const char* name = metricName(static_cast<MetricId>(m));
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b + 1 < metricBucketCount; ++b) {
+            cumulative += histogram.buckets[b];
+            out << "mads_operation_seconds_bucket{operation=\"" << name << "\",le=\""
+                << std::ldexp(1.0, static_cast<int>(b)) * 1e-9 << "\"} " << cumulative << '\n';
         }
-        return true;
+        out << "mads_operation_seconds_bucket{operation=\"" << name << "\",le=\"+Inf\"} " << histogram.count << '\n';
+        out << "mads_operation_seconds_sum{operation=\"" << name << "\"} " << histogram.totalNs * 1e-9 << '\n';
+        out << "mads_operation_seconds_count{operation=\"" << name << "\"} " << histogram.count << '\n';
     }
+}
 
-    // Display all blocks in the blockchain
-    void displayChain() const {
-        for (const auto& block : chain) {
-            std::cout << block << std::endl;
-            std::cout << "--------------------------------------" << std::endl;
+// Utility function to write the metrics as one JSON object keyed by operation
+void writeJsonMetrics(std::ostream& out) {
+    std::array<MetricHistogram, metricCount> histograms = MetricsRegistry::instance().snapshot();
+    out << "{\n";
+    for (size_t m = 0; m < metricCount; ++m) {
+        const MetricHistogram& histogram = histograms[m];
+        out << "  \"" << metricName(static_cast<MetricId>(m)) << "\": {\"count\": " << histogram.count
+            << ", \"total_ns\": " << histogram.totalNs
+            << ", \"p50_ns\": " << histogram.percentileNs(0.50)
+            << ", \"p99_ns\": " << histogram.percentileNs(0.99) << ", \"buckets\": [";
+        for (size_t b = 0; b < metricBucketCount; ++b) {
+            out << (b == 0 ? "" : ", ") << histogram.buckets[b];
         }
+        out << "]}" << (m + 1 < metricCount ? "," : "") << '\n';
     }
+    out << "}\n";
+}
 
-    // Save blockchain to file
-    bool saveToFile(const std::string& filename) const {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Could not open file for writing: " << filename << std::endl;
-            return false;
-        }
+// SHA-256 (FIPS 180-4) used to hash block contents
+typedef std::array<uint8_t, 32> Sha256Digest;
 
-        for (const auto& block : chain) {
-            file << block.serialize() << std::endl;
-        }
-        
-        file.close();
-        return true;
+const uint32_t sha256InitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const uint32_t sha256RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Utility function to read a big-endian 32-bit word
+inline uint32_t loadBigEndian32(const unsigned char* bytes) {
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+// Utility function to pad a message to a whole number of 64-byte SHA-256 blocks
+void sha256Pad(std::string_view message, std::string& padded) {
+    uint64_t bitLength = static_cast<uint64_t>(message.size()) * 8;
+    padded.assign(message.data(), message.size());
+    padded.push_back(static_cast<char>(0x80));
+    while (padded.size() % 64 != 56) {
+        padded.push_back('\0');
     }
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        padded.push_back(static_cast<char>((bitLength >> shift) & 0xff));
+    }
+}
 
-    // Load blockchain from file
-    bool loadFromFile(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Could not open file for reading: " << filename << std::endl;
-            return false;
-        }
+// Sha256Stream class
+// Incremental SHA-256: the message can be fed in pieces, so callers never have to
+// concatenate it into one buffer first
+class Sha256Stream {
+private:
+    uint32_t state[8];
+    unsigned char buffer[64]; // Bytes of the current, not yet compressed block
+    size_t buffered = 0;
+    uint64_t totalBytes = 0;
 
-        chain.clear(); // Clear existing chain
-        std::string line;
-        
-        while (std::getline(file, line)) {
-            try {
-                Block block = Block::deserialize(line);
-                chain.push_back(block);
-            }
-            catch (const std::exception& e) {
-                return false;
-            }
+    // Helper function to mix one 64-byte block into the state
+    void compress(const unsigned char* block) {
+        auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+        uint32_t w[64];
+        for (int t = 0; t < 16; ++t) {
+            w[t] = loadBigEndian32(block + t * 4);
+        }
+        for (int t = 16; t < 64; ++t) {
+            uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
         }
         
-        if (chain.empty()) {
-            createGenesisBlock();
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256RoundConstants[t] + w[t];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
         }
-        return true;
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
     }
-    size_t size() const {
-        return chain.size();
+
+public:
+    Sha256Stream() {
+        std::memcpy(state, sha256InitialState, sizeof(state));
     }
-};
 
-// Product class
-class Product {
-    private:
-        int id; // Unique identifier for the product
-        std::string name; // Name of the product
-        double price; // Price of the product
-        int stock; // Stock quantity of the product
-    
-    public:
-        // Constructor to initialize a Product object
-        Product(int productId, const std::string& productName, double productPrice, int productStock)
-            : id(productId), name(productName), price(productPrice), stock(productStock) {}
-    
-        // Getter function to return the product ID
-        int getId() const { return id; }
-    
-        // Getter function to return the product name
-        std::string getName() const { return name; }
-    
-        // Getter function to return the product price
-        double getPrice() const { return price; }
-    
-        // Getter function to return the stock quantity
-        int getStock() const { return stock; }
-    
-        // Function to update the stock quantity by adding or subtracting a given amount
-        void updateStock(int quantity) {
-            stock += quantity;
+    // Feed the next piece of the message
+    void update(std::string_view piece) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(piece.data());
+        size_t length = piece.size();
+        totalBytes += length;
+        if (buffered > 0) {
+            size_t take = std::min(length, sizeof(buffer) - buffered);
+            std::memcpy(buffer + buffered, bytes, take);
+            buffered += take;
+            bytes += take;
+            length -= take;
+            if (buffered < sizeof(buffer)) {
+                return;
+            }
+            compress(buffer);
+            buffered = 0;
         }
-    
-        // Function to check if the stock is sufficient for a given quantity
-        bool hasEnoughStock(int quantity) const {
-            return stock >= quantity;
+        for (; length >= 64; bytes += 64, length -= 64) {
+            compress(bytes); // Whole blocks are hashed straight from the caller's memory
         }
-    
-        // Function to generate a string representation of the product details
-        std::string toString() const {
-            std::stringstream ss;
-            ss << "Product ID: " << id << " | Name: " << name 
-               << " | Price: RM" << std::fixed << std::setprecision(2) << price 
-               << " | Stock: " << stock;
-            return ss.str();
+        std::memcpy(buffer, bytes, length);
+        buffered = length;
+    }
+
+    // Pad the message and return its digest
+    Sha256Digest finish() {
+        uint64_t bitLength = totalBytes * 8;
+        unsigned char padding[72] = {0x80};
+        size_t paddingLength = (buffered < 56 ? 56 : 120) - buffered;
+        for (int i = 0; i < 8; ++i) {
+            padding[paddingLength + i] = static_cast<unsigned char>(bitLength >> (56 - 8 * i));
         }
-    
-        // Function to serialize product data into a string format for storage
-        std::string serialize() const {
-            std::stringstream ss;
-            ss << id << "|" << name << "|" << price << "|" << stock;
-            return ss.str();
+        update(std::string_view(reinterpret_cast<const char*>(padding), paddingLength + 8));
+        
+        Sha256Digest digest;
+        for (int i = 0; i < 8; ++i) {
+            digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
         }
+        return digest;
+    }
+};
+
+// Utility function to compute the SHA-256 digest of a message
+Sha256Digest sha256(std::string_view message) {
+    Sha256Stream stream;
+    stream.update(message);
+    return stream.finish();
+}
+
+// Multi-buffer SHA-256: hashes several independent messages at once, one per SIMD lane.
+// GCC/Clang vector extensions map the lanes onto SSE2/NEON registers, or AVX2 when the
+// program is built with -mavx2; other compilers hash one message at a time.
+#if defined(__GNUC__)
+#if defined(__AVX2__)
+constexpr size_t sha256Lanes = 8;
+#else
+constexpr size_t sha256Lanes = 4;
+#endif
+typedef uint32_t Sha256Vector __attribute__((vector_size(sha256Lanes * sizeof(uint32_t))));
+
+// Utility function to rotate every lane right
+inline Sha256Vector rotrLanes(Sha256Vector x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+// Utility function to put the same value in every lane
+inline Sha256Vector broadcastLanes(uint32_t value) {
+    Sha256Vector vector;
+    for (size_t lane = 0; lane < sha256Lanes; ++lane) {
+        vector[lane] = value;
+    }
+    return vector;
+}
+
+// Hash up to sha256Lanes messages in parallel
+void sha256MultiBuffer(const std::string_view* messages, size_t count, Sha256Digest* digests) {
+    std::string padded[sha256Lanes];
+    Sha256Vector blockCount = broadcastLanes(0);
+    size_t maxBlocks = 0;
+    for (size_t lane = 0; lane < count; ++lane) {
+        sha256Pad(messages[lane], padded[lane]);
+        blockCount[lane] = static_cast<uint32_t>(padded[lane].size() / 64);
+        maxBlocks = std::max(maxBlocks, padded[lane].size() / 64);
+    }
     
-        // Static function to deserialize a product from a serialized string
-        static Product deserialize(const std::string& str) {
-            std::stringstream ss(str);
-            std::string item;
-            std::vector<std::string> parts;
-            
-            // Splitting the input string by '|' delimiter
-            while (std::getline(ss, item, '|')) {
-                parts.push_back(item);
-            }
+    Sha256Vector state[8];
+    for (int i = 0; i < 8; ++i) {
+        state[i] = broadcastLanes(sha256InitialState[i]);
+    }
     
-            // Ensure the correct number of fields is present
-            if (parts.size() < 4) {
-                throw std::runtime_error("Invalid product data format");
+    for (size_t blockIndex = 0; blockIndex < maxBlocks; ++blockIndex) {
+        // Transpose the next 64-byte block of every lane into the message schedule
+        Sha256Vector w[64];
+        for (int t = 0; t < 16; ++t) {
+            w[t] = broadcastLanes(0);
+            for (size_t lane = 0; lane < count; ++lane) {
+                if (blockIndex < blockCount[lane]) {
+                    const unsigned char* block = reinterpret_cast<const unsigned char*>(padded[lane].data()) + blockIndex * 64;
+                    w[t][lane] = loadBigEndian32(block + t * 4);
+                }
             }
-    
-            // Extract and convert data from string format
-            int id = std::stoi(parts[0]);
-            std::string name = parts[1];
-            double price = std::stod(parts[2]);
-            int stock = std::stoi(parts[3]);
-            
-            return Product(id, name, price, stock);
         }
-    };
-    
-    // Supplier class
-    class Supplier {
-    private:
-        int id; // Unique identifier for the supplier
-        std::string name; // Supplier name
-        std::string location; // Location of the supplier
-        std::string branch; // Branch name of the supplier
-        double latitude; // Latitude coordinate of the supplier location
-        double longitude; // Longitude coordinate of the supplier location
-        std::vector<int> productIds; // List of product IDs supplied
-    
-    public:
-        // Constructor to initialize a Supplier object
-        Supplier(int supplierId, const std::string& supplierName, const std::string& supplierLocation, 
-                 const std::string& supplierBranch, double lat, double lon)
-            : id(supplierId), name(supplierName), location(supplierLocation), 
-              branch(supplierBranch), latitude(lat), longitude(lon) {}
-    
-        // Getter function to return the supplier ID
-        int getId() const { return id; }
-    
-        // Getter function to return the supplier name
-        std::string getName() const { return name; }
-    
-        // Getter function to return the supplier location
-        std::string getLocation() const { return location; }
-    
-        // Getter function to return the supplier branch
-        std::string getBranch() const { return branch; }
-    
-        // Getter function to return the latitude of the supplier location
-        double getLatitude() const { return latitude; }
-    
-        // Getter function to return the longitude of the supplier location
-        double getLongitude() const { return longitude; }
+        for (int t = 16; t < 64; ++t) {
+            Sha256Vector s0 = rotrLanes(w[t - 15], 7) ^ rotrLanes(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            Sha256Vector s1 = rotrLanes(w[t - 2], 17) ^ rotrLanes(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
         
-        // Function to add a product ID to the supplier's list of products
-        void addProduct(int productId) {
-            productIds.push_back(productId);
+        Sha256Vector a = state[0], b = state[1], c = state[2], d = state[3];
+        Sha256Vector e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            Sha256Vector t1 = h + (rotrLanes(e, 6) ^ rotrLanes(e, 11) ^ rotrLanes(e, 25)) + ((e & f) ^ (~e & g))
+                              + broadcastLanes(sha256RoundConstants[t]) + w[t];
+            Sha256Vector t2 = (rotrLanes(a, 2) ^ rotrLanes(a, 13) ^ rotrLanes(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
         }
+        
+        // Only lanes whose message still has blocks take the update
+        Sha256Vector active = reinterpret_cast<Sha256Vector>(broadcastLanes(static_cast<uint32_t>(blockIndex)) < blockCount);
+        state[0] += a & active; state[1] += b & active; state[2] += c & active; state[3] += d & active;
+        state[4] += e & active; state[5] += f & active; state[6] += g & active; state[7] += h & active;
+    }
     
-        // Getter function to retrieve the list of product IDs
-        const std::vector<int>& getProductIds() const {
-            return productIds;
+    for (size_t lane = 0; lane < count; ++lane) {
+        for (int i = 0; i < 8; ++i) {
+            uint32_t word = state[i][lane];
+            digests[lane][i * 4] = static_cast<uint8_t>(word >> 24);
+            digests[lane][i * 4 + 1] = static_cast<uint8_t>(word >> 16);
+            digests[lane][i * 4 + 2] = static_cast<uint8_t>(word >> 8);
+            digests[lane][i * 4 + 3] = static_cast<uint8_t>(word);
         }
-    
-        // Function to generate a string representation of supplier details
-        std::string toString() const {
-            std::stringstream ss;
-            ss << "Supplier ID: " << id << " | Name: " << name 
-               << " | Location: " << location << " | Branch: " << branch;
-            return ss.str();
-        }
-    
-        // Function to generate data to be stored in a blockchain
-        std::string getBlockData() const {
-            std::stringstream ss;
-            ss << "Supplier ID: " << id << " | Supplier Name: " << name
-               << " | Location: " << location << " | Branch: " << branch;
-            return ss.str();
-        }
-    
-        // Function to serialize supplier data into a string format for storage
-        std::string serialize() const {
-            std::stringstream ss;
-            ss << id << "|" << name << "|" << location << "|" << branch << "|" << latitude << "|" << longitude;
-            
-            // Add product IDs to the serialized string
-            ss << "|";
-            for (size_t i = 0; i < productIds.size(); ++i) {
-                ss << productIds[i];
-                if (i < productIds.size() - 1) {
-                    ss << ",";
-                }
-            }
-            
-            return ss.str();
+    }
+}
+#else
+constexpr size_t sha256Lanes = 1;
+
+// Hash messages one at a time on compilers without vector extensions
+void sha256MultiBuffer(const std::string_view* messages, size_t count, Sha256Digest* digests) {
+    for (size_t i = 0; i < count; ++i) {
+        digests[i] = sha256(messages[i]);
+    }
+}
+#endif
+
+// Utility function to write a digest as 64 lowercase hex characters
+void digestToHex(const Sha256Digest& digest, char* hex) {
+    const char hexDigits[] = "0123456789abcdef";
+    for (size_t i = 0; i < digest.size(); ++i) {
+        hex[i * 2] = hexDigits[digest[i] >> 4];
+        hex[i * 2 + 1] = hexDigits[digest[i] & 0x0f];
+    }
+}
+
+// Utility function to format a digest as lowercase hex
+std::string digestToHex(const Sha256Digest& digest) {
+    std::string hex(64, '0');
+    digestToHex(digest, &hex[0]);
+    return hex;
+}
+
+// Utility function to build the bytes a block hash covers: number, previous hash, timestamp and data
+void blockHashInput(int blockNumber, std::string_view previousHash, std::string_view timestamp,
+                    std::string_view data, std::string& input) {
+    input = std::to_string(blockNumber);
+    input += '|';
+    input += previousHash;
+    input += '|';
+    input += timestamp;
+    input += '|';
+    input += data;
+}
+
+// Utility function to write the content hash of a block as 64 hex characters, streaming the
+// fields through the hasher instead of concatenating them
+void computeBlockHash(int blockNumber, std::string_view previousHash, std::string_view timestamp,
+                      std::string_view data, char* hex) {
+    char number[16];
+    auto converted = std::to_chars(number, number + sizeof(number), blockNumber);
+    Sha256Stream stream;
+    stream.update(std::string_view(number, converted.ptr - number));
+    stream.update("|");
+    stream.update(previousHash);
+    stream.update("|");
+    stream.update(timestamp);
+    stream.update("|");
+    stream.update(data);
+    digestToHex(stream.finish(), hex);
+}
+
+// Utility function to compute the content hash of a block
+std::string computeBlockHash(int blockNumber, std::string_view previousHash, std::string_view timestamp,
+                             std::string_view data) {
+    std::string hex(64, '0');
+    computeBlockHash(blockNumber, previousHash, timestamp, data, &hex[0]);
+    return hex;
+}
+
+// Utility function to tell content hashes apart from the random 10-character hashes
+// written by earlier versions, which can only be checked for linkage
+bool isContentHash(std::string_view hash) {
+    if (hash.size() != 64) {
+        return false;
+    }
+    for (char c : hash) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
         }
-    
-        // Static function to deserialize a supplier from a serialized string
-        static Supplier deserialize(const std::string& str) {
-            std::stringstream ss(str);
-            std::string item;
-            std::vector<std::string> parts;
-            
-            // Splitting the input string by '|' delimiter
-            while (std::getline(ss, item, '|')) {
-                parts.push_back(item);
-            }
-    
-            // Ensure the correct number of fields is present
-            if (parts.size() < 6) {
-                throw std::runtime_error("Invalid supplier data format");
-            }
-    
-            // Extract and convert data from string format
-            int id = std::stoi(parts[0]);
-            std::string name = parts[1];
-            std::string location = parts[2];
-            std::string branch = parts[3];
-            double latitude = std::stod(parts[4]);
-            double longitude = std::stod(parts[5]);
-            
-            Supplier supplier(id, name, location, branch, latitude, longitude);
-            
-            // Add product IDs if present
-            if (parts.size() > 6) {
-                std::stringstream productStream(parts[6]);
-                std::string productId;
-                
-                while (std::getline(productStream, productId, ',')) {
-                    if (!productId.empty()) {
-                        supplier.addProduct(std::stoi(productId));
-                    }
-                }
-            }
-            
-            return supplier;
+    }
+    return true;
+}
+
+// Mean radius of the Earth used for great-circle distances
+const double earthRadiusKm = 6371.0088;
+const double degreesToRadians = 3.14159265358979323846 / 180.0;
+
+// Function to calculate the great-circle distance in km between two geographical points (Haversine formula)
+double calculateDistance(double lat1, double lon1, double lat2, double lon2) {
+    double phi1 = lat1 * degreesToRadians;
+    double phi2 = lat2 * degreesToRadians;
+    double sinHalfLat = std::sin((phi2 - phi1) / 2.0);
+    double sinHalfLon = std::sin((lon2 - lon1) * degreesToRadians / 2.0);
+    double a = sinHalfLat * sinHalfLat + std::cos(phi1) * std::cos(phi2) * sinHalfLon * sinHalfLon;
+    return 2.0 * earthRadiusKm * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+// GeoVector struct
+// A location converted once to a point on the unit sphere. The straight-line (chord)
+// distance between two such points gives the Haversine distance without any
+// trigonometry per pair: haversine(angle) = chord^2 / 4.
+struct GeoVector {
+    double x;
+    double y;
+    double z;
+};
+
+// Utility function to convert a latitude/longitude in degrees to a unit vector
+GeoVector toGeoVector(double latitude, double longitude) {
+    double phi = latitude * degreesToRadians;
+    double lambda = longitude * degreesToRadians;
+    return GeoVector{std::cos(phi) * std::cos(lambda), std::cos(phi) * std::sin(lambda), std::sin(phi)};
+}
+
+// Utility function to turn a squared chord length on the unit sphere into km
+inline double chordToKm(double chordSquared) {
+    return 2.0 * earthRadiusKm * std::asin(std::min(1.0, std::sqrt(chordSquared) / 2.0));
+}
+
+// Utility function to get the great-circle distance in km between two unit vectors
+inline double geoDistance(const GeoVector& a, const GeoVector& b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    double dz = a.z - b.z;
+    return chordToKm(dx * dx + dy * dy + dz * dz);
+}
+
+// GeoPoints class
+// Unit vectors of many locations stored as separate x, y and z arrays
+class GeoPoints {
+public:
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+
+    // Function to get the number of points
+    size_t size() const { return x.size(); }
+
+    // Set the location of point i, appending it when i == size()
+    void set(size_t i, double latitude, double longitude) {
+        GeoVector v = toGeoVector(latitude, longitude);
+        if (i == x.size()) {
+            x.push_back(v.x);
+            y.push_back(v.y);
+            z.push_back(v.z);
+        } else {
+            x[i] = v.x;
+            y[i] = v.y;
+            z[i] = v.z;
         }
-    };
-    
-// Retailer class
-class Retailer {
+    }
+
+    // Remove every point
+    void clear() {
+        x.clear();
+        y.clear();
+        z.clear();
+    }
+};
+
+// Batched distance kernel: distances in km from one location to points [begin, end).
+// The first loop is plain arithmetic over contiguous arrays so the compiler vectorises it;
+// the arcsine is applied in a second pass.
+void distancesFrom(const GeoVector& from, const GeoPoints& to, size_t begin, size_t end, double* out) {
+    const double* xs = to.x.data();
+    const double* ys = to.y.data();
+    const double* zs = to.z.data();
+    size_t count = end - begin;
+    for (size_t i = 0; i < count; ++i) {
+        double dx = xs[begin + i] - from.x;
+        double dy = ys[begin + i] - from.y;
+        double dz = zs[begin + i] - from.z;
+        out[i] = dx * dx + dy * dy + dz * dz;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = chordToKm(out[i]);
+    }
+}
+
+// Batched distance kernel: row-major matrix of distances in km from every source to every target
+void distancesBetween(const GeoPoints& sources, const GeoPoints& targets, std::vector<double>& out) {
+    out.resize(sources.size() * targets.size());
+    for (size_t s = 0; s < sources.size(); ++s) {
+        GeoVector from{sources.x[s], sources.y[s], sources.z[s]};
+        distancesFrom(from, targets, 0, targets.size(), out.data() + s * targets.size());
+    }
+}
+
+// DistanceService class
+// Holds supplier and retailer locations as unit vectors by container slot and works each
+// distance out when it is asked for. A distance is a few multiplications and an arcsine,
+// no dearer than a lookup in a shared cache, and memory stays linear in the number of
+// locations rather than growing with every supplier and retailer pair.
+class DistanceService {
 private:
-    int id; // Unique identifier for the retailer
-    std::string name; // Name of the retailer
-    std::string location; // Location of the retailer
-    double latitude; // Latitude coordinate of the retailer's location
-    double longitude; // Longitude coordinate of the retailer's location
-    double creditBalance; // Current credit balance of the retailer
-    double annualCreditBalance; // Annual credit balance of the retailer
-    std::vector<int> productIds; // List of product IDs associated with the retailer
+    GeoPoints supplierPoints;
+    GeoPoints retailerPoints;
 
 public:
-    // Constructor to initialize a Retailer object
-    Retailer(int retailerId, const std::string& retailerName, const std::string& retailerLocation, 
-             double lat, double lon, double initialCredit, double annualCredit)
-        : id(retailerId), name(retailerName), location(retailerLocation), 
-          latitude(lat), longitude(lon), creditBalance(initialCredit), annualCreditBalance(annualCredit) {}
+    // Record the location of the supplier in the given slot (a new slot when slot == supplier count)
+    void setSupplier(size_t slot, double latitude, double longitude) {
+        supplierPoints.set(slot, latitude, longitude);
+    }
 
-    // Getter function to return the retailer ID
-    int getId() const { return id; }
-    
-    // Getter function to return the retailer name
-    std::string getName() const { return name; }
-    
-    // Getter function to return the retailer location
-    std::string getLocation() const { return location; }
-    
-    // Getter function to return the latitude of the retailer's location
-    double getLatitude() const { return latitude; }
-    
-    // Getter function to return the longitude of the retailer's location
-    double getLongitude() const { return longitude; }
-    
-    // Getter function to return the current credit balance of the retailer
-    double getCreditBalance() const { return creditBalance; }
-    
-    // Getter function to return the annual credit balance of the retailer
-    double getAnnualCreditBalance() const { return annualCreditBalance; }
-    
-    // Function to add a product ID to the retailer's list of products
-    void addProduct(int productId) {
-        productIds.push_back(productId);
+    // Record the location of the retailer in the given slot (a new slot when slot == retailer count)
+    void setRetailer(size_t slot, double latitude, double longitude) {
+        retailerPoints.set(slot, latitude, longitude);
     }
 
-    // Getter function to retrieve the list of product IDs
-    const std::vector<int>& getProductIds() const {
-        return productIds;
+    // Function to get the distance in km between a supplier and a retailer.
+    // Safe to call from several order threads at once.
+    double supplierToRetailer(size_t supplierSlot, size_t retailerSlot) const {
+        double dx = retailerPoints.x[retailerSlot] - supplierPoints.x[supplierSlot];
+        double dy = retailerPoints.y[retailerSlot] - supplierPoints.y[supplierSlot];
+        double dz = retailerPoints.z[retailerSlot] - supplierPoints.z[supplierSlot];
+        return chordToKm(dx * dx + dy * dy + dz * dz);
     }
 
-    // Function to deduct a specified amount from the retailer's credit balance
-    bool deductCredit(double amount) {
-        if (creditBalance >= amount) { // Check if sufficient credit is available
-            creditBalance -= amount; // Deduct the amount from the current credit balance
-            annualCreditBalance -= amount; // Deduct the amount from the annual credit balance
-            return true; // Return true if deduction is successful
+    // Function to get the distances in km from several suppliers to one retailer in one
+    // batched pass over the locations. Gives the same figures as supplierToRetailer and is
+    // safe to call from several order threads at once.
+    void suppliersToRetailer(const int* supplierSlots, size_t count, size_t retailerSlot, double* out) const {
+        GeoVector to{retailerPoints.x[retailerSlot], retailerPoints.y[retailerSlot], retailerPoints.z[retailerSlot]};
+        const double* xs = supplierPoints.x.data();
+        const double* ys = supplierPoints.y.data();
+        const double* zs = supplierPoints.z.data();
+        for (size_t i = 0; i < count; ++i) {
+            size_t slot = static_cast<size_t>(supplierSlots[i]);
+            double dx = to.x - xs[slot];
+            double dy = to.y - ys[slot];
+            double dz = to.z - zs[slot];
+            out[i] = dx * dx + dy * dy + dz * dz;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = chordToKm(out[i]);
         }
-        return false; // Return false if insufficient credit
     }
 
-    // Function to add a specified amount to the retailer's credit balance
-    void addCredit(double amount) {
-        creditBalance += amount; // Add the amount to the current credit balance
-        annualCreditBalance += amount; // Add the amount to the annual credit balance
+    // Remove every location
+    void clear() {
+        supplierPoints.clear();
+        retailerPoints.clear();
     }
 
-    // Function to generate a string representation of the retailer details
-    std::string toString() const {
-        std::stringstream ss;
-        ss << "Retailer ID: " << id << " | Name: " << name 
-           << " | Location: " << location 
-           << " | Credit Balance: RM" << std::fixed << std::setprecision(2) << creditBalance
-           << " | Annual Credit Balance: RM" << std::fixed << std::setprecision(2) << annualCreditBalance;
-        return ss.str();
+    // Reload every location from the supplier and retailer lists (used after bulk loads)
+    template <typename SupplierList, typename RetailerList>
+    void rebuild(const SupplierList& suppliers, const RetailerList& retailers) {
+        clear();
+        for (size_t i = 0; i < suppliers.size(); ++i) {
+            setSupplier(i, suppliers[i].getLatitude(), suppliers[i].getLongitude());
+        }
+        for (size_t i = 0; i < retailers.size(); ++i) {
+            setRetailer(i, retailers[i].getLatitude(), retailers[i].getLongitude());
+        }
     }
+};
 
-    // Function to generate data to be stored in a blockchain
-    std::string getBlockData() const {
-        std::stringstream ss;
-        ss << "Retailer ID: " << id << " | Retailer Name: " << name
-           << " | Location: " << location
-           << " | Credit Balance: RM" << std::fixed << std::setprecision(2) << creditBalance
-           << " | Annual Credit Balance: RM" << std::fixed << std::setprecision(2) << annualCreditBalance;
-        return ss.str();
+// Utility function to check whether a file exists and can be opened
+bool fileExists(const std::string& filename) {
+    std::ifstream file(filename);
+    return file.is_open();
+}
+
+// Utility function to read a whole file into memory with a single bulk read
+bool readWholeFile(const std::string& filename, std::vector<char>& buffer) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
     }
+    std::streamsize size = file.tellg(); // Opened at the end, so this is the file size
+    file.seekg(0, std::ios::beg);
+    buffer.resize(static_cast<size_t>(size));
+    return size == 0 || static_cast<bool>(file.read(buffer.data(), size));
+}
 
-    // Function to serialize retailer data into a string format for storage
-    std::string serialize() const {
-        std::stringstream ss;
-        ss << id << "|" << name << "|" << location << "|" << latitude << "|" << longitude << "|" 
-           << creditBalance << "|" << annualCreditBalance;
-        
-        // Add product IDs to the serialized string
-        ss << "|";
-        for (size_t i = 0; i < productIds.size(); ++i) {
-            ss << productIds[i];
-            if (i < productIds.size() - 1) {
-                ss << ",";
-            }
+// FieldReader class
+// Walks the fields of one delimited text record as views into the record, so splitting a
+// line allocates nothing, and converts numbers in place with std::from_chars. A trailing
+// '\r' is dropped so files saved with CRLF line endings load as well.
+class FieldReader {
+private:
+    std::string_view rest; // Fields not read yet
+    bool exhausted = false; // True once the last field has been read
+    char delimiter;
+    const char* recordName; // Kind of record, used in error messages
+
+public:
+    FieldReader(std::string_view record, const char* name, char separator = '|')
+        : rest(record), delimiter(separator), recordName(name) {
+        if (!rest.empty() && rest.back() == '\r') {
+            rest.remove_suffix(1);
         }
-        
-        return ss.str();
     }
 
-    // Static function to deserialize a retailer from a serialized string
-    static Retailer deserialize(const std::string& str) {
-        std::stringstream ss(str);
-        std::string item;
-        std::vector<std::string> parts;
-        
-        // Splitting the input string by '|' delimiter
-        while (std::getline(ss, item, '|')) {
-            parts.push_back(item);
+    // Function to check whether another field follows
+    bool hasMore() const { return !exhausted; }
+
+    // Function to read the next field as text
+    std::string_view text() {
+        if (exhausted) {
+            throw std::runtime_error(std::string("Invalid ") + recordName + " data format");
+        }
+        size_t separator = rest.find(delimiter);
+        std::string_view field = rest.substr(0, separator);
+        if (separator == std::string_view::npos) {
+            exhausted = true;
+        } else {
+            rest.remove_prefix(separator + 1);
         }
+        return field;
+    }
 
-        // Ensure the correct number of fields is present
-        if (parts.size() < 7) {
-            throw std::runtime_error("Invalid retailer data format");
+    // Function to convert a whole field to a number
+    template <typename T>
+    T toNumber(std::string_view field) const {
+        T value{};
+        const char* last = field.data() + field.size();
+        std::from_chars_result result = std::from_chars(field.data(), last, value);
+        if (result.ec != std::errc() || result.ptr != last) {
+            throw std::runtime_error(std::string("Invalid number '") + std::string(field) + "' in " + recordName + " data");
         }
+        return value;
+    }
 
-        // Extract and convert data from string format
-        int id = std::stoi(parts[0]);
-        std::string name = parts[1];
-        std::string location = parts[2];
-        double latitude = std::stod(parts[3]);
-        double longitude = std::stod(parts[4]);
-        double creditBalance = std::stod(parts[5]);
-        double annualCreditBalance = std::stod(parts[6]);
-        
-        Retailer retailer(id, name, location, latitude, longitude, creditBalance, annualCreditBalance);
-        
-        // Add product IDs if present
-        if (parts.size() > 7) {
-            std::stringstream productStream(parts[7]);
-            std::string productId;
-            
-            while (std::getline(productStream, productId, ',')) {
-                if (!productId.empty()) {
-                    retailer.addProduct(std::stoi(productId));
-                }
+    // Functions to read the next field as a number
+    int integer() { return toNumber<int>(text()); }
+    double number() { return toNumber<double>(text()); }
+
+    // Function to read a comma-separated ID list field, skipping empty entries
+    template <typename Handler>
+    void idList(Handler handler) {
+        FieldReader ids(text(), recordName, ',');
+        while (ids.hasMore()) {
+            std::string_view id = ids.text();
+            if (!id.empty()) {
+                handler(toNumber<int>(id));
             }
         }
-        
-        return retailer;
     }
 };
 
-// Transporter class
-class Transporter {
+// Utility function to call handler(line) for every non-blank line of a text buffer
+template <typename Handler>
+void forEachLine(std::string_view text, Handler handler) {
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        if (!line.empty() && line != "\r") {
+            handler(line);
+        }
+    }
+}
+
+// Utility function to write a temporary file with write(stream) and then move it over the
+// target, so a failed write never leaves a half-written target behind
+template <typename Producer>
+bool writeFileReplacingWith(const std::string& filename, Producer write) {
+    std::string tempName = filename + ".tmp";
+    {
+        std::ofstream file(tempName, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        write(file);
+        if (!file) {
+            return false;
+        }
+    }
+    std::remove(filename.c_str()); // rename() does not overwrite an existing file on Windows
+    return std::rename(tempName.c_str(), filename.c_str()) == 0;
+}
+
+// Utility function to replace a file with the contents of a buffer
+bool writeFileReplacing(const std::string& filename, const std::string& contents) {
+    return writeFileReplacingWith(filename, [&contents](std::ofstream& file) {
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    });
+}
+
+// MappedFile class
+// Read-only memory mapping of a whole file (mmap on POSIX, a file mapping on Windows)
+class MappedFile {
 private:
-    int id; // Unique identifier for the transporter
-    std::string name; // Name of the transporter
-    std::string transportType; // Type of transportation (e.g., ground, air)
-    double costPerKm; // Cost per kilometer for transportation
-    double maxCapacity;  // Maximum capacity of the transporter in kilograms
+    const char* mappedData = nullptr; // Start of the mapping, nullptr for empty or closed files
+    size_t mappedSize = 0; // Size of the mapping in bytes
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
 
 public:
-    // Constructor to initialize a Transporter object
-    Transporter(int transporterId, const std::string& transporterName, const std::string& type,
-                double perKmCost, double capacity)
-        : id(transporterId), name(transporterName), transportType(type), 
-          costPerKm(perKmCost), maxCapacity(capacity) {}
-
-    // Getter function to return the transporter ID
-    int getId() const { return id; }
-    
-    // Getter function to return the transporter name
-    std::string getName() const { return name; }
-    
-    // Getter function to return the type of transportation
-    std::string getTransportType() const { return transportType; }
-    
-    // Getter function to return the cost per kilometer for transportation
-    double getCostPerKm() const { return costPerKm; }
-    
-    // Getter function to return the maximum capacity of the transporter
-    double getMaxCapacity() const { return maxCapacity; }
+    MappedFile() = default;
+    ~MappedFile() { close(); }
 
-    // Function to check if the transporter can handle a given weight
-    bool canTransport(double weight) const {
-        return weight <= maxCapacity;
-    }
+    // Mappings are owned by exactly one object
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
 
-    // Function to calculate the transportation cost for a given distance
-    double calculateTransportCost(double distance) const {
-        return distance * costPerKm;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            mappedData = other.mappedData;
+            mappedSize = other.mappedSize;
+            other.mappedData = nullptr;
+            other.mappedSize = 0;
+#ifdef _WIN32
+            fileHandle = other.fileHandle;
+            mappingHandle = other.mappingHandle;
+            other.fileHandle = INVALID_HANDLE_VALUE;
+            other.mappingHandle = nullptr;
+#endif
+        }
+        return *this;
     }
 
-    // Function to generate a string representation of the transporter details
-    std::string toString() const {
-        std::stringstream ss;
-        ss << "Transporter ID: " << id << " | Name: " << name 
-           << " | Type: " << transportType
-           << " | Cost/km: RM" << std::fixed << std::setprecision(2) << costPerKm
-           << " | Max Capacity: " << maxCapacity << "kg";
-        return ss.str();
+    // Map a file read-only, returns false if it cannot be opened
+    bool open(const std::string& filename) {
+        close();
+#ifdef _WIN32
+        // Share write and delete access so the file can still be appended to or replaced
+        fileHandle = CreateFileA(filename.c_str(), GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            close();
+            return false;
+        }
+        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+        if (mappedSize == 0) {
+            return true; // Nothing to map
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mappingHandle) {
+            close();
+            return false;
+        }
+        mappedData = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (!mappedData) {
+            close();
+            return false;
+        }
+        return true;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        mappedSize = static_cast<size_t>(info.st_size);
+        if (mappedSize == 0) {
+            ::close(fd);
+            return true; // Nothing to map
+        }
+        void* address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps its own reference to the file
+        if (address == MAP_FAILED) {
+            mappedSize = 0;
+            return false;
+        }
+        mappedData = static_cast<const char*>(address);
+        return true;
+#endif
     }
 
-    // Function to generate data to be stored in a blockchain
-    std::string getBlockData() const {
-        std::stringstream ss;
-        ss << "Transporter ID: " << id << " | Transporter Name: " << name
-           << " | Transportation Type: " << transportType
-           << " | Cost/km: RM" << std::fixed << std::setprecision(2) << costPerKm
-           << " | Max Capacity: " << maxCapacity << "kg";
-        return ss.str();
+    // Release the mapping
+    void close() {
+#ifdef _WIN32
+        if (mappedData) {
+            UnmapViewOfFile(mappedData);
+        }
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+        }
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (mappedData) {
+            munmap(const_cast<char*>(mappedData), mappedSize);
+        }
+#endif
+        mappedData = nullptr;
+        mappedSize = 0;
     }
 
-    // Function to serialize transporter data into a string format for storage
+    const char* data() const { return mappedData; }
+    size_t size() const { return mappedSize; }
+};
+
+// BlockView struct
+// Zero-copy view of one block; the strings point into a mapped chain file or into a Block
+struct BlockView {
+    int blockNumber = 0;
+    std::string_view currentHash;
+    std::string_view previousHash;
+    std::string_view timestamp;
+    std::string_view data;
+
+    // Parse "number|currentHash|previousHash|timestamp|data" without copying.
+    // Only the first four '|' are separators; the data field may contain '|' itself.
+    static bool parse(std::string_view line, BlockView& view) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1); // Tolerate files written with CRLF line endings
+        }
+        std::string_view fields[4];
+        for (int i = 0; i < 4; ++i) {
+            size_t separator = line.find('|');
+            if (separator == std::string_view::npos) {
+                return false;
+            }
+            fields[i] = line.substr(0, separator);
+            line.remove_prefix(separator + 1);
+        }
+        const char* first = fields[0].data();
+        const char* last = first + fields[0].size();
+        std::from_chars_result result = std::from_chars(first, last, view.blockNumber);
+        if (result.ec != std::errc() || result.ptr != last) {
+            return false;
+        }
+        view.currentHash = fields[1];
+        view.previousHash = fields[2];
+        view.timestamp = fields[3];
+        view.data = line;
+        return true;
+    }
+
+    // Overloading the output stream operator to display block information
+    friend std::ostream& operator<<(std::ostream& os, const BlockView& block) {
+        os << "Block " << block.blockNumber << " | " 
+           << block.currentHash << " | " 
+           << block.previousHash << " | " 
+           << block.timestamp << " | " 
+           << block.data;
+        return os;
+    }
+};
+
+// Class representing a block in the blockchain
+class Block {
+private:
+    int blockNumber;         // Block index in the chain
+    std::string currentHash; // Hash of the current block
+    std::string previousHash;// Hash of the previous block
+    std::string timestamp;   // Time when the block was created
+    std::string data;        // Data stored in the block
+
+    // Constructor to restore a stored block as-is
+    Block(int blockNum, std::string_view hash, std::string_view prevHash,
+          std::string_view time, std::string_view blockData)
+        : blockNumber(blockNum), currentHash(hash), previousHash(prevHash),
+          timestamp(time), data(blockData) {}
+
+public:
+    // Constructor to initialize a block
+    Block(int blockNum, const std::string& prevHash, const std::string& blockData) 
+        : blockNumber(blockNum), previousHash(prevHash), data(blockData) {
+        timestamp = getCurrentTimestamp(); // Get and store current timestamp
+        currentHash = computeBlockHash(blockNumber, previousHash, timestamp, data); // Hash the block contents
+    }
+
+    // Getters for block attributes
+    std::string getCurrentHash() const { return currentHash; }
+    std::string getPreviousHash() const { return previousHash; }
+    int getBlockNumber() const { return blockNumber; }
+    std::string getTimestamp() const { return timestamp; }
+    std::string getData() const { return data; }
+
+    // View of this block's fields (valid while the block is alive)
+    BlockView view() const {
+        BlockView blockView;
+        blockView.blockNumber = blockNumber;
+        blockView.currentHash = currentHash;
+        blockView.previousHash = previousHash;
+        blockView.timestamp = timestamp;
+        blockView.data = data;
+        return blockView;
+    }
+
+    // Copy a viewed block into an owned Block
+    static Block fromView(const BlockView& blockView) {
+        return Block(blockView.blockNumber, blockView.currentHash, blockView.previousHash,
+                     blockView.timestamp, blockView.data);
+    }
+
+    // Overloading the output stream operator to display block information
+    friend std::ostream& operator<<(std::ostream& os, const Block& block) {
+        return os << block.view();
+    }
+
+    // Serialize block data into a string format for file storage
     std::string serialize() const {
         std::stringstream ss;
-        ss << id << "|" << name << "|" << transportType << "|" << costPerKm << "|" << maxCapacity;
+        ss << blockNumber << "|" << currentHash << "|" << previousHash << "|" << timestamp << "|" << data;
         return ss.str();
     }
 
-    // Static function to deserialize a transporter from a serialized string
-    static Transporter deserialize(const std::string& str) {
-        std::stringstream ss(str);
-        std::string item;
-        std::vector<std::string> parts;
-        
-        // Splitting the input string by '|' delimiter
-        while (std::getline(ss, item, '|')) {
-            parts.push_back(item);
+    // Deserialize a block from a stored string format
+    static Block deserialize(std::string_view str) {
+        BlockView blockView;
+        if (!BlockView::parse(str, blockView)) { // Validate correct format
+            throw std::runtime_error("Invalid block data format");
+        }
+        return fromView(blockView);
+    }
+};
+
+// ChainVerificationResult struct
+// Outcome of a full blockchain verification
+struct ChainVerificationResult {
+    bool valid = true;            // True if every block links to its predecessor and matches its hash
+    size_t firstInvalidBlock = 0; // Position of the earliest failing block when not valid
+    size_t hashedBlocks = 0;      // Blocks whose content hash was recomputed
+    size_t legacyBlocks = 0;      // Blocks with pre-SHA-256 hashes, checked for linkage only
+};
+
+// BlockArena class
+// Append-only storage for the fields of blocks added at run time. Records are packed into
+// large chunks that are never moved or freed while the arena lives, so views into the
+// arena stay valid as it grows and when the arena itself is moved.
+class BlockArena {
+private:
+    static constexpr size_t chunkSize = 1 << 16; // Bytes per chunk; larger records get their own chunk
+    
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor = nullptr; // Next free byte in the newest chunk
+    size_t remaining = 0;   // Free bytes left in the newest chunk
+
+public:
+    BlockArena() = default;
+    BlockArena(const BlockArena&) = delete;
+    BlockArena& operator=(const BlockArena&) = delete;
+    
+    BlockArena(BlockArena&& other) noexcept
+        : chunks(std::move(other.chunks)), cursor(other.cursor), remaining(other.remaining) {
+        other.cursor = nullptr;
+        other.remaining = 0;
+    }
+    
+    BlockArena& operator=(BlockArena&& other) noexcept {
+        if (this != &other) {
+            chunks = std::move(other.chunks);
+            cursor = other.cursor;
+            remaining = other.remaining;
+            other.chunks.clear();
+            other.cursor = nullptr;
+            other.remaining = 0;
         }
+        return *this;
+    }
 
-        // Ensure the correct number of fields is present
-        if (parts.size() < 5) {
-            throw std::runtime_error("Invalid transporter data format");
+    // Function to reserve bytes for one record
+    char* allocate(size_t bytes) {
+        if (bytes > remaining) {
+            size_t size = std::max(chunkSize, bytes);
+            chunks.emplace_back(new char[size]);
+            cursor = chunks.back().get();
+            remaining = size;
         }
+        char* record = cursor;
+        cursor += bytes;
+        remaining -= bytes;
+        return record;
+    }
 
-        // Extract and convert data from string format
-        int id = std::stoi(parts[0]);
-        std::string name = parts[1];
-        std::string transportType = parts[2];
-        double costPerKm = std::stod(parts[3]);
-        double maxCapacity = std::stod(parts[4]);
-        
-        return Transporter(id, name, transportType, costPerKm, maxCapacity);
+    // Function to copy a field into the arena and return a view of the copy
+    std::string_view store(char*& record, std::string_view field) {
+        std::memcpy(record, field.data(), field.size());
+        std::string_view copy(record, field.size());
+        record += field.size();
+        return copy;
+    }
+
+    // Function to release every record
+    void clear() {
+        chunks.clear();
+        cursor = nullptr;
+        remaining = 0;
     }
 };
 
-// SmartContract class (abstract base class)
-class SmartContract {
-public:
-    virtual ~SmartContract() = default; // Virtual destructor to allow proper cleanup of derived classes
-    virtual bool validate(const Transaction& transaction) const = 0; // Pure virtual function to validate a transaction
-    virtual std::string getDescription() const = 0; // Pure virtual function to get a description of the contract
+// Ledger segment compression
+// A small LZ77 codec in the style of LZ4: a sequence is a token byte (literal length in the
+// high nibble, match length - 4 in the low nibble), extra length bytes when a nibble is 15,
+// the literals, then a 2-byte match offset. The last sequence has literals only. Block lines
+// repeat the same field labels over and over, so this shrinks sealed segments several times.
+const size_t ledgerMinMatch = 4;
+const size_t ledgerMaxOffset = 65535;
+
+// Helper function to write a length that did not fit its nibble
+void appendLengthBytes(std::string& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+// Utility function to compress a buffer
+std::string ledgerCompress(std::string_view input) {
+    const size_t hashBits = 16;
+    std::vector<uint32_t> recent(size_t(1) << hashBits, 0); // 4-byte prefix hash -> position + 1
+    const char* data = input.data();
+    size_t size = input.size();
+    std::string out;
+    out.reserve(size / 2 + 16);
+    
+    auto emit = [&](size_t literalStart, size_t literalLength, size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength == 0 ? 0 : matchLength - ledgerMinMatch;
+        out.push_back(static_cast<char>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (literalLength >= 15) {
+            appendLengthBytes(out, literalLength - 15);
+        }
+        out.append(data + literalStart, literalLength);
+        if (matchLength == 0) {
+            return; // Last sequence
+        }
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (matchCode >= 15) {
+            appendLengthBytes(out, matchCode - 15);
+        }
+    };
+    
+    size_t literalStart = 0;
+    size_t position = 0;
+    while (position + ledgerMinMatch <= size) {
+        uint32_t prefix;
+        std::memcpy(&prefix, data + position, sizeof(prefix));
+        uint32_t hash = (prefix * 2654435761u) >> (32 - hashBits);
+        size_t candidate = recent[hash];
+        recent[hash] = static_cast<uint32_t>(position + 1);
+        if (candidate == 0 || position - (candidate - 1) > ledgerMaxOffset ||
+            std::memcmp(data + candidate - 1, data + position, ledgerMinMatch) != 0) {
+            position++;
+            continue;
+        }
+        candidate--;
+        size_t length = ledgerMinMatch;
+        while (position + length < size && data[candidate + length] == data[position + length]) {
+            length++;
+        }
+        emit(literalStart, position - literalStart, position - candidate, length);
+        position += length;
+        literalStart = position;
+    }
+    emit(literalStart, size - literalStart, 0, 0);
+    return out;
+}
+
+// Utility function to decompress a buffer of known original size. Returns false if the
+// input is malformed instead of reading or writing out of bounds.
+bool ledgerDecompress(std::string_view input, size_t rawSize, std::string& out) {
+    out.assign(rawSize, '\0');
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(input.data());
+    const unsigned char* inEnd = in + input.size();
+    size_t written = 0;
+    
+    auto readLength = [&](size_t length, size_t& value) {
+        value = length;
+        if (length != 15) {
+            return true;
+        }
+        for (;;) {
+            if (in == inEnd) {
+                return false;
+            }
+            unsigned char extra = *in++;
+            value += extra;
+            if (extra != 255) {
+                return true;
+            }
+        }
+    };
+    
+    while (in < inEnd) {
+        unsigned char token = *in++;
+        size_t literals;
+        if (!readLength(token >> 4, literals) || literals > static_cast<size_t>(inEnd - in) ||
+            literals > rawSize - written) {
+            return false;
+        }
+        std::memcpy(&out[written], in, literals);
+        in += literals;
+        written += literals;
+        if (in == inEnd) {
+            break; // Last sequence
+        }
+        if (inEnd - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t matchCode;
+        if (!readLength(token & 0x0f, matchCode)) {
+            return false;
+        }
+        size_t length = matchCode + ledgerMinMatch;
+        if (offset == 0 || offset > written || length > rawSize - written) {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i, ++written) {
+            out[written] = out[written - offset]; // Byte by byte, matches may overlap themselves
+        }
+    }
+    return written == rawSize;
+}
+
+// LedgerSegmentHeader struct
+// Fixed header at the start of a sealed ledger segment file, followed by the compressed
+// block lines (the same text lines as the active chain file)
+const char ledgerSegmentMagic[8] = {'M', 'A', 'D', 'S', 'S', 'E', 'G', '1'};
+
+struct LedgerSegmentHeader {
+    char magic[8];            // Always ledgerSegmentMagic
+    uint32_t version;         // Format version
+    uint32_t blockCount;      // Blocks in the segment
+    uint64_t firstBlock;      // Chain position of the first block
+    int64_t lastBlockNumber;  // Number of the last block
+    uint64_t rawBytes;        // Size of the block lines before compression
+    uint64_t compressedBytes; // Size of the compressed block lines
+    char previousAnchor[64];  // Anchor of the segment before, all '0' for the first segment
+    char anchor[64];          // SHA-256 hex of previousAnchor followed by the block hashes
 };
 
-// Transaction class
-class Transaction {
-private:
-    int id; // Unique identifier for the transaction
-    int supplierId; // ID of the supplier involved in the transaction
-    int retailerId; // ID of the retailer involved in the transaction
-    int productId; // ID of the product being transacted
-    int transporterId; // ID of the transporter handling the delivery
-    int quantity; // Quantity of the product being transacted
-    double productCost; // Cost of the product
-    double transportCost; // Cost of transportation
-    double totalCost; // Total cost of the transaction (product cost + transport cost)
-    std::string timestamp; // Timestamp of when the transaction was created
-    std::string status; // Status of the transaction ("Pending", "Completed", "Failed")
-    std::string orderType; // Type of order ("Seasonal", "Regular")
+static_assert(sizeof(LedgerSegmentHeader) == 176, "Ledger segment header layout changed");
 
-public:
-    // Constructor to initialize a Transaction object
-    Transaction(int transId, int sId, int rId, int pId, int tId, int qty)
-        : id(transId), supplierId(sId), retailerId(rId), productId(pId), 
-          transporterId(tId), quantity(qty), productCost(0), transportCost(0), totalCost(0) {
-        timestamp = getCurrentTimestamp(); // Set the current timestamp
-        status = "Pending"; // Set the initial status to "Pending"
-        orderType = "Regular"; // Set the default order type to "Regular"
+// Utility function to get the all-'0' hash standing for "nothing before": the previous hash
+// of the genesis block and the anchor before the first segment
+std::string_view zeroHash() {
+    static const std::string zeros(64, '0');
+    return zeros;
+}
+
+// First line of an active chain file once segments exist: "#segments|<count>|<last anchor>".
+// It records what was sealed, so a segment file that goes missing or turns up is noticed.
+const char ledgerRecordTag[] = "#segments|";
+
+// Utility function to compute the hash anchor that chains a segment to the one before it.
+// A content hash already covers its block, so only the hash is fed in; legacy and
+// unreadable lines are fed in whole.
+void ledgerSegmentAnchor(std::string_view previousAnchor, std::string_view blockLines, char* anchor) {
+    Sha256Stream stream;
+    stream.update(previousAnchor);
+    while (!blockLines.empty()) {
+        size_t end = blockLines.find('\n');
+        std::string_view line = blockLines.substr(0, end == std::string_view::npos ? blockLines.size() : end + 1);
+        blockLines.remove_prefix(line.size());
+        BlockView block;
+        if (BlockView::parse(line.substr(0, end == std::string_view::npos ? line.size() : line.size() - 1), block) &&
+            isContentHash(block.currentHash)) {
+            stream.update(block.currentHash);
+        } else {
+            stream.update(line);
+        }
     }
+    digestToHex(stream.finish(), anchor);
+}
 
-    // Getter function to return the transaction ID
-    int getId() const { return id; }
-    // Getter function to return the supplier ID
-    int getSupplierId() const { return supplierId; }
-    // Getter function to return the retailer ID
-    int getRetailerId() const { return retailerId; }
-    // Getter function to return the product ID
-    int getProductId() const { return productId; }
-    // Getter function to return the transporter ID
-    int getTransporterId() const { return transporterId; }
-    // Getter function to return the quantity of the product
-    int getQuantity() const { return quantity; }
-    // Getter function to return the product cost
-    double getProductCost() const { return productCost; }
-    // Getter function to return the transport cost
-    double getTransportCost() const { return transportCost; }
-    // Getter function to return the total cost of the transaction
-    double getTotalCost() const { return totalCost; }
-    // Getter function to return the timestamp of the transaction
-    std::string getTimestamp() const { return timestamp; }
-    // Getter function to return the status of the transaction
-    std::string getStatus() const { return status; }
-    // Getter function to return the order type
-    std::string getOrderType() const { return orderType; }
+// LedgerCursor class
+// One sealed segment decoded for one reader of the chain. Every reader (a display, each
+// verification thread) owns its cursor, so segments are decoded on demand without a shared
+// cache. Views read through a cursor stay valid until it moves to another segment.
+class LedgerCursor {
+private:
+    friend class Blockchain;
+    size_t segment = std::numeric_limits<size_t>::max(); // Segment held, none at first
+    std::string text; // Decompressed block lines
+    std::vector<size_t> lineStarts; // Offset of each block's line in text
+};
 
-    // Setter function to set the product cost
-    void setProductCost(double cost) { productCost = cost; }
-    // Setter function to set the transport cost
-    void setTransportCost(double cost) { transportCost = cost; }
-    // Function to calculate the total cost of the transaction
-    void calculateTotalCost() { totalCost = productCost + transportCost; }
-    // Setter function to set the status of the transaction
-    void setStatus(const std::string& newStatus) { status = newStatus; }
-    // Setter function to set the order type
-    void setOrderType(const std::string& type) { orderType = type; }
+// Blockchain class managing a chain of blocks
+// The chain is split into segments. Older blocks are sealed into immutable, compressed
+// segment files that carry a hash anchor chaining them to the segment before; only their
+// headers stay in memory and their blocks are decoded on demand through a LedgerCursor.
+// The active segment is the chain file itself: it stays in a read-only mapping with only
+// the offset of each block indexed, and blocks added after loading are copied once into an
+// arena and kept as views after the mapped ones. When the active segment grows past
+// segmentBlocks blocks or segmentBytes bytes, everything but the tip is sealed and evicted.
+class Blockchain {
+private:
+    static constexpr size_t segmentBlocks = 4096; // Active blocks that trigger sealing
+    static constexpr size_t segmentBytes = 8 << 20; // Active file size that triggers sealing
+    
+    // A sealed segment: where it is and what its header says
+    struct LedgerSegment {
+        std::string path;
+        LedgerSegmentHeader header;
+    };
+    
+    std::vector<LedgerSegment> segments; // Sealed segments, oldest first
+    size_t sealedBlocks = 0; // Blocks held in sealed segments
+    MappedFile mapping; // Mapping of the active segment file the chain was loaded from
+    std::vector<uint64_t> blockOffsets; // Offset of each mapped block's line in the mapping
+    BlockArena arena; // Fields of the blocks added after the mapped ones
+    std::vector<BlockView> chain; // Blocks added after the mapped ones, viewing the arena
+    BlockView tip; // Latest block, cached so appends never decode the mapping
+    size_t persistedBlocks = 0; // Number of leading blocks already written to disk
+    size_t activeFileBytes = 0; // Size of the active segment file
+    size_t recordedSegments = 0; // Segment count recorded in the active file
+    std::string recordedAnchor = std::string(64, '0'); // Last segment anchor recorded in the active file
 
-    // Function to generate a string representation of the transaction details
-    std::string toString() const {
-        std::stringstream ss;
-        ss << "Transaction ID: " << id 
-           << " | Supplier ID: " << supplierId
-           << " | Retailer ID: " << retailerId
-           << " | Product ID: " << productId
-           << " | Transporter ID: " << transporterId
-           << " | Quantity: " << quantity
-           << " | Product Cost: RM" << std::fixed << std::setprecision(2) << productCost
-           << " | Transport Cost: RM" << std::fixed << std::setprecision(2) << transportCost
-           << " | Total Cost: RM" << std::fixed << std::setprecision(2) << totalCost
-           << " | Timestamp: " << timestamp
-           << " | Status: " << status
-           << " | Order Type: " << orderType;
-        return ss.str();
+    // Helper function to hash a new block, copy it into the arena and link it as the tip
+    void appendBlock(int blockNumber, std::string_view previousHash, std::string_view data) {
+        std::string timestamp = getCurrentTimestamp();
+        char hash[64];
+        computeBlockHash(blockNumber, previousHash, timestamp, data, hash);
+        
+        char* record = arena.allocate(sizeof(hash) + previousHash.size() + timestamp.size() + data.size());
+        BlockView block;
+        block.blockNumber = blockNumber;
+        block.currentHash = arena.store(record, std::string_view(hash, sizeof(hash)));
+        block.previousHash = arena.store(record, previousHash);
+        block.timestamp = arena.store(record, timestamp);
+        block.data = arena.store(record, data);
+        chain.push_back(block);
+        tip = block;
     }
 
-    // Function to generate data to be stored in a blockchain
-    std::string getBlockData() const {
-        std::stringstream ss;
-        ss << "Transaction ID: " << id 
-           << " | Supplier ID: " << supplierId
-           << " | Retailer ID: " << retailerId
-           << " | Product ID: " << productId
-           << " | Quantity: " << quantity
-           << " | Total Cost: RM" << std::fixed << std::setprecision(2) << totalCost
-           << " | Timestamp: " << timestamp
-           << " | Status: " << status
-           << " | Order Type: " << orderType;
-        return ss.str();
+    // Helper function to decode the i-th mapped block
+    BlockView mappedView(size_t index) const {
+        const char* start = mapping.data() + blockOffsets[index];
+        size_t remaining = mapping.size() - static_cast<size_t>(blockOffsets[index]);
+        const void* newline = std::memchr(start, '\n', remaining);
+        size_t length = newline ? static_cast<size_t>(static_cast<const char*>(newline) - start) : remaining;
+        
+        BlockView blockView;
+        if (!BlockView::parse(std::string_view(start, length), blockView)) {
+            throw std::runtime_error("Invalid block data format");
+        }
+        return blockView;
     }
 
-    // Function to serialize transaction data into a string format for storage
-    std::string serialize() const {
-        std::stringstream ss;
-        ss << id << "|" << supplierId << "|" << retailerId << "|" << productId << "|" 
-           << transporterId << "|" << quantity << "|" << productCost << "|" 
-           << transportCost << "|" << totalCost << "|" << timestamp << "|" 
-           << status << "|" << orderType;
-        return ss.str();
+    // Helper function to get the file name of the index-th sealed segment of a chain file,
+    // e.g. blockchain.000003.seg for blockchain.dat
+    static std::string segmentPath(const std::string& filename, size_t index) {
+        std::filesystem::path base(filename);
+        base.replace_extension();
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%06zu.seg", index);
+        return base.string() + suffix;
+    }
+    
+    // Helper function to append a block as one line in the chain file format
+    static void appendBlockLine(std::string& out, const BlockView& block) {
+        char number[16];
+        auto converted = std::to_chars(number, number + sizeof(number), block.blockNumber);
+        out.append(number, converted.ptr - number);
+        out += '|';
+        out += block.currentHash;
+        out += '|';
+        out += block.previousHash;
+        out += '|';
+        out += block.timestamp;
+        out += '|';
+        out += block.data;
+        out += '\n';
     }
+    
+    // Helper function to append the segment record line for a count and last anchor
+    static void appendSegmentRecord(std::string& out, size_t count, std::string_view anchor) {
+        out += ledgerRecordTag;
+        out += std::to_string(count);
+        out += '|';
+        out += anchor;
+        out += '\n';
+    }
+    
+    // Helper function to get the anchor of the last sealed segment, all '0' if there is none
+    std::string_view lastAnchor() const {
+        return segments.empty() ? zeroHash() : std::string_view(segments.back().header.anchor, sizeof(segments.back().header.anchor));
+    }
+    
+    // Helper function to read the segment record at the start of the mapping, returns the
+    // bytes it takes (0 for files written before segments were recorded)
+    size_t readSegmentRecord() {
+        recordedSegments = 0;
+        recordedAnchor.assign(64, '0');
+        std::string_view text(mapping.data(), mapping.size());
+        const size_t tagLength = sizeof(ledgerRecordTag) - 1;
+        if (text.substr(0, tagLength) != ledgerRecordTag) {
+            return 0;
+        }
+        size_t end = text.find('\n');
+        std::string_view fields = text.substr(tagLength, end == std::string_view::npos ? std::string_view::npos : end - tagLength);
+        if (!fields.empty() && fields.back() == '\r') {
+            fields.remove_suffix(1);
+        }
+        size_t separator = fields.find('|');
+        size_t count = 0;
+        if (separator == std::string_view::npos ||
+            std::from_chars(fields.data(), fields.data() + separator, count).ptr != fields.data() + separator ||
+            fields.size() - separator - 1 != 64) {
+            recordedSegments = std::numeric_limits<size_t>::max(); // Unreadable record, matches nothing
+        } else {
+            recordedSegments = count;
+            recordedAnchor.assign(fields.substr(separator + 1));
+        }
+        return end == std::string_view::npos ? text.size() : end + 1;
+    }
+    
+    // Helper function to check the sealed segments against the record in the active file.
+    // A crash between writing a segment and rewriting the active file leaves one segment
+    // the record does not know about yet, chained to the recorded anchor.
+    bool segmentsMatchRecord() const {
+        if (segments.size() == recordedSegments) {
+            return lastAnchor() == recordedAnchor;
+        }
+        return recordedSegments != std::numeric_limits<size_t>::max() && segments.size() == recordedSegments + 1 &&
+               std::string_view(segments.back().header.previousAnchor, 64) == recordedAnchor;
+    }
+    
+    // Helper function to index the line starts of the mapped active segment, after the
+    // segment record
+    void indexMappedBlocks(size_t position = 0) {
+        blockOffsets.clear();
+        const char* data = mapping.data();
+        size_t fileSize = mapping.size();
+        while (position < fileSize) {
+            const void* newline = std::memchr(data + position, '\n', fileSize - position);
+            size_t end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : fileSize;
+            bool blankLine = end == position || (end == position + 1 && data[position] == '\r');
+            if (!blankLine) {
+                blockOffsets.push_back(position);
+            }
+            position = end + 1;
+        }
+    }
+    
+    // Helper function to view a block of the active segment
+    BlockView activeView(size_t index) const {
+        size_t offset = index - sealedBlocks;
+        if (offset < blockOffsets.size()) {
+            return mappedView(offset);
+        }
+        return chain[offset - blockOffsets.size()];
+    }
+    
+    // Helper function to decode a sealed segment into a cursor, checking its anchor
+    void loadSegment(size_t index, LedgerCursor& cursor) const {
+        const LedgerSegment& segment = segments[index];
+        cursor.segment = std::numeric_limits<size_t>::max();
+        std::vector<char> image;
+        if (!readWholeFile(segment.path, image) || image.size() < sizeof(LedgerSegmentHeader)) {
+            throw std::runtime_error("Ledger segment " + segment.path + " cannot be read");
+        }
+        LedgerSegmentHeader header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        std::string_view payload(image.data() + sizeof(header), image.size() - sizeof(header));
+        if (std::memcmp(&header, &segment.header, sizeof(header)) != 0 || payload.size() != header.compressedBytes ||
+            !ledgerDecompress(payload, static_cast<size_t>(header.rawBytes), cursor.text)) {
+            throw std::runtime_error("Ledger segment " + segment.path + " is corrupt");
+        }
+        
+        // The anchor covers the block hashes (legacy blocks in whole) and the anchor before,
+        // so a rewritten or reordered segment is caught even where block hashes are legacy ones
+        char anchor[64];
+        ledgerSegmentAnchor(std::string_view(header.previousAnchor, sizeof(header.previousAnchor)), cursor.text, anchor);
+        bool linked = index == 0 ? std::all_of(header.previousAnchor, header.previousAnchor + 64, [](char c) { return c == '0'; })
+                                 : std::memcmp(header.previousAnchor, segments[index - 1].header.anchor, 64) == 0;
+        if (std::memcmp(anchor, header.anchor, sizeof(anchor)) != 0 || !linked) {
+            throw std::runtime_error("Ledger segment " + segment.path + " does not match its anchor");
+        }
+        
+        cursor.lineStarts.clear();
+        for (size_t position = 0; position < cursor.text.size();) {
+            size_t end = cursor.text.find('\n', position);
+            if (end == std::string::npos) {
+                end = cursor.text.size();
+            }
+            cursor.lineStarts.push_back(position);
+            position = end + 1;
+        }
+        if (cursor.lineStarts.size() != header.blockCount) {
+            throw std::runtime_error("Ledger segment " + segment.path + " is corrupt");
+        }
+        cursor.segment = index;
+    }
+    
+    // Helper function to find the sealed segment holding a chain position
+    size_t segmentOf(size_t index) const {
+        auto after = std::upper_bound(segments.begin(), segments.end(), index,
+            [](size_t position, const LedgerSegment& segment) { return position < segment.header.firstBlock; });
+        return static_cast<size_t>(after - segments.begin()) - 1;
+    }
+    
+    // Helper function to view a block of a sealed segment through a cursor
+    BlockView sealedView(size_t index, LedgerCursor& cursor) const {
+        size_t segmentIndex = segmentOf(index);
+        if (cursor.segment != segmentIndex) {
+            loadSegment(segmentIndex, cursor);
+        }
+        size_t line = index - static_cast<size_t>(segments[segmentIndex].header.firstBlock);
+        size_t start = cursor.lineStarts[line];
+        size_t end = line + 1 < cursor.lineStarts.size() ? cursor.lineStarts[line + 1] - 1 : cursor.text.size();
+        if (end > start && cursor.text[end - 1] == '\n') {
+            end--; // The last line keeps its newline
+        }
+        BlockView blockView;
+        if (!BlockView::parse(std::string_view(cursor.text).substr(start, end - start), blockView)) {
+            throw std::runtime_error("Invalid block data format");
+        }
+        return blockView;
+    }
+    
+    // Helper function to seal every active block but the tip into a new segment file, then
+    // rewrite the active file with just the tip and map it again. The segment is written
+    // first, so a crash in between leaves blocks in both places, and loading skips the copy.
+    bool sealSegment(const std::string& filename) {
+        size_t last = size() - 1;
+        std::string blockLines;
+        blockLines.reserve(activeFileBytes);
+        for (size_t i = sealedBlocks; i < last; ++i) {
+            appendBlockLine(blockLines, activeView(i));
+        }
+        LedgerSegmentHeader header = {};
+        std::memcpy(header.magic, ledgerSegmentMagic, sizeof(ledgerSegmentMagic));
+        header.version = 1;
+        header.blockCount = static_cast<uint32_t>(last - sealedBlocks);
+        header.firstBlock = sealedBlocks;
+        header.lastBlockNumber = activeView(last - 1).blockNumber;
+        header.rawBytes = blockLines.size();
+        if (segments.empty()) {
+            std::memset(header.previousAnchor, '0', sizeof(header.previousAnchor));
+        } else {
+            std::memcpy(header.previousAnchor, segments.back().header.anchor, sizeof(header.previousAnchor));
+        }
+        ledgerSegmentAnchor(std::string_view(header.previousAnchor, sizeof(header.previousAnchor)), blockLines, header.anchor);
+        std::string compressed = ledgerCompress(blockLines);
+        header.compressedBytes = compressed.size();
+        
+        std::string activeLines;
+        appendSegmentRecord(activeLines, segments.size() + 1, std::string_view(header.anchor, sizeof(header.anchor)));
+        appendBlockLine(activeLines, tip);
+        
+        std::string image(reinterpret_cast<const char*>(&header), sizeof(header));
+        image += compressed;
+        std::string path = segmentPath(filename, segments.size());
+        MappedFile active;
+        if (!writeFileReplacing(path, image) || !writeFileReplacing(filename, activeLines) || !active.open(filename)) {
+            std::cerr << "Could not seal ledger segment: " << path << std::endl;
+            return false;
+        }
+        
+        // Evict the sealed blocks: only the tip stays, in the new mapping
+        segments.push_back({path, header});
+        sealedBlocks += header.blockCount;
+        chain.clear();
+        arena.clear();
+        mapping = std::move(active);
+        indexMappedBlocks(readSegmentRecord());
+        tip = mappedView(0);
+        activeFileBytes = mapping.size();
+        persistedBlocks = size();
+        return true;
+    }
+    
+    // Helper function to delete sealed segment files of an earlier chain, from index on
+    static void removeSegmentFiles(const std::string& filename, size_t index) {
+        for (; fileExists(segmentPath(filename, index)); ++index) {
+            std::remove(segmentPath(filename, index).c_str());
+        }
+    }
+
+    // Where a range of blocks moves from legacy hashes to content hashes. Legacy hashes
+    // are only accepted before the first content hash of the chain.
+    struct HashBoundary {
+        size_t firstContent = SIZE_MAX;    // First content-hashed block of the range
+        size_t firstLegacy = SIZE_MAX;     // First legacy block of the range
+        size_t firstLateLegacy = SIZE_MAX; // First legacy block after firstContent
+    };
+    
+    // Helper function to verify the blocks in [begin, end) on the calling thread
+    void verifyBlocks(size_t begin, size_t end, ChainVerificationResult& result, HashBoundary& boundary) const {
+        LedgerCursor cursor; // Sealed segments of this range, decoded one at a time
+        std::string inputs[sha256Lanes]; // Hash inputs of the blocks waiting for a free lane
+        std::string_view inputViews[sha256Lanes];
+        std::string expected[sha256Lanes]; // Copied, the cursor may move on before they are hashed
+        size_t positions[sha256Lanes];
+        Sha256Digest digests[sha256Lanes];
+        size_t queued = 0;
+        
+        auto markInvalid = [&result](size_t position) {
+            if (result.valid || position < result.firstInvalidBlock) {
+                result.valid = false;
+                result.firstInvalidBlock = position;
+            }
+        };
+        auto hashQueued = [&]() {
+            for (size_t lane = 0; lane < queued; ++lane) {
+                inputViews[lane] = inputs[lane];
+            }
+            sha256MultiBuffer(inputViews, queued, digests);
+            for (size_t lane = 0; lane < queued; ++lane) {
+                if (digestToHex(digests[lane]) != expected[lane]) {
+                    markInvalid(positions[lane]);
+                }
+            }
+            result.hashedBlocks += queued;
+            queued = 0;
+        };
+        
+        size_t position = begin;
+        try {
+            std::string previousHash;
+            if (begin > 0) {
+                previousHash = blockAt(begin - 1, cursor).currentHash;
+            }
+            for (; position < end; ++position) {
+                BlockView block = blockAt(position, cursor);
+                if (position > 0 && block.previousHash != previousHash) { // Verify hash linkage
+                    markInvalid(position);
+                }
+                // The chain must start at a genesis block, not part way through. Legacy genesis
+                // blocks were given a random previous hash, so only a content-hashed one must
+                // carry the all-zero hash.
+                if (position == 0 && (block.blockNumber != 0 ||
+                                      (isContentHash(block.currentHash) && block.previousHash != zeroHash()))) {
+                    markInvalid(0);
+                }
+                previousHash = block.currentHash;
+                
+                if (!isContentHash(block.currentHash)) {
+                    result.legacyBlocks++; // Written before content hashing, linkage only
+                    if (boundary.firstLegacy == SIZE_MAX) {
+                        boundary.firstLegacy = position;
+                    }
+                    if (boundary.firstContent != SIZE_MAX && boundary.firstLateLegacy == SIZE_MAX) {
+                        boundary.firstLateLegacy = position;
+                    }
+                    continue;
+                }
+                if (boundary.firstContent == SIZE_MAX) {
+                    boundary.firstContent = position;
+                }
+                blockHashInput(block.blockNumber, block.previousHash, block.timestamp, block.data, inputs[queued]);
+                expected[queued] = block.currentHash;
+                positions[queued] = position;
+                if (++queued == sha256Lanes) {
+                    hashQueued();
+                }
+            }
+            hashQueued();
+        }
+        catch (const std::exception& e) {
+            markInvalid(position); // A block that cannot be decoded is treated as tampering
+        }
+    }
+    
+public:
+    // Constructor to initialize blockchain with a genesis block
+    Blockchain() {
+        createGenesisBlock(); // Create the first block in the blockchain
+    }
+
+    // Blocks view the blockchain's own mapping and arena, so a chain can be moved but not copied
+    Blockchain(const Blockchain&) = delete;
+    Blockchain& operator=(const Blockchain&) = delete;
+    Blockchain(Blockchain&&) = default;
+    Blockchain& operator=(Blockchain&&) = default;
+
+    // Function to create the genesis block (first block in the chain)
+    void createGenesisBlock() {
+        std::string genesisHash(64, '0'); // The genesis block has no predecessor
+        appendBlock(0, genesisHash, "Genesis Block"); // Add genesis block to chain
+    }
+
+    // Function to view the block at a position in the chain, decoding it if it is mapped.
+    // Blocks of sealed segments are decoded into the caller's cursor.
+    BlockView blockAt(size_t index, LedgerCursor& cursor) const {
+        if (index < sealedBlocks) {
+            return sealedView(index, cursor);
+        }
+        return activeView(index);
+    }
+
+    // Function to get the latest block in the chain (valid until the chain is reloaded or reset)
+    const BlockView& getLatestBlock() const {
+        if (size() == 0) { // Check if blockchain is empty
+            throw std::runtime_error("Blockchain is empty");
+        }
+        return tip;
+    }
+
+    // Function to add a new block to the chain. The data is hashed where it lies and
+    // copied once, into the arena.
+    void addBlock(std::string_view data) {
+        try {
+            const BlockView& latestBlock = getLatestBlock(); // Get last block
+            appendBlock(latestBlock.blockNumber + 1, latestBlock.currentHash, data); // Link the new block
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error adding block: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+    // Function to check blockchain integrity
+    bool isChainValid() const {
+        return verify().valid;
+    }
+
+    // Verify hash linkage and recompute every block's content hash.
+    // The chain is split across the available cores and each core hashes sha256Lanes
+    // blocks at a time with the multi-buffer kernel.
+    ChainVerificationResult verify(unsigned threadCount = 0) const {
+        size_t blockCount = size();
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const size_t minBlocksPerThread = 1024; // Below this, starting threads costs more than it saves
+        size_t workers = std::max<size_t>(1, std::min<size_t>(threadCount, blockCount / minBlocksPerThread));
+        
+        std::vector<ChainVerificationResult> partial(workers);
+        std::vector<HashBoundary> boundaries(workers);
+        auto verifyRange = [this, blockCount, workers, &partial, &boundaries](size_t worker) {
+            size_t begin = blockCount * worker / workers;
+            size_t end = blockCount * (worker + 1) / workers;
+            verifyBlocks(begin, end, partial[worker], boundaries[worker]);
+        };
+        
+        if (workers == 1) {
+            verifyRange(0);
+        } else {
+            std::vector<std::thread> threads;
+            for (size_t worker = 0; worker < workers; ++worker) {
+                threads.emplace_back(verifyRange, worker);
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+        
+        // Merge per-thread results, reporting the earliest bad block
+        ChainVerificationResult result;
+        for (const auto& part : partial) {
+            result.hashedBlocks += part.hashedBlocks;
+            result.legacyBlocks += part.legacyBlocks;
+            if (!part.valid && (result.valid || part.firstInvalidBlock < result.firstInvalidBlock)) {
+                result.valid = false;
+                result.firstInvalidBlock = part.firstInvalidBlock;
+            }
+        }
+        
+        // A legacy hash after a content hash is not an old block, it is one whose hash was
+        // replaced to escape the content check
+        bool contentSeen = false;
+        for (const auto& boundary : boundaries) {
+            size_t lateLegacy = contentSeen ? boundary.firstLegacy : boundary.firstLateLegacy;
+            if (lateLegacy != SIZE_MAX) {
+                if (result.valid || lateLegacy < result.firstInvalidBlock) {
+                    result.valid = false;
+                    result.firstInvalidBlock = lateLegacy;
+                }
+                break;
+            }
+            contentSeen = contentSeen || boundary.firstContent != SIZE_MAX;
+        }
+        
+        // Segments that chain up among themselves can still have been deleted or added
+        // wholesale, which only the record in the active file tells
+        if (!segmentsMatchRecord()) {
+            size_t position = segments.size() < recordedSegments || segments.empty() ? sealedBlocks
+                                                                                      : static_cast<size_t>(segments.back().header.firstBlock);
+            if (result.valid || position < result.firstInvalidBlock) {
+                result.valid = false;
+                result.firstInvalidBlock = position;
+            }
+        }
+        return result;
+    }
+
+    // Display all blocks in the blockchain, decoding one sealed segment at a time
+    void displayChain() const {
+        LedgerCursor cursor;
+        for (size_t i = 0; i < size(); ++i) {
+            try {
+                std::cout << blockAt(i, cursor) << std::endl;
+            }
+            catch (const std::exception& e) {
+                if (i < sealedBlocks) {
+                    // The whole segment fails together, so report it once and move past it
+                    const LedgerSegmentHeader& header = segments[segmentOf(i)].header;
+                    size_t last = static_cast<size_t>(header.firstBlock + header.blockCount) - 1;
+                    std::cout << "Blocks at positions " << i << "-" << last << " are unreadable: " << e.what() << std::endl;
+                    i = last;
+                } else {
+                    std::cout << "Block at position " << i << " is unreadable: " << e.what() << std::endl;
+                }
+            }
+            std::cout << "--------------------------------------" << std::endl;
+        }
+    }
+
+    // Function to get the active segment in the chain file format, led by the segment
+    // record once there are sealed segments
+    std::string activeSegmentLines() const {
+        std::string contents;
+        if (!segments.empty()) {
+            appendSegmentRecord(contents, segments.size(), lastAnchor());
+        }
+        for (size_t i = sealedBlocks; i < size(); ++i) {
+            appendBlockLine(contents, activeView(i));
+        }
+        return contents;
+    }
+
+    // Save the active segment to the chain file (sealed segments are already on disk)
+    bool saveToFile(const std::string& filename) const {
+        // Build the new contents first: the target may be the file this chain is mapped from
+        std::string contents = activeSegmentLines();
+        if (!writeFileReplacing(filename, contents)) {
+            std::cerr << "Could not open file for writing: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Append blocks added since the last save to the chain file, sealing a segment once the
+    // active one is full. The file is rewritten from scratch when it does not hold a prefix
+    // of this chain (for example after the chain was recreated by a reset), and segments
+    // left over from the earlier chain are deleted.
+    bool appendToFile(const std::string& filename) {
+        if (persistedBlocks == 0 || persistedBlocks > size()) {
+            std::string contents = activeSegmentLines();
+            if (!writeFileReplacing(filename, contents)) {
+                std::cerr << "Could not open file for writing: " << filename << std::endl;
+                return false;
+            }
+            removeSegmentFiles(filename, segments.size());
+            persistedBlocks = size();
+            activeFileBytes = contents.size();
+            recordedSegments = segments.size();
+            recordedAnchor.assign(lastAnchor());
+        } else if (persistedBlocks < size()) {
+            std::string lines;
+            for (size_t i = persistedBlocks; i < size(); ++i) {
+                appendBlockLine(lines, activeView(i));
+            }
+            std::ofstream file(filename, std::ios::binary | std::ios::app);
+            if (!file.is_open()) {
+                std::cerr << "Could not open file for writing: " << filename << std::endl;
+                return false;
+            }
+            file.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+            file.flush();
+            if (!file) {
+                return false;
+            }
+            persistedBlocks = size();
+            activeFileBytes += lines.size();
+        }
+        
+        size_t activeBlocks = size() - sealedBlocks;
+        if (activeBlocks > 1 && (activeBlocks > segmentBlocks || activeFileBytes > segmentBytes)) {
+            return sealSegment(filename);
+        }
+        return true;
+    }
+
+    // Load blockchain from file: read the headers of the sealed segments, then map the
+    // active segment and index where each of its blocks starts
+    bool loadFromFile(const std::string& filename) {
+        MappedFile file;
+        if (!file.open(filename)) {
+            std::cerr << "Could not open file for reading: " << filename << std::endl;
+            return false;
+        }
+
+        chain.clear(); // Clear existing chain
+        arena.clear();
+        segments.clear();
+        sealedBlocks = 0;
+        mapping = std::move(file);
+        activeFileBytes = mapping.size();
+        size_t recordBytes = readSegmentRecord();
+        
+        // Segments are numbered from 0; each must start where the one before ended
+        for (size_t index = 0;; ++index) {
+            LedgerSegment segment{segmentPath(filename, index), LedgerSegmentHeader()};
+            std::ifstream segmentFile(segment.path, std::ios::binary);
+            if (!segmentFile.is_open()) {
+                if (index < recordedSegments && recordedSegments != std::numeric_limits<size_t>::max()) {
+                    std::cerr << "Ledger segment " << segment.path << " is missing" << std::endl;
+                }
+                break;
+            }
+            bool readable = static_cast<bool>(segmentFile.read(reinterpret_cast<char*>(&segment.header), sizeof(segment.header))) &&
+                            std::memcmp(segment.header.magic, ledgerSegmentMagic, sizeof(ledgerSegmentMagic)) == 0 &&
+                            segment.header.version == 1 && segment.header.firstBlock == sealedBlocks;
+            if (!readable) {
+                std::cerr << "Ignoring unreadable ledger segment " << segment.path << " and any after it" << std::endl;
+                break;
+            }
+            sealedBlocks += segment.header.blockCount;
+            segments.push_back(std::move(segment));
+        }
+        
+        // One pass over the mapping to find line starts; blocks are parsed only when viewed
+        indexMappedBlocks(recordBytes);
+        
+        // Blocks already sealed are still at the front of the active file if a crash hit
+        // between writing a segment and rewriting the active file
+        if (!segments.empty()) {
+            int64_t lastSealed = segments.back().header.lastBlockNumber;
+            size_t sealedCopies = 0;
+            try {
+                while (sealedCopies < blockOffsets.size() && mappedView(sealedCopies).blockNumber <= lastSealed) {
+                    sealedCopies++;
+                }
+            }
+            catch (const std::exception& e) {
+                // An unreadable line is left for verification to report
+            }
+            blockOffsets.erase(blockOffsets.begin(), blockOffsets.begin() + sealedCopies);
+            if (blockOffsets.empty()) {
+                std::cerr << "The active ledger segment " << filename << " holds no blocks" << std::endl;
+                segments.clear();
+                sealedBlocks = 0;
+                mapping.close();
+                return false;
+            }
+        }
+        
+        // The tip is needed for the next append, so check it decodes now
+        if (!blockOffsets.empty()) {
+            try {
+                tip = mappedView(blockOffsets.size() - 1);
+            }
+            catch (const std::exception& e) {
+                blockOffsets.clear();
+                segments.clear();
+                sealedBlocks = 0;
+                mapping.close();
+                return false;
+            }
+        }
+        
+        persistedBlocks = size(); // Everything loaded is already on disk
+        if (blockOffsets.empty()) {
+            mapping.close();
+            createGenesisBlock();
+        }
+        return true;
+    }
+    size_t size() const {
+        return sealedBlocks + blockOffsets.size() + chain.size();
+    }
+
+    // Function to get the number of sealed segments
+    size_t segmentCount() const {
+        return segments.size();
+    }
+};
+
+// MpscRing class
+// Bounded lock-free ring for many producers and one consumer. Each cell carries a sequence
+// number telling whether it is free for the producer at that position or filled for the
+// consumer, so a push claims a position with one compare-and-swap and never takes a lock.
+template <typename T>
+class MpscRing {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePosition; // Next position producers claim
+    alignas(64) size_t dequeuePosition = 0; // Next position the consumer reads, consumer only
+
+public:
+    // Constructor to create a ring with capacity rounded up to a power of two
+    explicit MpscRing(size_t capacity) : enqueuePosition(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Try to add a value, returns false if the ring is full
+    bool tryPush(T&& value) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break; // Position claimed
+                }
+            } else if (difference < 0) {
+                return false; // The consumer has not freed this cell yet
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed); // Another producer took it
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release); // Hand the cell to the consumer
+        return true;
+    }
+
+    // Try to take the oldest value, returns false if the ring is empty. Consumer thread only.
+    bool tryPop(T& value) {
+        Cell* cell = &cells[dequeuePosition & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePosition + 1) < 0) {
+            return false;
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(dequeuePosition + mask + 1, std::memory_order_release); // Free it for a later lap
+        ++dequeuePosition;
+        return true;
+    }
+};
+
+// ChainWriter class
+// Moves block production off the callers' path. Producers submit block payloads through a
+// lock-free ring and return immediately; one writer thread assigns block numbers, links
+// hashes and appends them to the chain. Disk writes are group commits: every flush()
+// waiting at the same moment is satisfied by a single append to the chain file.
+class ChainWriter {
+private:
+    static const size_t ringCapacity = 4096; // Payloads that can wait before producers back off
+    
+    Blockchain& blockchain;
+    std::string filename; // Chain file written by flush()
+    MpscRing<std::string> ring;
+    std::thread worker;
+    std::mutex chainMutex; // Held by the writer while it links blocks, and by readers of the chain
+    
+    std::atomic<uint64_t> submitted; // Payloads handed to submit so far
+    std::atomic<bool> writerWaiting; // Set while the writer may be about to sleep
+    std::mutex stateMutex; // Guards everything below
+    std::condition_variable wake; // Wakes the writer
+    std::condition_variable progress; // Wakes threads waiting in settle() or flush()
+    uint64_t applied = 0; // Payloads linked into the chain
+    uint64_t durable = 0; // Payloads written to the chain file
+    uint64_t flushRequested = 0; // Tickets handed to flush() calls so far
+    uint64_t flushServed = 0; // Highest ticket whose group commit has completed
+    bool lastFlushOk = true;
+    bool stopping = false;
+
+    // Helper function for the writer thread: link every payload already in the ring
+    void drain() {
+        std::string payload;
+        uint64_t count = 0;
+        {
+            std::lock_guard<std::mutex> chainLock(chainMutex);
+            while (ring.tryPop(payload)) {
+                try {
+                    ScopedTimer appendTimer(MetricId::BlockAppend);
+                    blockchain.addBlock(payload);
+                }
+                catch (const std::exception& e) {
+                    // addBlock has already reported the error; keep serving the other producers
+                }
+                count++;
+            }
+        }
+        if (count > 0) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            applied += count;
+            progress.notify_all();
+        }
+    }
+
+    // Writer thread body
+    void run() {
+        for (;;) {
+            bool commit;
+            bool exiting;
+            uint64_t ticket; // Newest flush ticket this pass serves
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                writerWaiting.store(true);
+                wake.wait(lock, [this]() {
+                    return applied < submitted.load() || flushRequested > flushServed || stopping;
+                });
+                writerWaiting.store(false);
+                ticket = flushRequested;
+                commit = ticket > flushServed;
+                exiting = stopping;
+            }
+            
+            // A submit reserves its ticket before pushing, so keep draining until every
+            // reserved payload has arrived. Taken after the flush ticket: every flush up to
+            // that ticket counted its payloads before taking it, so all of them are in target.
+            // A flush arriving after this point waits for the next commit.
+            uint64_t target = submitted.load();
+            for (;;) {
+                drain();
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (applied >= target) {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+            
+            if (commit) {
+                bool ok;
+                {
+                    std::lock_guard<std::mutex> chainLock(chainMutex);
+                    ScopedTimer persistTimer(MetricId::ChainPersist);
+                    ok = blockchain.appendToFile(filename); // One write for every waiting flush
+                }
+                std::lock_guard<std::mutex> lock(stateMutex);
+                lastFlushOk = ok;
+                if (ok) {
+                    durable = std::max(durable, target);
+                }
+                flushServed = std::max(flushServed, ticket);
+                progress.notify_all();
+            }
+            if (exiting) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (applied >= submitted.load()) {
+                    return;
+                }
+            }
+        }
+    }
+
+public:
+    // Constructor to attach the writer to a chain and start the writer thread
+    ChainWriter(Blockchain& chain, const std::string& chainFile)
+        : blockchain(chain), filename(chainFile), ring(ringCapacity), submitted(0), writerWaiting(false) {
+        worker = std::thread(&ChainWriter::run, this);
+    }
+
+    ChainWriter(const ChainWriter&) = delete;
+    ChainWriter& operator=(const ChainWriter&) = delete;
+
+    // Destructor to link any queued payloads and stop the writer thread
+    ~ChainWriter() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+            wake.notify_one();
+        }
+        worker.join();
+    }
+
+    // Queue a block payload. Safe to call from any number of threads; blocks are linked
+    // in the order their payloads enter the ring.
+    void submit(std::string payload) {
+        submitted.fetch_add(1); // Reserve a ticket first so waiters account for this payload
+        while (!ring.tryPush(std::move(payload))) {
+            std::this_thread::yield(); // Ring full, let the writer catch up
+        }
+        if (writerWaiting.load()) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            wake.notify_one();
+        }
+    }
+
+    // Wait until every payload submitted so far is linked into the chain, and return holding
+    // the chain lock so the caller can read, save or replace the chain
+    std::unique_lock<std::mutex> settle() {
+        uint64_t target = submitted.load();
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wake.notify_one();
+            progress.wait(lock, [this, target]() { return applied >= target; });
+        }
+        return std::unique_lock<std::mutex>(chainMutex);
+    }
+
+    // Barrier: wait until every payload submitted so far is linked and written to the chain
+    // file. Returns false if the write failed.
+    bool flush() {
+        uint64_t mine = submitted.load(); // Payloads this flush must see on disk
+        std::unique_lock<std::mutex> lock(stateMutex);
+        uint64_t ticket = ++flushRequested;
+        wake.notify_one();
+        progress.wait(lock, [this, ticket]() { return flushServed >= ticket; });
+        return lastFlushOk && durable >= mine;
+    }
+};
+
+// Product class
+class Product {
+    private:
+        int id; // Unique identifier for the product
+        std::string name; // Name of the product
+        double price; // Price of the product
+        int stock; // Stock quantity of the product
+    
+    public:
+        // Constructor to initialize a Product object
+        Product(int productId, const std::string& productName, double productPrice, int productStock)
+            : id(productId), name(productName), price(productPrice), stock(productStock) {}
+    
+        // Getter function to return the product ID
+        int getId() const { return id; }
+    
+        // Getter function to return the product name
+        std::string getName() const { return name; }
+    
+        // Getter function to return the product price
+        double getPrice() const { return price; }
+    
+        // Getter function to return the stock quantity
+        int getStock() const { return stock; }
+    
+        // Function to update the stock quantity by adding or subtracting a given amount
+        void updateStock(int quantity) {
+            stock += quantity;
+        }
+    
+        // Function to check if the stock is sufficient for a given quantity
+        bool hasEnoughStock(int quantity) const {
+            return stock >= quantity;
+        }
+    
+        // Function to generate a string representation of the product details
+        std::string toString() const {
+            std::stringstream ss;
+            ss << "Product ID: " << id << " | Name: " << name 
+               << " | Price: RM" << std::fixed << std::setprecision(2) << price 
+               << " | Stock: " << stock;
+            return ss.str();
+        }
+    
+        // Function to serialize product data into a string format for storage
+        std::string serialize() const {
+            std::stringstream ss;
+            ss << id << "|" << name << "|" << price << "|" << stock;
+            return ss.str();
+        }
+    
+        // Static function to deserialize a product from a serialized string
+        static Product deserialize(std::string_view str) {
+            FieldReader fields(str, "product");
+            int id = fields.integer();
+            std::string name(fields.text());
+            double price = fields.number();
+            int stock = fields.integer();
+            return Product(id, name, price, stock);
+        }
+    };
+    
+    // Supplier class
+    class Supplier {
+    private:
+        int id; // Unique identifier for the supplier
+        std::string name; // Supplier name
+        std::string location; // Location of the supplier
+        std::string branch; // Branch name of the supplier
+        double latitude; // Latitude coordinate of the supplier location
+        double longitude; // Longitude coordinate of the supplier location
+        std::vector<int> productIds; // List of product IDs supplied
+    
+    public:
+        // Constructor to initialize a Supplier object
+        Supplier(int supplierId, const std::string& supplierName, const std::string& supplierLocation, 
+                 const std::string& supplierBranch, double lat, double lon)
+            : id(supplierId), name(supplierName), location(supplierLocation), 
+              branch(supplierBranch), latitude(lat), longitude(lon) {}
+    
+        // Getter function to return the supplier ID
+        int getId() const { return id; }
+    
+        // Getter function to return the supplier name
+        std::string getName() const { return name; }
+    
+        // Getter function to return the supplier location
+        std::string getLocation() const { return location; }
+    
+        // Getter function to return the supplier branch
+        std::string getBranch() const { return branch; }
+    
+        // Getter function to return the latitude of the supplier location
+        double getLatitude() const { return latitude; }
+    
+        // Getter function to return the longitude of the supplier location
+        double getLongitude() const { return longitude; }
+        
+        // Function to add a product ID to the supplier's list of products
+        void addProduct(int productId) {
+            productIds.push_back(productId);
+        }
+    
+        // Getter function to retrieve the list of product IDs
+        const std::vector<int>& getProductIds() const {
+            return productIds;
+        }
+    
+        // Function to generate a string representation of supplier details
+        std::string toString() const {
+            std::stringstream ss;
+            ss << "Supplier ID: " << id << " | Name: " << name 
+               << " | Location: " << location << " | Branch: " << branch;
+            return ss.str();
+        }
+    
+        // Function to generate data to be stored in a blockchain
+        std::string getBlockData() const {
+            std::stringstream ss;
+            ss << "Supplier ID: " << id << " | Supplier Name: " << name
+               << " | Location: " << location << " | Branch: " << branch;
+            return ss.str();
+        }
+    
+        // Function to serialize supplier data into a string format for storage
+        std::string serialize() const {
+            std::stringstream ss;
+            ss << id << "|" << name << "|" << location << "|" << branch << "|" << latitude << "|" << longitude;
+            
+            // Add product IDs to the serialized string
+            ss << "|";
+            for (size_t i = 0; i < productIds.size(); ++i) {
+                ss << productIds[i];
+                if (i < productIds.size() - 1) {
+                    ss << ",";
+                }
+            }
+            
+            return ss.str();
+        }
+    
+        // Static function to deserialize a supplier from a serialized string
+        static Supplier deserialize(std::string_view str) {
+            FieldReader fields(str, "supplier");
+            int id = fields.integer();
+            std::string name(fields.text());
+            std::string location(fields.text());
+            std::string branch(fields.text());
+            double latitude = fields.number();
+            double longitude = fields.number();
+            
+            Supplier supplier(id, name, location, branch, latitude, longitude);
+            
+            // Add product IDs if present
+            if (fields.hasMore()) {
+                fields.idList([&supplier](int productId) { supplier.addProduct(productId); });
+            }
+            return supplier;
+        }
+    };
+    
+// Retailer class
+class Retailer {
+private:
+    int id; // Unique identifier for the retailer
+    std::string name; // Name of the retailer
+    std::string location; // Location of the retailer
+    double latitude; // Latitude coordinate of the retailer's location
+    double longitude; // Longitude coordinate of the retailer's location
+    double creditBalance; // Current credit balance of the retailer
+    double annualCreditBalance; // Annual credit balance of the retailer
+    std::vector<int> productIds; // List of product IDs associated with the retailer
+
+public:
+    // Constructor to initialize a Retailer object
+    Retailer(int retailerId, const std::string& retailerName, const std::string& retailerLocation, 
+             double lat, double lon, double initialCredit, double annualCredit)
+        : id(retailerId), name(retailerName), location(retailerLocation), 
+          latitude(lat), longitude(lon), creditBalance(initialCredit), annualCreditBalance(annualCredit) {}
+
+    // Getter function to return the retailer ID
+    int getId() const { return id; }
+    
+    // Getter function to return the retailer name
+    std::string getName() const { return name; }
+    
+    // Getter function to return the retailer location
+    std::string getLocation() const { return location; }
+    
+    // Getter function to return the latitude of the retailer's location
+    double getLatitude() const { return latitude; }
+    
+    // Getter function to return the longitude of the retailer's location
+    double getLongitude() const { return longitude; }
+    
+    // Getter function to return the current credit balance of the retailer
+    double getCreditBalance() const { return creditBalance; }
+    
+    // Getter function to return the annual credit balance of the retailer
+    double getAnnualCreditBalance() const { return annualCreditBalance; }
+    
+    // Function to add a product ID to the retailer's list of products
+    void addProduct(int productId) {
+        productIds.push_back(productId);
+    }
+
+    // Getter function to retrieve the list of product IDs
+    const std::vector<int>& getProductIds() const {
+        return productIds;
+    }
+
+    // Function to deduct a specified amount from the retailer's credit balance
+    bool deductCredit(double amount) {
+        if (creditBalance >= amount) { // Check if sufficient credit is available
+            creditBalance -= amount; // Deduct the amount from the current credit balance
+            annualCreditBalance -= amount; // Deduct the amount from the annual credit balance
+            return true; // Return true if deduction is successful
+        }
+        return false; // Return false if insufficient credit
+    }
+
+    // Function to add a specified amount to the retailer's credit balance
+    void addCredit(double amount) {
+        creditBalance += amount; // Add the amount to the current credit balance
+        annualCreditBalance += amount; // Add the amount to the annual credit balance
+    }
+
+    // Function to generate a string representation of the retailer details
+    std::string toString() const {
+        std::stringstream ss;
+        ss << "Retailer ID: " << id << " | Name: " << name 
+           << " | Location: " << location 
+           << " | Credit Balance: RM" << std::fixed << std::setprecision(2) << creditBalance
+           << " | Annual Credit Balance: RM" << std::fixed << std::setprecision(2) << annualCreditBalance;
+        return ss.str();
+    }
+
+    // Function to generate data to be stored in a blockchain
+    std::string getBlockData() const {
+        std::stringstream ss;
+        ss << "Retailer ID: " << id << " | Retailer Name: " << name
+           << " | Location: " << location
+           << " | Credit Balance: RM" << std::fixed << std::setprecision(2) << creditBalance
+           << " | Annual Credit Balance: RM" << std::fixed << std::setprecision(2) << annualCreditBalance;
+        return ss.str();
+    }
+
+    // Function to serialize retailer data into a string format for storage
+    std::string serialize() const {
+        std::stringstream ss;
+        ss << id << "|" << name << "|" << location << "|" << latitude << "|" << longitude << "|" 
+           << creditBalance << "|" << annualCreditBalance;
+        
+        // Add product IDs to the serialized string
+        ss << "|";
+        for (size_t i = 0; i < productIds.size(); ++i) {
+            ss << productIds[i];
+            if (i < productIds.size() - 1) {
+                ss << ",";
+            }
+        }
+        
+        return ss.str();
+    }
+
+    // Static function to deserialize a retailer from a serialized string
+    static Retailer deserialize(std::string_view str) {
+        FieldReader fields(str, "retailer");
+        int id = fields.integer();
+        std::string name(fields.text());
+        std::string location(fields.text());
+        double latitude = fields.number();
+        double longitude = fields.number();
+        double creditBalance = fields.number();
+        double annualCreditBalance = fields.number();
+        
+        Retailer retailer(id, name, location, latitude, longitude, creditBalance, annualCreditBalance);
+        
+        // Add product IDs if present
+        if (fields.hasMore()) {
+            fields.idList([&retailer](int productId) { retailer.addProduct(productId); });
+        }
+        return retailer;
+    }
+};
+
+// Transporter class
+class Transporter {
+private:
+    int id; // Unique identifier for the transporter
+    std::string name; // Name of the transporter
+    std::string transportType; // Type of transportation (e.g., ground, air)
+    double costPerKm; // Cost per kilometer for transportation
+    double maxCapacity;  // Maximum capacity of the transporter in kilograms
+
+public:
+    // Constructor to initialize a Transporter object
+    Transporter(int transporterId, const std::string& transporterName, const std::string& type,
+                double perKmCost, double capacity)
+        : id(transporterId), name(transporterName), transportType(type), 
+          costPerKm(perKmCost), maxCapacity(capacity) {}
+
+    // Getter function to return the transporter ID
+    int getId() const { return id; }
+    
+    // Getter function to return the transporter name
+    std::string getName() const { return name; }
+    
+    // Getter function to return the type of transportation
+    std::string getTransportType() const { return transportType; }
+    
+    // Getter function to return the cost per kilometer for transportation
+    double getCostPerKm() const { return costPerKm; }
+    
+    // Getter function to return the maximum capacity of the transporter
+    double getMaxCapacity() const { return maxCapacity; }
+
+    // Function to check if the transporter can handle a given weight
+    bool canTransport(double weight) const {
+        return weight <= maxCapacity;
+    }
+
+    // Function to calculate the transportation cost for a given distance
+    double calculateTransportCost(double distance) const {
+        return distance * costPerKm;
+    }
+
+    // Function to generate a string representation of the transporter details
+    std::string toString() const {
+        std::stringstream ss;
+        ss << "Transporter ID: " << id << " | Name: " << name 
+           << " | Type: " << transportType
+           << " | Cost/km: RM" << std::fixed << std::setprecision(2) << costPerKm
+           << " | Max Capacity: " << maxCapacity << "kg";
+        return ss.str();
+    }
+
+    // Function to generate data to be stored in a blockchain
+    std::string getBlockData() const {
+        std::stringstream ss;
+        ss << "Transporter ID: " << id << " | Transporter Name: " << name
+           << " | Transportation Type: " << transportType
+           << " | Cost/km: RM" << std::fixed << std::setprecision(2) << costPerKm
+           << " | Max Capacity: " << maxCapacity << "kg";
+        return ss.str();
+    }
+
+    // Function to serialize transporter data into a string format for storage
+    std::string serialize() const {
+        std::stringstream ss;
+        ss << id << "|" << name << "|" << transportType << "|" << costPerKm << "|" << maxCapacity;
+        return ss.str();
+    }
+
+    // Static function to deserialize a transporter from a serialized string
+    static Transporter deserialize(std::string_view str) {
+        FieldReader fields(str, "transporter");
+        int id = fields.integer();
+        std::string name(fields.text());
+        std::string transportType(fields.text());
+        double costPerKm = fields.number();
+        double maxCapacity = fields.number();
+        return Transporter(id, name, transportType, costPerKm, maxCapacity);
+    }
+};
+
+// TransactionStatus enum
+// Status of a transaction, stored in one byte
+enum class TransactionStatus : uint8_t {
+    Pending,
+    Completed,
+    Failed,
+    Other // Any status text the system does not issue itself
+};
+
+// OrderType enum
+// Type of order behind a transaction, stored in one byte
+enum class OrderType : uint8_t {
+    Regular,
+    Seasonal,
+    Other // Any order type text the system does not issue itself
+};
+
+// Utility function to convert status text to its enum
+TransactionStatus parseTransactionStatus(std::string_view status) {
+    if (status == "Completed") return TransactionStatus::Completed;
+    if (status == "Failed") return TransactionStatus::Failed;
+    if (status == "Pending") return TransactionStatus::Pending;
+    return TransactionStatus::Other;
+}
+
+// Utility function to convert a status to its text form
+const char* transactionStatusToString(TransactionStatus status) {
+    switch (status) {
+        case TransactionStatus::Pending: return "Pending";
+        case TransactionStatus::Completed: return "Completed";
+        case TransactionStatus::Failed: return "Failed";
+        case TransactionStatus::Other: break;
+    }
+    return "Other";
+}
+
+// Utility function to convert order type text to its enum
+OrderType parseOrderType(std::string_view orderType) {
+    if (orderType == "Regular") return OrderType::Regular;
+    if (orderType == "Seasonal") return OrderType::Seasonal;
+    return OrderType::Other;
+}
+
+// Utility function to convert an order type to its text form
+const char* orderTypeToString(OrderType orderType) {
+    switch (orderType) {
+        case OrderType::Regular: return "Regular";
+        case OrderType::Seasonal: return "Seasonal";
+        case OrderType::Other: break;
+    }
+    return "Other";
+}
+
+// Transaction class
+class Transaction {
+private:
+    int id; // Unique identifier for the transaction
+    int supplierId; // ID of the supplier involved in the transaction
+    int retailerId; // ID of the retailer involved in the transaction
+    int productId; // ID of the product being transacted
+    int transporterId; // ID of the transporter handling the delivery
+    int quantity; // Quantity of the product being transacted
+    double productCost; // Cost of the product
+    double transportCost; // Cost of transportation
+    double totalCost; // Total cost of the transaction (product cost + transport cost)
+    int64_t timestamp; // Time the transaction was created, in seconds since the epoch
+    TransactionStatus status; // Status of the transaction (Pending, Completed, Failed)
+    OrderType orderType; // Type of order (Seasonal, Regular)
+
+public:
+    // Constructor to initialize a Transaction object
+    Transaction(int transId, int sId, int rId, int pId, int tId, int qty)
+        : id(transId), supplierId(sId), retailerId(rId), productId(pId), 
+          transporterId(tId), quantity(qty), productCost(0), transportCost(0), totalCost(0),
+          timestamp(static_cast<int64_t>(time(0))), // Set the current time
+          status(TransactionStatus::Pending), // Set the initial status to Pending
+          orderType(OrderType::Regular) { // Set the default order type to Regular
+    }
+
+    // Getter function to return the transaction ID
+    int getId() const { return id; }
+    // Getter function to return the supplier ID
+    int getSupplierId() const { return supplierId; }
+    // Getter function to return the retailer ID
+    int getRetailerId() const { return retailerId; }
+    // Getter function to return the product ID
+    int getProductId() const { return productId; }
+    // Getter function to return the transporter ID
+    int getTransporterId() const { return transporterId; }
+    // Getter function to return the quantity of the product
+    int getQuantity() const { return quantity; }
+    // Getter function to return the product cost
+    double getProductCost() const { return productCost; }
+    // Getter function to return the transport cost
+    double getTransportCost() const { return transportCost; }
+    // Getter function to return the total cost of the transaction
+    double getTotalCost() const { return totalCost; }
+    // Getter function to return the timestamp of the transaction (seconds since the epoch)
+    int64_t getTimestamp() const { return timestamp; }
+    // Getter function to return the status of the transaction
+    TransactionStatus getStatus() const { return status; }
+    // Getter function to return the order type
+    OrderType getOrderType() const { return orderType; }
+
+    // Setter function to set the product cost
+    void setProductCost(double cost) { productCost = cost; }
+    // Setter function to set the transport cost
+    void setTransportCost(double cost) { transportCost = cost; }
+    // Function to calculate the total cost of the transaction
+    void calculateTotalCost() { totalCost = productCost + transportCost; }
+    // Setter function to set the status of the transaction
+    void setStatus(TransactionStatus newStatus) { status = newStatus; }
+    // Setter function to set the order type
+    void setOrderType(OrderType type) { orderType = type; }
+    // Setter function to assign the transaction ID once a batched order is accepted
+    void setId(int transId) { id = transId; }
+
+    // Function to generate a string representation of the transaction details
+    std::string toString() const {
+        std::stringstream ss;
+        ss << "Transaction ID: " << id 
+           << " | Supplier ID: " << supplierId
+           << " | Retailer ID: " << retailerId
+           << " | Product ID: " << productId
+           << " | Transporter ID: " << transporterId
+           << " | Quantity: " << quantity
+           << " | Product Cost: RM" << std::fixed << std::setprecision(2) << productCost
+           << " | Transport Cost: RM" << std::fixed << std::setprecision(2) << transportCost
+           << " | Total Cost: RM" << std::fixed << std::setprecision(2) << totalCost
+           << " | Timestamp: " << formatTimestamp(timestamp)
+           << " | Status: " << transactionStatusToString(status)
+           << " | Order Type: " << orderTypeToString(orderType);
+        return ss.str();
+    }
+
+    // Function to append the data stored in a blockchain for this transaction to out,
+    // formatting numbers in place rather than through a stringstream
+    void appendBlockData(std::string& out) const {
+        char number[32];
+        auto appendInt = [&out, &number](int value) {
+            auto converted = std::to_chars(number, number + sizeof(number), value);
+            out.append(number, converted.ptr - number);
+        };
+        out += "Transaction ID: ";
+        appendInt(id);
+        out += " | Supplier ID: ";
+        appendInt(supplierId);
+        out += " | Retailer ID: ";
+        appendInt(retailerId);
+        out += " | Product ID: ";
+        appendInt(productId);
+        out += " | Quantity: ";
+        appendInt(quantity);
+        out += " | Total Cost: RM";
+        char cost[320]; // Room for any double in fixed notation: up to 309 integer digits, sign and ".00"
+        auto converted = std::to_chars(cost, cost + sizeof(cost), totalCost, std::chars_format::fixed, 2);
+        if (converted.ec != std::errc()) {
+            throw std::runtime_error("Transaction total cost cannot be formatted");
+        }
+        out.append(cost, converted.ptr - cost);
+        out += " | Timestamp: ";
+        out += formatTimestamp(timestamp);
+        out += " | Status: ";
+        out += transactionStatusToString(status);
+        out += " | Order Type: ";
+        out += orderTypeToString(orderType);
+    }
+
+    // Function to generate data to be stored in a blockchain
+    std::string getBlockData() const {
+        std::string data;
+        appendBlockData(data);
+        return data;
+    }
+
+    // Function to serialize transaction data into a string format for storage
+    std::string serialize() const {
+        std::stringstream ss;
+        ss << id << "|" << supplierId << "|" << retailerId << "|" << productId << "|" 
+           << transporterId << "|" << quantity << "|" << productCost << "|" 
+           << transportCost << "|" << totalCost << "|" << formatTimestamp(timestamp) << "|" 
+           << transactionStatusToString(status) << "|" << orderTypeToString(orderType);
+        return ss.str();
+    }
+
+    // Static function to rebuild a transaction from stored fields (used by the binary snapshot)
+    static Transaction restore(int transId, int sId, int rId, int pId, int tId, int qty,
+                               double prodCost, double transCost, double total,
+                               int64_t time, TransactionStatus stat, OrderType type) {
+        Transaction transaction(transId, sId, rId, pId, tId, qty);
+        transaction.productCost = prodCost;
+        transaction.transportCost = transCost;
+        transaction.totalCost = total;
+        transaction.timestamp = time;
+        transaction.status = stat;
+        transaction.orderType = type;
+        return transaction;
+    }
+
+    // Static function to deserialize a transaction from a serialized string
+    static Transaction deserialize(std::string_view str) {
+        FieldReader fields(str, "transaction");
+        int id = fields.integer();
+        int supplierId = fields.integer();
+        int retailerId = fields.integer();
+        int productId = fields.integer();
+        int transporterId = fields.integer();
+        int quantity = fields.integer();
+        
+        Transaction transaction(id, supplierId, retailerId, productId, transporterId, quantity);
+        transaction.productCost = fields.number();
+        transaction.transportCost = fields.number();
+        transaction.totalCost = fields.number();
+        transaction.timestamp = parseTimestamp(fields.text());
+        transaction.status = parseTransactionStatus(fields.text());
+        transaction.orderType = parseOrderType(fields.text());
+        return transaction;
+    }
+};
+
+// RecordPool class
+// Append-only record storage in large fixed-size chunks. Records never move, so pointers and
+// slots stay valid as the pool grows, and a million records cost a few hundred allocations
+// instead of one per handful of records. clear() keeps the chunks for the next load, while
+// release() hands them back; for trivially destructible records both are O(chunks).
+template <typename T>
+class RecordPool {
+private:
+    static constexpr size_t chunkRecords = 4096; // Records per chunk
+    
+    struct Chunk {
+        alignas(T) unsigned char bytes[sizeof(T) * chunkRecords]; // Left uninitialised until used
+    };
+    
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    size_t count = 0; // Records constructed so far
+
+    T* slot(size_t index) const {
+        return reinterpret_cast<T*>(chunks[index / chunkRecords]->bytes) + index % chunkRecords;
+    }
+
+    // Helper function to destroy every record, leaving the chunks allocated
+    void destroyAll() {
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            for (size_t i = 0; i < count; ++i) {
+                slot(i)->~T();
+            }
+        }
+        count = 0;
+    }
+
+public:
+    using value_type = T;
+
+    // Iterator over the records in slot order
+    template <typename Pool, typename Value>
+    class Cursor {
+    private:
+        Pool* pool;
+        size_t index;
+
+    public:
+        Cursor(Pool* owner, size_t position) : pool(owner), index(position) {}
+        Value& operator*() const { return (*pool)[index]; }
+        Value* operator->() const { return &(*pool)[index]; }
+        Cursor& operator++() { ++index; return *this; }
+        bool operator==(const Cursor& other) const { return index == other.index; }
+        bool operator!=(const Cursor& other) const { return index != other.index; }
+    };
+    using iterator = Cursor<RecordPool, T>;
+    using const_iterator = Cursor<const RecordPool, const T>;
+
+    // Read-only view of the records present when it was taken. Appending never moves a
+    // chunk, so another thread may read the view while records are added; it must not be
+    // read across a clear() or release() of the pool.
+    class Prefix {
+    private:
+        friend class RecordPool;
+        std::vector<const Chunk*> chunks;
+        size_t count = 0;
+
+    public:
+        size_t size() const { return count; }
+        const T& operator[](size_t index) const {
+            return reinterpret_cast<const T*>(chunks[index / chunkRecords]->bytes)[index % chunkRecords];
+        }
+    };
+
+    RecordPool() = default;
+    RecordPool(const RecordPool&) = delete;
+    RecordPool& operator=(const RecordPool&) = delete;
+    ~RecordPool() { destroyAll(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t index) { return *slot(index); }
+    const T& operator[](size_t index) const { return *slot(index); }
+    T& back() { return *slot(count - 1); }
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, count); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+
+    // Function to take a view of the records stored so far
+    Prefix prefix() const {
+        Prefix view;
+        view.chunks.reserve(chunks.size());
+        for (const auto& chunk : chunks) {
+            view.chunks.push_back(chunk.get());
+        }
+        view.count = count;
+        return view;
+    }
+
+    // Function to allocate the chunks for at least the given number of records up front
+    void reserve(size_t records) {
+        while (chunks.size() * chunkRecords < records) {
+            chunks.emplace_back(new Chunk);
+        }
+    }
+
+    // Function to append a record
+    void push_back(const T& record) {
+        reserve(count + 1);
+        new (slot(count)) T(record);
+        count++;
+    }
+
+    // Function to drop every record but keep the chunks for reuse
+    void clear() {
+        destroyAll();
+    }
+
+    // Function to drop every record and free the chunks
+    void release() {
+        destroyAll();
+        chunks.clear();
+    }
+};
+
+// CowColumn class
+// A column of values that forks in O(pages): the fork shares every page with the original
+// and either side copies a page the first time it writes to it. Shared pages are never
+// written, so separate forks may be used on separate threads once they are taken.
+template <typename T>
+class CowColumn {
+private:
+    static constexpr size_t pageValues = 256; // Values per page
+    
+    std::vector<std::shared_ptr<std::vector<T>>> pages;
+    std::vector<bool> owned; // Pages only this column refers to, safe to write in place
+    size_t count = 0;
+    size_t copies = 0; // Pages copied on write so far
+
+public:
+    CowColumn() = default;
+
+    // Constructor to fill the column with a copy of the given values
+    explicit CowColumn(const std::vector<T>& values) : count(values.size()) {
+        for (size_t first = 0; first < values.size(); first += pageValues) {
+            size_t last = std::min(first + pageValues, values.size());
+            pages.push_back(std::make_shared<std::vector<T>>(values.begin() + first, values.begin() + last));
+        }
+        owned.assign(pages.size(), true);
+    }
+
+    // Function to fork the column; from now on both sides copy a page before changing it
+    CowColumn fork() {
+        owned.assign(pages.size(), false);
+        CowColumn copy;
+        copy.pages = pages;
+        copy.owned = owned;
+        copy.count = count;
+        return copy;
+    }
+
+    size_t size() const { return count; }
+    size_t copiedPages() const { return copies; }
+    
+    const T& operator[](size_t index) const {
+        return (*pages[index / pageValues])[index % pageValues];
+    }
+
+    // Function to change one value, copying its page first if it is shared
+    void set(size_t index, const T& value) {
+        size_t page = index / pageValues;
+        if (!owned[page]) {
+            pages[page] = std::make_shared<std::vector<T>>(*pages[page]);
+            owned[page] = true;
+            copies++;
+        }
+        (*pages[page])[index % pageValues] = value;
+    }
+};
+
+// IdIndex class
+// Maps an entity ID to its slot in the owning container so lookups are O(1).
+// IDs are issued sequentially from 1, so a flat table indexed by ID stays compact;
+// unusually large IDs (e.g. from hand-edited data files) fall back to a hash map.
+class IdIndex {
+private:
+    static const int denseLimit = 1 << 22; // IDs below this use the flat table
+    std::vector<int> slots; // slots[id] holds the container position, -1 if unused
+    std::unordered_map<int, int> sparseSlots; // Slots for IDs outside the flat table
+
+public:
+    // Record that the entity with the given ID lives at the given slot
+    void insert(int id, size_t slot) {
+        if (id < 0) {
+            return; // The system never issues negative IDs
+        }
+        if (id >= denseLimit) {
+            sparseSlots[id] = static_cast<int>(slot);
+            return;
+        }
+        if (static_cast<size_t>(id) >= slots.size()) {
+            slots.resize(static_cast<size_t>(id) + 1, -1); // Grow the table to cover the new ID
+        }
+        slots[id] = static_cast<int>(slot);
+    }
+
+    // Function to get the slot of an ID, returns -1 if the ID is unknown
+    int find(int id) const {
+        if (id < 0) {
+            return -1;
+        }
+        if (id >= denseLimit) {
+            auto it = sparseSlots.find(id);
+            return it == sparseSlots.end() ? -1 : it->second;
+        }
+        if (static_cast<size_t>(id) >= slots.size()) {
+            return -1;
+        }
+        return slots[id];
+    }
+
+    // Remove every entry from the index
+    void clear() {
+        slots.clear();
+        sparseSlots.clear();
+    }
+
+    // Rebuild the index from a container of entities (used after bulk loads)
+    template <typename Container>
+    void rebuild(const Container& items) {
+        clear();
+        for (size_t i = 0; i < items.size(); ++i) {
+            insert(items[i].getId(), i);
+        }
+    }
+};
+
+// SupplyIndex class
+// Bipartite supplier <-> product index by container slot. Each side keeps a sorted
+// adjacency array, so a membership check is a binary search over the shorter list and
+// "which suppliers carry product P" is a direct read. Supplier::productIds stays the
+// stored copy; the index is rebuilt from it after bulk loads.
+class SupplyIndex {
+private:
+    std::vector<std::vector<int>> productsBySupplier; // Sorted product slots of each supplier slot
+    std::vector<std::vector<int>> suppliersByProduct; // Sorted supplier slots of each product slot
+
+    // Helper function to insert a value into a sorted list, returns false if it was there
+    static bool insertSorted(std::vector<int>& list, int value) {
+        auto position = std::lower_bound(list.begin(), list.end(), value);
+        if (position != list.end() && *position == value) {
+            return false;
+        }
+        list.insert(position, value);
+        return true;
+    }
+
+    // Helper function to get a list of the given table, empty for slots not seen yet
+    static const std::vector<int>& listAt(const std::vector<std::vector<int>>& table, size_t slot) {
+        static const std::vector<int> none;
+        return slot < table.size() ? table[slot] : none;
+    }
+
+public:
+    // Link a supplier slot to a product slot, returns false if they were already linked
+    bool link(size_t supplierSlot, size_t productSlot) {
+        if (supplierSlot >= productsBySupplier.size()) {
+            productsBySupplier.resize(supplierSlot + 1);
+        }
+        if (productSlot >= suppliersByProduct.size()) {
+            suppliersByProduct.resize(productSlot + 1);
+        }
+        if (!insertSorted(productsBySupplier[supplierSlot], static_cast<int>(productSlot))) {
+            return false;
+        }
+        insertSorted(suppliersByProduct[productSlot], static_cast<int>(supplierSlot));
+        return true;
+    }
+
+    // Function to check whether the supplier in a slot carries the product in a slot
+    bool supplies(size_t supplierSlot, size_t productSlot) const {
+        const std::vector<int>& products = listAt(productsBySupplier, supplierSlot);
+        const std::vector<int>& suppliers = listAt(suppliersByProduct, productSlot);
+        if (products.size() <= suppliers.size()) {
+            return std::binary_search(products.begin(), products.end(), static_cast<int>(productSlot));
+        }
+        return std::binary_search(suppliers.begin(), suppliers.end(), static_cast<int>(supplierSlot));
+    }
+
+    // Function to get the sorted supplier slots carrying the product in a slot
+    const std::vector<int>& suppliersOf(size_t productSlot) const {
+        return listAt(suppliersByProduct, productSlot);
+    }
+
+    // Function to get the sorted product slots carried by the supplier in a slot
+    const std::vector<int>& productsOf(size_t supplierSlot) const {
+        return listAt(productsBySupplier, supplierSlot);
+    }
+
+    // Remove every link from the index
+    void clear() {
+        productsBySupplier.clear();
+        suppliersByProduct.clear();
+    }
+
+    // Rebuild the index from the suppliers' product lists (used after bulk loads).
+    // Product IDs that do not resolve to a product are left out.
+    template <typename Container>
+    void rebuild(const Container& suppliers, const IdIndex& productIndex) {
+        clear();
+        productsBySupplier.resize(suppliers.size());
+        for (size_t s = 0; s < suppliers.size(); ++s) {
+            for (int productId : suppliers[s].getProductIds()) {
+                int productSlot = productIndex.find(productId);
+                if (productSlot >= 0) {
+                    link(s, static_cast<size_t>(productSlot));
+                }
+            }
+        }
+    }
+};
+
+// FleetColumns class
+// Structure-of-arrays copy of the transporters' cost per km and capacity by slot, so the
+// order planner filters and prices the whole fleet from two contiguous arrays
+class FleetColumns {
+public:
+    std::vector<double> costsPerKm;
+    std::vector<double> capacities;
+
+    // Append the transporter in the next slot
+    void add(const Transporter& transporter) {
+        costsPerKm.push_back(transporter.getCostPerKm());
+        capacities.push_back(transporter.getMaxCapacity());
+    }
+
+    // Remove every transporter
+    void clear() {
+        costsPerKm.clear();
+        capacities.clear();
+    }
+
+    // Rebuild the columns from the transporter list (used after bulk loads)
+    template <typename Container>
+    void rebuild(const Container& transporters) {
+        clear();
+        costsPerKm.reserve(transporters.size());
+        capacities.reserve(transporters.size());
+        for (const auto& transporter : transporters) {
+            add(transporter);
+        }
+    }
+};
+
+// TransactionColumns class
+// Structure-of-arrays copy of the transaction history used by the reports.
+// Transactions are never modified once stored, so each column is append-only and
+// aggregations stream over contiguous arrays instead of whole Transaction objects.
+class TransactionColumns {
+public:
+    std::vector<int> ids; // Transaction IDs
+    std::vector<int> retailerIds; // Retailer of each transaction
+    std::vector<int> productIds; // Product of each transaction
+    std::vector<int> quantities; // Quantity of each transaction
+    std::vector<double> totalCosts; // Total cost of each transaction
+    std::vector<TransactionStatus> statuses; // Status of each transaction
+    std::vector<OrderType> orderTypes; // Order type of each transaction
+
+    // Append one transaction to every column
+    void append(const Transaction& transaction) {
+        ids.push_back(transaction.getId());
+        retailerIds.push_back(transaction.getRetailerId());
+        productIds.push_back(transaction.getProductId());
+        quantities.push_back(transaction.getQuantity());
+        totalCosts.push_back(transaction.getTotalCost());
+        statuses.push_back(transaction.getStatus());
+        orderTypes.push_back(transaction.getOrderType());
+    }
+
+    // Function to get the number of rows
+    size_t size() const { return ids.size(); }
+
+    // Remove every row
+    void clear() {
+        ids.clear();
+        retailerIds.clear();
+        productIds.clear();
+        quantities.clear();
+        totalCosts.clear();
+        statuses.clear();
+        orderTypes.clear();
+    }
+
+    // Rebuild the columns from the transaction list (used after bulk loads)
+    template <typename Container>
+    void rebuild(const Container& transactions) {
+        clear();
+        ids.reserve(transactions.size());
+        retailerIds.reserve(transactions.size());
+        productIds.reserve(transactions.size());
+        quantities.reserve(transactions.size());
+        totalCosts.reserve(transactions.size());
+        statuses.reserve(transactions.size());
+        orderTypes.reserve(transactions.size());
+        for (const auto& transaction : transactions) {
+            append(transaction);
+        }
+    }
+};
+
+// ReportTotals struct
+// Distribution report figures kept up to date as transactions are stored,
+// so a report costs O(#products) instead of a rescan of the history
+struct ReportTotals {
+    int completed = 0; // Number of completed transactions
+    int failed = 0; // Number of failed transactions
+    double totalRevenue = 0.0; // Total cost of completed transactions
+    std::unordered_map<int, long long> productQuantities; // productId -> completed quantity
+
+    // Add one stored transaction to the totals
+    void add(const Transaction& transaction) {
+        if (transaction.getStatus() == TransactionStatus::Completed) {
+            completed++;
+            totalRevenue += transaction.getTotalCost();
+            productQuantities[transaction.getProductId()] += transaction.getQuantity();
+        } else if (transaction.getStatus() == TransactionStatus::Failed) {
+            failed++;
+        }
+    }
+
+    // Reset every total to zero
+    void clear() {
+        completed = 0;
+        failed = 0;
+        totalRevenue = 0.0;
+        productQuantities.clear();
+    }
+
+    // Recompute the totals from the transaction list (used after bulk loads)
+    template <typename Container>
+    void rebuild(const Container& transactions) {
+        clear();
+        for (const auto& transaction : transactions) {
+            add(transaction);
+        }
+    }
+
+    // Write the totals to a snapshot
+    template <typename Writer>
+    void writeTo(Writer& writer) const {
+        writer.addRecord(static_cast<int64_t>(completed));
+        writer.addRecord(static_cast<int64_t>(failed));
+        writer.addRecord(totalRevenue);
+        writer.addRecord(static_cast<uint64_t>(productQuantities.size()));
+        for (const auto& entry : productQuantities) {
+            writer.addRecord(static_cast<int64_t>(entry.first));
+            writer.addRecord(static_cast<int64_t>(entry.second));
+        }
+    }
+
+    // Read totals written by writeTo
+    template <typename Reader>
+    void readFrom(Reader& reader) {
+        clear();
+        completed = static_cast<int>(reader.template next<int64_t>());
+        failed = static_cast<int>(reader.template next<int64_t>());
+        totalRevenue = reader.template next<double>();
+        size_t products = static_cast<size_t>(reader.template next<uint64_t>());
+        productQuantities.reserve(products);
+        for (size_t i = 0; i < products; ++i) {
+            int productId = static_cast<int>(reader.template next<int64_t>());
+            productQuantities[productId] = reader.template next<int64_t>();
+        }
+    }
+};
+
+// TransactionSlotRange struct
+// Slots of the transactions matched by a history query, in time order
+struct TransactionSlotRange {
+    const uint32_t* first = nullptr;
+    const uint32_t* last = nullptr;
+
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// TransactionPostings class
+// Posting list of transaction slots sorted by timestamp, so a date range is two binary
+// searches. Transactions nearly always arrive in time order, making an add a push_back;
+// an older one is inserted in place.
+class TransactionPostings {
+private:
+    std::vector<int64_t> times; // Timestamp of each posting, ascending
+    std::vector<uint32_t> slots; // Transaction slot of each posting
+
+public:
+    // Add a transaction slot at its place in time order
+    void add(int64_t timestamp, size_t slot) {
+        if (times.empty() || timestamp >= times.back()) {
+            times.push_back(timestamp);
+            slots.push_back(static_cast<uint32_t>(slot));
+            return;
+        }
+        size_t position = static_cast<size_t>(std::upper_bound(times.begin(), times.end(), timestamp) - times.begin());
+        times.insert(times.begin() + position, timestamp);
+        slots.insert(slots.begin() + position, static_cast<uint32_t>(slot));
+    }
+
+    // Append a slot without keeping time order (bulk loads call sortByTime afterwards)
+    void append(int64_t timestamp, size_t slot) {
+        times.push_back(timestamp);
+        slots.push_back(static_cast<uint32_t>(slot));
+    }
+
+    // Restore time order after appends, keeping slot order among equal timestamps
+    void sortByTime() {
+        if (std::is_sorted(times.begin(), times.end())) {
+            return;
+        }
+        std::vector<size_t> order(times.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return times[a] < times[b]; });
+        std::vector<int64_t> sortedTimes(times.size());
+        std::vector<uint32_t> sortedSlots(slots.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            sortedTimes[i] = times[order[i]];
+            sortedSlots[i] = slots[order[i]];
+        }
+        times.swap(sortedTimes);
+        slots.swap(sortedSlots);
+    }
+
+    // Function to get the slots with from <= timestamp <= to
+    TransactionSlotRange range(int64_t from, int64_t to) const {
+        TransactionSlotRange result;
+        if (from > to) {
+            return result;
+        }
+        size_t first = static_cast<size_t>(std::lower_bound(times.begin(), times.end(), from) - times.begin());
+        size_t last = static_cast<size_t>(std::upper_bound(times.begin(), times.end(), to) - times.begin());
+        result.first = slots.data() + first;
+        result.last = slots.data() + last;
+        return result;
+    }
+
+    // Function to get the number of postings
+    size_t size() const { return slots.size(); }
+
+    // Remove every posting
+    void clear() {
+        times.clear();
+        slots.clear();
+    }
+
+    // Write the postings to a snapshot
+    template <typename Writer>
+    void writeTo(Writer& writer) const {
+        writer.addRecord(static_cast<uint64_t>(slots.size()));
+        writer.addArray(times.data(), times.size());
+        writer.addArray(slots.data(), slots.size());
+        writer.endSection();
+    }
+
+    // Read postings written by writeTo, checking that they are in time order and only
+    // refer to slots below slotLimit
+    template <typename Reader>
+    void readFrom(Reader& reader, size_t slotLimit) {
+        size_t count = static_cast<size_t>(reader.template next<uint64_t>());
+        reader.nextArray(times, count);
+        reader.nextArray(slots, count);
+        reader.endSection();
+        if (!std::is_sorted(times.begin(), times.end()) ||
+            std::any_of(slots.begin(), slots.end(), [slotLimit](uint32_t slot) { return slot >= slotLimit; })) {
+            throw std::runtime_error("Snapshot history index is inconsistent");
+        }
+    }
+};
+
+// TransactionHistoryIndex class
+// Secondary indexes over the transaction history: retailer -> slots, product -> slots and
+// a timeline of every slot, each kept in time order, so per-entity and date range
+// history queries never scan the whole history
+class TransactionHistoryIndex {
+private:
+    std::unordered_map<int, TransactionPostings> byRetailer; // retailerId -> postings
+    std::unordered_map<int, TransactionPostings> byProduct; // productId -> postings
+    TransactionPostings timeline; // Every transaction
+
+    // Helper function to query the postings under a key, if any
+    static TransactionSlotRange lookup(const std::unordered_map<int, TransactionPostings>& postings,
+                                       int id, int64_t from, int64_t to) {
+        auto it = postings.find(id);
+        return it == postings.end() ? TransactionSlotRange() : it->second.range(from, to);
+    }
+
+public:
+    static constexpr int64_t allTime = std::numeric_limits<int64_t>::max(); // Open end of a date range
+
+    // Index the transaction stored at the given slot
+    void add(const Transaction& transaction, size_t slot) {
+        int64_t timestamp = transaction.getTimestamp();
+        byRetailer[transaction.getRetailerId()].add(timestamp, slot);
+        byProduct[transaction.getProductId()].add(timestamp, slot);
+        timeline.add(timestamp, slot);
+    }
+
+    // Function to get a retailer's transactions with from <= timestamp <= to
+    TransactionSlotRange retailerHistory(int retailerId, int64_t from = -allTime, int64_t to = allTime) const {
+        return lookup(byRetailer, retailerId, from, to);
+    }
+
+    // Function to get a product's transactions with from <= timestamp <= to
+    TransactionSlotRange productHistory(int productId, int64_t from = -allTime, int64_t to = allTime) const {
+        return lookup(byProduct, productId, from, to);
+    }
+
+    // Function to get every transaction with from <= timestamp <= to
+    TransactionSlotRange between(int64_t from, int64_t to) const {
+        return timeline.range(from, to);
+    }
+
+    // Remove every entry
+    void clear() {
+        byRetailer.clear();
+        byProduct.clear();
+        timeline.clear();
+    }
+
+    // Rebuild the indexes from the transaction list (used after bulk loads)
+    template <typename Container>
+    void rebuild(const Container& transactions) {
+        clear();
+        for (size_t slot = 0; slot < transactions.size(); ++slot) {
+            const auto& transaction = transactions[slot];
+            byRetailer[transaction.getRetailerId()].append(transaction.getTimestamp(), slot);
+            byProduct[transaction.getProductId()].append(transaction.getTimestamp(), slot);
+            timeline.append(transaction.getTimestamp(), slot);
+        }
+        for (auto& entry : byRetailer) {
+            entry.second.sortByTime();
+        }
+        for (auto& entry : byProduct) {
+            entry.second.sortByTime();
+        }
+        timeline.sortByTime();
+    }
+
+    // Write every posting list to a snapshot
+    template <typename Writer>
+    void writeTo(Writer& writer) const {
+        timeline.writeTo(writer);
+        for (const auto* postings : {&byRetailer, &byProduct}) {
+            writer.addRecord(static_cast<uint64_t>(postings->size()));
+            for (const auto& entry : *postings) {
+                writer.addRecord(static_cast<int64_t>(entry.first));
+                entry.second.writeTo(writer);
+            }
+        }
+    }
+
+    // Read the indexes of a history of slotCount transactions written by writeTo
+    template <typename Reader>
+    void readFrom(Reader& reader, size_t slotCount) {
+        clear();
+        timeline.readFrom(reader, slotCount);
+        if (timeline.size() != slotCount) {
+            throw std::runtime_error("Snapshot history index is inconsistent");
+        }
+        for (auto* postings : {&byRetailer, &byProduct}) {
+            size_t lists = static_cast<size_t>(reader.template next<uint64_t>());
+            postings->reserve(lists);
+            for (size_t i = 0; i < lists; ++i) {
+                int id = static_cast<int>(reader.template next<int64_t>());
+                (*postings)[id].readFrom(reader, slotCount);
+            }
+        }
+    }
+};
+
+// DemandForecast struct
+// Holt (double exponential smoothing) state of one retailer's demand for one product,
+// where each completed order is one observation of order size
+struct DemandForecast {
+    double level = 0.0; // Smoothed order quantity
+    double trend = 0.0; // Smoothed change in order quantity per order
+    int observations = 0; // Completed orders folded in
+    int supplierId = 0; // Supplier of the latest completed order
+    int transporterId = 0; // Transporter of the latest completed order
+
+    // Function to get the forecast size of the next order
+    double nextQuantity() const {
+        return std::max(0.0, level + trend);
+    }
+};
+
+// DemandForecaster class
+// Keeps a DemandForecast per (retailer, product) pair, updated in O(1) as each completed
+// transaction is stored, so forecasts never need refitting over the whole history
+class DemandForecaster {
+private:
+    static constexpr double levelSmoothing = 0.4; // Weight of the newest order in the level
+    static constexpr double trendSmoothing = 0.2; // Weight of the newest change in the trend
+    
+    std::unordered_map<uint64_t, DemandForecast> forecasts; // (retailerId, productId) -> state
+
+    // Helper function to combine a retailer and product ID into one key
+    static uint64_t key(int retailerId, int productId) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(retailerId)) << 32) | static_cast<uint32_t>(productId);
+    }
+
+public:
+    // Fold one transaction into its pair's forecast; only completed orders are demand
+    void observe(const Transaction& transaction) {
+        if (transaction.getStatus() != TransactionStatus::Completed) {
+            return;
+        }
+        DemandForecast& forecast = forecasts[key(transaction.getRetailerId(), transaction.getProductId())];
+        double quantity = transaction.getQuantity();
+        if (forecast.observations == 0) {
+            forecast.level = quantity;
+            forecast.trend = 0.0;
+        } else {
+            double previousLevel = forecast.level;
+            forecast.level = levelSmoothing * quantity + (1.0 - levelSmoothing) * (forecast.level + forecast.trend);
+            forecast.trend = trendSmoothing * (forecast.level - previousLevel) + (1.0 - trendSmoothing) * forecast.trend;
+        }
+        forecast.observations++;
+        forecast.supplierId = transaction.getSupplierId();
+        forecast.transporterId = transaction.getTransporterId();
+    }
+
+    // Function to get a pair's forecast, nullptr if the retailer has never bought the product
+    const DemandForecast* find(int retailerId, int productId) const {
+        auto it = forecasts.find(key(retailerId, productId));
+        return it == forecasts.end() ? nullptr : &it->second;
+    }
+
+    // Function to get the number of pairs with a forecast
+    size_t size() const { return forecasts.size(); }
+
+    // Function to call visit(retailerId, productId, forecast) for every pair, in no particular order
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const auto& entry : forecasts) {
+            visit(static_cast<int>(static_cast<uint32_t>(entry.first >> 32)), static_cast<int>(static_cast<uint32_t>(entry.first)),
+                  entry.second);
+        }
+    }
+
+    // Remove every forecast
+    void clear() {
+        forecasts.clear();
+    }
+
+    // Rebuild the forecasts from history (used after bulk loads), oldest transaction first
+    template <typename Container>
+    void rebuild(const Container& transactions, TransactionSlotRange timeline) {
+        clear();
+        for (uint32_t slot : timeline) {
+            observe(transactions[slot]);
+        }
+    }
+
+    // Write every forecast to a snapshot
+    template <typename Writer>
+    void writeTo(Writer& writer) const {
+        writer.addRecord(static_cast<uint64_t>(forecasts.size()));
+        for (const auto& entry : forecasts) {
+            const DemandForecast& forecast = entry.second;
+            writer.addRecord(entry.first);
+            writer.addRecord(forecast.level);
+            writer.addRecord(forecast.trend);
+            writer.addRecord(static_cast<int32_t>(forecast.observations));
+            writer.addRecord(static_cast<int32_t>(forecast.supplierId));
+            writer.addRecord(static_cast<int32_t>(forecast.transporterId));
+            writer.addRecord(static_cast<int32_t>(0)); // Keeps the next key 8-byte aligned
+        }
+    }
+
+    // Read forecasts written by writeTo
+    template <typename Reader>
+    void readFrom(Reader& reader) {
+        clear();
+        size_t count = static_cast<size_t>(reader.template next<uint64_t>());
+        forecasts.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            DemandForecast& forecast = forecasts[reader.template next<uint64_t>()];
+            forecast.level = reader.template next<double>();
+            forecast.trend = reader.template next<double>();
+            forecast.observations = reader.template next<int32_t>();
+            forecast.supplierId = reader.template next<int32_t>();
+            forecast.transporterId = reader.template next<int32_t>();
+            reader.template next<int32_t>();
+        }
+    }
+};
+
+// ContractContext struct
+// Read-only access to the entities that contract rules refer to. The references point into
+// the owning ProductionPlanningSystem, which outlives its contracts.
+struct ContractContext {
+    const std::deque<Product>& products;
+    const std::deque<Supplier>& suppliers;
+    const std::deque<Retailer>& retailers;
+    const std::deque<Transporter>& transporters;
+    const IdIndex& productIndex;
+    const IdIndex& supplierIndex;
+    const IdIndex& retailerIndex;
+    const IdIndex& transporterIndex;
+};
+
+// RuleKey enum
+// Entity whose slot selects the bound of a compiled rule step
+enum class RuleKey : uint8_t {
+    None, // The bound is a constant
+    Supplier,
+    Retailer,
+    Product,
+    Transporter
+};
+
+const size_t ruleKeyCount = 5;
+
+// RuleValue enum
+// Order column a compiled rule step compares against its bound
+enum class RuleValue : uint8_t {
+    TotalCost,
+    Quantity
+};
+
+// RuleStep struct
+// One step of a compiled contract plan. An order passes the step if its value is at most
+// the bound, which is either a constant or a per-entity limit indexed by entity slot
+// (infinity for no limit, minus infinity to refuse every order of that entity).
+// A step with a fallback contract calls its validate() order by order instead.
+struct RuleStep {
+    short contractIndex = 0; // Contract reported when an order fails this step
+    RuleValue value = RuleValue::TotalCost;
+    RuleKey key = RuleKey::None;
+    double limit = 0.0; // Bound when key is None
+    std::vector<double> limits; // Bound for each slot of the key entity
+    const SmartContract* fallback = nullptr; // Contract that could not be compiled, if any
+};
+
+// RuleBatch struct
+// Column-wise copy of a batch of priced orders, as read by the compiled contract plan
+struct RuleBatch {
+    std::vector<double> totalCosts; // Total cost of each order
+    std::vector<double> quantities; // Quantity of each order
+    std::array<std::vector<int>, ruleKeyCount> slots; // slots[key][k]: slot of order k's entity
+
+    // Function to get the number of orders
+    size_t size() const { return totalCosts.size(); }
+
+    // Remove every order, keeping the allocated columns
+    void clear() {
+        totalCosts.clear();
+        quantities.clear();
+        for (auto& column : slots) {
+            column.clear();
+        }
+    }
+
+    // Reserve room for a batch of orders
+    void reserve(size_t count) {
+        totalCosts.reserve(count);
+        quantities.reserve(count);
+        for (size_t key = 1; key < ruleKeyCount; ++key) {
+            slots[key].reserve(count);
+        }
+    }
+
+    // Append one priced order with the slots of its entities
+    void append(const Transaction& transaction, int supplierSlot, int retailerSlot, int productSlot, int transporterSlot) {
+        totalCosts.push_back(transaction.getTotalCost());
+        quantities.push_back(transaction.getQuantity());
+        slots[static_cast<size_t>(RuleKey::Supplier)].push_back(supplierSlot);
+        slots[static_cast<size_t>(RuleKey::Retailer)].push_back(retailerSlot);
+        slots[static_cast<size_t>(RuleKey::Product)].push_back(productSlot);
+        slots[static_cast<size_t>(RuleKey::Transporter)].push_back(transporterSlot);
+    }
+};
+
+// Utility function to create a per-slot limit table with no limits set
+std::vector<double> unlimitedTable(size_t slots) {
+    return std::vector<double>(slots, std::numeric_limits<double>::infinity());
+}
+
+// SmartContract class (abstract base class)
+class SmartContract {
+public:
+    virtual ~SmartContract() = default; // Virtual destructor to allow proper cleanup of derived classes
+    virtual bool validate(const Transaction& transaction) const = 0; // Pure virtual function to validate a transaction
+    virtual std::string getDescription() const = 0; // Pure virtual function to get a description of the contract
+    
+    // Append the rule steps that check this contract to a plan. Contracts that cannot be
+    // expressed as rule steps keep the default, and are validated order by order.
+    virtual bool compile(short, std::vector<RuleStep>&) const { return false; }
+};
+
+// PriceThresholdContract class
+class PriceThresholdContract : public SmartContract {
+    private:
+        double maxAllowedCost; // Maximum allowed cost for a transaction
+    
+    public:
+        // Constructor to initialize the contract with a cost threshold
+        PriceThresholdContract(double threshold) : maxAllowedCost(threshold) {}
+    
+        // Override the validate function to check if the transaction cost is within the allowed limit
+        bool validate(const Transaction& transaction) const override {
+            return transaction.getTotalCost() <= maxAllowedCost; // Return true if the transaction cost is within the limit
+        }
+    
+        // Override the compile function: one constant bound on the total cost
+        bool compile(short contractIndex, std::vector<RuleStep>& plan) const override {
+            RuleStep step;
+            step.contractIndex = contractIndex;
+            step.value = RuleValue::TotalCost;
+            step.limit = maxAllowedCost;
+            plan.push_back(std::move(step));
+            return true;
+        }
+    
+        // Override the getDescription function to provide a description of the contract
+        std::string getDescription() const override {
+            std::stringstream ss;
+            ss << "Price Threshold Contract: Maximum allowed cost is RM" 
+               << std::fixed << std::setprecision(2) << maxAllowedCost; // Format the description with the cost threshold
+            return ss.str(); // Return the description as a string
+        }
+    };
+
+// RetailerCreditCapContract class
+// Caps the cost of a single order for selected retailers
+class RetailerCreditCapContract : public SmartContract {
+    private:
+        const ContractContext& context;
+        std::vector<std::pair<int, double>> caps; // (retailer ID, maximum order cost), sorted by ID
+    
+    public:
+        // Constructor to initialize the contract with the retailers' caps
+        RetailerCreditCapContract(const ContractContext& entities, std::vector<std::pair<int, double>> retailerCaps)
+            : context(entities), caps(std::move(retailerCaps)) {
+            std::sort(caps.begin(), caps.end());
+        }
+    
+        // Override the validate function to check the order against its retailer's cap
+        bool validate(const Transaction& transaction) const override {
+            auto it = std::lower_bound(caps.begin(), caps.end(), std::make_pair(transaction.getRetailerId(), -std::numeric_limits<double>::infinity()));
+            return it == caps.end() || it->first != transaction.getRetailerId() || transaction.getTotalCost() <= it->second;
+        }
+    
+        // Override the compile function: total cost bounded per retailer slot
+        bool compile(short contractIndex, std::vector<RuleStep>& plan) const override {
+            RuleStep step;
+            step.contractIndex = contractIndex;
+            step.value = RuleValue::TotalCost;
+            step.key = RuleKey::Retailer;
+            step.limits = unlimitedTable(context.retailers.size());
+            for (const auto& cap : caps) {
+                int slot = context.retailerIndex.find(cap.first);
+                if (slot >= 0) {
+                    step.limits[slot] = std::min(step.limits[slot], cap.second);
+                }
+            }
+            plan.push_back(std::move(step));
+            return true;
+        }
+    
+        // Override the getDescription function to list the capped retailers
+        std::string getDescription() const override {
+            std::stringstream ss;
+            ss << "Retailer Credit Cap Contract: Maximum order cost";
+            for (size_t i = 0; i < caps.size(); ++i) {
+                ss << (i == 0 ? " " : ", ") << "Retailer " << caps[i].first << " RM"
+                   << std::fixed << std::setprecision(2) << caps[i].second;
+            }
+            return ss.str();
+        }
+    };
+
+// ProductQuotaContract class
+// Limits the quantity of a single order for selected products
+class ProductQuotaContract : public SmartContract {
+    private:
+        const ContractContext& context;
+        std::vector<std::pair<int, int>> quotas; // (product ID, maximum order quantity), sorted by ID
+    
+    public:
+        // Constructor to initialize the contract with the products' quotas
+        ProductQuotaContract(const ContractContext& entities, std::vector<std::pair<int, int>> productQuotas)
+            : context(entities), quotas(std::move(productQuotas)) {
+            std::sort(quotas.begin(), quotas.end());
+        }
+    
+        // Override the validate function to check the order against its product's quota
+        bool validate(const Transaction& transaction) const override {
+            auto it = std::lower_bound(quotas.begin(), quotas.end(), std::make_pair(transaction.getProductId(), std::numeric_limits<int>::min()));
+            return it == quotas.end() || it->first != transaction.getProductId() || transaction.getQuantity() <= it->second;
+        }
+    
+        // Override the compile function: quantity bounded per product slot
+        bool compile(short contractIndex, std::vector<RuleStep>& plan) const override {
+            RuleStep step;
+            step.contractIndex = contractIndex;
+            step.value = RuleValue::Quantity;
+            step.key = RuleKey::Product;
+            step.limits = unlimitedTable(context.products.size());
+            for (const auto& quota : quotas) {
+                int slot = context.productIndex.find(quota.first);
+                if (slot >= 0) {
+                    step.limits[slot] = std::min(step.limits[slot], static_cast<double>(quota.second));
+                }
+            }
+            plan.push_back(std::move(step));
+            return true;
+        }
+    
+        // Override the getDescription function to list the quotas
+        std::string getDescription() const override {
+            std::stringstream ss;
+            ss << "Product Quota Contract: Maximum order quantity";
+            for (size_t i = 0; i < quotas.size(); ++i) {
+                ss << (i == 0 ? " " : ", ") << "Product " << quotas[i].first << " " << quotas[i].second;
+            }
+            return ss.str();
+        }
+    };
+
+// TransporterCapacityContract class
+// Rejects orders heavier than the assigned transporter can carry
+class TransporterCapacityContract : public SmartContract {
+    private:
+        const ContractContext& context;
+        double kgPerUnit; // Weight of one unit of product
+    
+    public:
+        // Constructor to initialize the contract with the weight of one unit
+        TransporterCapacityContract(const ContractContext& entities, double unitWeight = 1.0)
+            : context(entities), kgPerUnit(unitWeight) {}
+    
+        // Override the validate function to check the load against the transporter's capacity
+        bool validate(const Transaction& transaction) const override {
+            int slot = context.transporterIndex.find(transaction.getTransporterId());
+            return slot < 0 || transaction.getQuantity() * kgPerUnit <= context.transporters[slot].getMaxCapacity();
+        }
+    
+        // Override the compile function: quantity bounded per transporter slot
+        bool compile(short contractIndex, std::vector<RuleStep>& plan) const override {
+            RuleStep step;
+            step.contractIndex = contractIndex;
+            step.value = RuleValue::Quantity;
+            step.key = RuleKey::Transporter;
+            step.limits.reserve(context.transporters.size());
+            for (const auto& transporter : context.transporters) {
+                step.limits.push_back(transporter.getMaxCapacity() / kgPerUnit); // Capacity in units
+            }
+            plan.push_back(std::move(step));
+            return true;
+        }
+    
+        // Override the getDescription function to provide a description of the contract
+        std::string getDescription() const override {
+            std::stringstream ss;
+            ss << "Transporter Capacity Contract: Load may not exceed transporter capacity at "
+               << std::fixed << std::setprecision(2) << kgPerUnit << "kg per unit";
+            return ss.str();
+        }
+    };
+
+// RegionEmbargoContract class
+// Rejects orders supplied from a branch in the region or delivered to a retailer located in it
+class RegionEmbargoContract : public SmartContract {
+    private:
+        const ContractContext& context;
+        std::string region; // Embargoed region, e.g. a state name
+    
+        // Helper functions to tell whether an entity is inside the region
+        bool supplierEmbargoed(const Supplier& supplier) const {
+            return supplier.getBranch().find(region) != std::string::npos;
+        }
+    
+        bool retailerEmbargoed(const Retailer& retailer) const {
+            return retailer.getLocation().find(region) != std::string::npos;
+        }
+    
+    public:
+        // Constructor to initialize the contract with the embargoed region
+        RegionEmbargoContract(const ContractContext& entities, const std::string& embargoedRegion)
+            : context(entities), region(embargoedRegion) {}
+    
+        // Override the validate function to check both ends of the order
+        bool validate(const Transaction& transaction) const override {
+            int supplierSlot = context.supplierIndex.find(transaction.getSupplierId());
+            int retailerSlot = context.retailerIndex.find(transaction.getRetailerId());
+            return !(supplierSlot >= 0 && supplierEmbargoed(context.suppliers[supplierSlot])) &&
+                   !(retailerSlot >= 0 && retailerEmbargoed(context.retailers[retailerSlot]));
+        }
+    
+        // Override the compile function: embargoed suppliers and retailers get a bound no order
+        // quantity can meet, everyone else is unlimited
+        bool compile(short contractIndex, std::vector<RuleStep>& plan) const override {
+            const double refused = -std::numeric_limits<double>::infinity();
+            
+            RuleStep supplierStep;
+            supplierStep.contractIndex = contractIndex;
+            supplierStep.value = RuleValue::Quantity;
+            supplierStep.key = RuleKey::Supplier;
+            supplierStep.limits = unlimitedTable(context.suppliers.size());
+            for (size_t slot = 0; slot < context.suppliers.size(); ++slot) {
+                if (supplierEmbargoed(context.suppliers[slot])) {
+                    supplierStep.limits[slot] = refused;
+                }
+            }
+            
+            RuleStep retailerStep;
+            retailerStep.contractIndex = contractIndex;
+            retailerStep.value = RuleValue::Quantity;
+            retailerStep.key = RuleKey::Retailer;
+            retailerStep.limits = unlimitedTable(context.retailers.size());
+            for (size_t slot = 0; slot < context.retailers.size(); ++slot) {
+                if (retailerEmbargoed(context.retailers[slot])) {
+                    retailerStep.limits[slot] = refused;
+                }
+            }
+            
+            plan.push_back(std::move(supplierStep));
+            plan.push_back(std::move(retailerStep));
+            return true;
+        }
+    
+        // Override the getDescription function to provide a description of the contract
+        std::string getDescription() const override {
+            return "Region Embargo Contract: No orders supplied from or delivered to " + region;
+        }
+    };
+
+// ContractEngine class
+// Validates whole batches of orders against the smart contracts. The contract set is compiled
+// into a flat plan of rule steps, and each step runs as one tight loop over a column of the
+// batch, so adding rules adds a cheap pass rather than a virtual call per order. The plan is
+// recompiled when contracts or entities change.
+class ContractEngine {
+private:
+    std::vector<RuleStep> plan;
+    bool stale = true; // Set when the plan must be recompiled before use
+    std::array<size_t, 5> compiledCounts{}; // Contract and entity counts the plan was compiled for
+    std::shared_mutex planMutex; // Shared by validating threads, exclusive while compiling
+
+    // Helper function to get the counts a plan depends on
+    static std::array<size_t, 5> currentCounts(size_t contractCount, const ContractContext& context) {
+        return {contractCount, context.products.size(), context.suppliers.size(),
+                context.retailers.size(), context.transporters.size()};
+    }
+
+    // Helper function to rebuild the plan
+    void compile(const std::vector<std::unique_ptr<SmartContract>>& contracts, const ContractContext& context) {
+        plan = compilePlan(contracts);
+        compiledCounts = currentCounts(contracts.size(), context);
+        stale = false;
+    }
+
+    // Helper function to run one step over the batch, recording the step's contract for
+    // orders that fail it and have not failed an earlier one
+    static void evaluate(const RuleStep& step, const RuleBatch& batch, const std::vector<Transaction>& pending,
+                         std::vector<short>& failedContract) {
+        size_t count = batch.size();
+        short index = step.contractIndex;
+        short* failed = failedContract.data();
+        
+        if (step.fallback) {
+            for (size_t k = 0; k < count; ++k) {
+                if (failed[k] < 0 && !step.fallback->validate(pending[k])) {
+                    failed[k] = index;
+                }
+            }
+            return;
+        }
+        
+        const double* values = step.value == RuleValue::TotalCost ? batch.totalCosts.data() : batch.quantities.data();
+        if (step.key == RuleKey::None) {
+            double bound = step.limit;
+            for (size_t k = 0; k < count; ++k) {
+                failed[k] = ((failed[k] < 0) & (values[k] > bound)) ? index : failed[k];
+            }
+        } else {
+            const int* slots = batch.slots[static_cast<size_t>(step.key)].data();
+            const double* limits = step.limits.data();
+            for (size_t k = 0; k < count; ++k) {
+                failed[k] = ((failed[k] < 0) & (values[k] > limits[slots[k]])) ? index : failed[k];
+            }
+        }
+    }
+
+public:
+    // Compile a contract set into a plan, contract by contract, for callers that adjust or
+    // run a plan of their own
+    static std::vector<RuleStep> compilePlan(const std::vector<std::unique_ptr<SmartContract>>& contracts) {
+        std::vector<RuleStep> steps;
+        for (size_t c = 0; c < contracts.size(); ++c) {
+            size_t firstStep = steps.size();
+            if (!contracts[c]->compile(static_cast<short>(c), steps)) {
+                steps.resize(firstStep);
+                RuleStep step;
+                step.contractIndex = static_cast<short>(c);
+                step.fallback = contracts[c].get();
+                steps.push_back(std::move(step));
+            }
+        }
+        return steps;
+    }
+
+    // Run a plan from compilePlan over a batch, as validate does with the shared plan
+    static void run(const std::vector<RuleStep>& steps, const RuleBatch& batch, const std::vector<Transaction>& pending,
+                    std::vector<short>& failedContract) {
+        failedContract.assign(batch.size(), -1);
+        for (const auto& step : steps) {
+            evaluate(step, batch, pending, failedContract);
+        }
+    }
+
+    // Mark the plan out of date, e.g. after entities were reloaded
+    void invalidate() {
+        std::unique_lock<std::shared_mutex> lock(planMutex);
+        stale = true;
+    }
+
+    // Validate a batch, setting failedContract[k] to the first contract order k fails (-1 if none).
+    // Safe to call from many threads at once, as long as contracts and entities are not being
+    // added at the same time.
+    void validate(const std::vector<std::unique_ptr<SmartContract>>& contracts, const ContractContext& context,
+                  const RuleBatch& batch, const std::vector<Transaction>& pending, std::vector<short>& failedContract) {
+        failedContract.assign(batch.size(), -1);
+        
+        std::shared_lock<std::shared_mutex> lock(planMutex);
+        if (stale || compiledCounts != currentCounts(contracts.size(), context)) {
+            lock.unlock();
+            {
+                std::unique_lock<std::shared_mutex> compileLock(planMutex);
+                if (stale || compiledCounts != currentCounts(contracts.size(), context)) {
+                    compile(contracts, context);
+                }
+            }
+            lock.lock();
+        }
+        
+        for (const auto& step : plan) {
+            evaluate(step, batch, pending, failedContract);
+        }
+    }
+};
+
+// LockStripes class
+// A fixed pool of mutexes handed out by entity ID. Orders touching different products or
+// retailers rarely share a stripe and run in parallel, while orders for the same one are
+// serialised, without adding a mutex to every entity.
+class LockStripes {
+private:
+    static const size_t stripeCount = 64;
+    std::array<std::mutex, stripeCount> mutexes;
+
+public:
+    // Function to get the mutex guarding the entity with the given ID
+    std::mutex& forId(int id) {
+        return mutexes[static_cast<unsigned>(id) % stripeCount];
+    }
+};
+
+// Supplier or transporter ID of an order that lets the order planner choose (IDs start at 1)
+const int autoSource = 0;
+
+// OrderRequest struct
+// A single order submitted through the batch ingestion API
+struct OrderRequest {
+    int supplierId; // ID of the supplier fulfilling the order, or autoSource
+    int retailerId; // ID of the retailer placing the order
+    int productId; // ID of the product being ordered
+    int transporterId; // ID of the transporter handling the delivery, or autoSource
+    int quantity; // Quantity of the product being ordered
+    OrderType orderType; // Type of order (Seasonal, Regular)
+};
+
+// Outcome of an order processed by the batch ingestion API
+enum class OrderOutcome : unsigned char {
+    Completed,          // Transaction recorded as completed
+    FailedContract,     // Transaction recorded as failed by a smart contract
+    FailedCredit,       // Transaction recorded as failed due to insufficient retailer credit
+    UnknownSupplier,    // Rejected: supplier ID not found
+    UnknownRetailer,    // Rejected: retailer ID not found
+    UnknownProduct,     // Rejected: product ID not found
+    UnknownTransporter, // Rejected: transporter ID not found
+    ProductNotSupplied, // Rejected: supplier does not supply the product
+    NoEligibleSource,   // Rejected: no supplier and transporter pair for an automatic order passes
+    InsufficientStock   // Rejected: not enough product stock
+};
+
+// OrderResult struct
+// Compact per-order result returned by the batch ingestion API
+struct OrderResult {
+    int transactionId;   // ID of the recorded transaction, -1 if the order was rejected
+    OrderOutcome outcome; // What happened to the order
+    short contractIndex; // Index of the failing contract for FailedContract, -1 otherwise
+};
+
+// SeasonalRunStats struct
+// Order counts of one seasonal simulation run
+struct SeasonalRunStats {
+    size_t forecastOrders = 0; // Orders that came from demand forecasts
+    size_t orders = 0; // Orders submitted
+    size_t completed = 0; // Orders completed
+    size_t failed = 0; // Orders recorded as failed (contract or credit)
+    size_t rejected = 0; // Orders refused before a transaction was created
+};
+
+// SourcePlan struct
+// Cheapest supplier and transporter the order planner found for an order
+struct SourcePlan {
+    int supplierId = -1;
+    int transporterId = -1;
+    double distance = 0.0; // Supplier to retailer distance in km
+    double productCost = 0.0;
+    double transportCost = 0.0;
+    double totalCost = 0.0;
+    size_t candidates = 0; // Supplier and transporter pairs priced
+};
+
+// Utility function to find the position of the smallest of count > 0 values, the first one
+// on ties. Four running minimums are kept apart so the scan does not wait on each comparison.
+size_t positionOfMinimum(const double* values, size_t count) {
+    const size_t lanes = 4;
+    if (count < lanes) {
+        return static_cast<size_t>(std::min_element(values, values + count) - values);
+    }
+    double bestValue[lanes];
+    size_t bestPosition[lanes];
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        bestValue[lane] = values[lane];
+        bestPosition[lane] = lane;
+    }
+    size_t k = lanes;
+    for (; k + lanes <= count; k += lanes) {
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            bool smaller = values[k + lane] < bestValue[lane];
+            bestValue[lane] = smaller ? values[k + lane] : bestValue[lane];
+            bestPosition[lane] = smaller ? k + lane : bestPosition[lane];
+        }
+    }
+    size_t best = 0;
+    for (size_t lane = 1; lane < lanes; ++lane) {
+        if (bestValue[lane] < bestValue[best] || (bestValue[lane] == bestValue[best] && bestPosition[lane] < bestPosition[best])) {
+            best = lane;
+        }
+    }
+    size_t position = bestPosition[best];
+    for (; k < count; ++k) { // The tail comes after every position seen so far
+        if (values[k] < values[position]) {
+            position = k;
+        }
+    }
+    return position;
+}
+
+// Utility function to describe an order outcome
+std::string orderOutcomeToString(OrderOutcome outcome) {
+    switch (outcome) {
+        case OrderOutcome::Completed: return "Completed";
+        case OrderOutcome::FailedContract: return "Failed smart contract validation";
+        case OrderOutcome::FailedCredit: return "Insufficient retailer credit";
+        case OrderOutcome::UnknownSupplier: return "Supplier ID not found";
+        case OrderOutcome::UnknownRetailer: return "Retailer ID not found";
+        case OrderOutcome::UnknownProduct: return "Product ID not found";
+        case OrderOutcome::UnknownTransporter: return "Transporter ID not found";
+        case OrderOutcome::ProductNotSupplied: return "This supplier does not supply this product";
+        case OrderOutcome::NoEligibleSource: return "No supplier and transporter can fulfil this order";
+        case OrderOutcome::InsufficientStock: return "Insufficient product stock";
+    }
+    return "Unknown outcome";
+}
+
+// RoutePoint struct
+// A location visited by a delivery route
+struct RoutePoint {
+    double latitude;
+    double longitude;
+};
+
+// SpatialGrid class
+// Uniform grid over a set of points, sized for about two points per cell, used to find
+// nearby points without comparing every pair. Points are stored cell by cell in one array,
+// so memory stays linear in the number of points.
+class SpatialGrid {
+private:
+    const std::vector<RoutePoint>* points = nullptr;
+    double minLatitude = 0.0;
+    double minLongitude = 0.0;
+    double cellSize = 1.0; // Cell edge length in degrees
+    size_t columns = 1;
+    size_t rows = 1;
+    std::vector<size_t> cellStart; // First slot of each cell in items
+    std::vector<size_t> cellCount; // Number of points still active in each cell
+    std::vector<size_t> items; // Point indexes grouped by cell, active ones first
+    std::vector<size_t> slotOf; // Slot of each point in items
+
+    // Helper function to get the cell coordinates of a location
+    void cellOf(double latitude, double longitude, size_t& column, size_t& row) const {
+        double x = (longitude - minLongitude) / cellSize;
+        double y = (latitude - minLatitude) / cellSize;
+        column = static_cast<size_t>(std::min(std::max(x, 0.0), static_cast<double>(columns - 1)));
+        row = static_cast<size_t>(std::min(std::max(y, 0.0), static_cast<double>(rows - 1)));
+    }
+
+    // Helper function to get the squared planar distance used for neighbour searches
+    double planarDistance2(const RoutePoint& point, double latitude, double longitude) const {
+        double dLat = point.latitude - latitude;
+        double dLon = point.longitude - longitude;
+        return dLat * dLat + dLon * dLon;
+    }
+
+    // Call visit(pointIndex) for every active point in the cells exactly ring cells away
+    template <typename Visitor>
+    void visitRing(size_t column, size_t row, size_t ring, Visitor visit) const {
+        long long r = static_cast<long long>(ring);
+        for (long long dy = -r; dy <= r; ++dy) {
+            long long y = static_cast<long long>(row) + dy;
+            if (y < 0 || y >= static_cast<long long>(rows)) {
+                continue;
+            }
+            long long step = (dy == -r || dy == r) ? 1 : std::max(2 * r, 1LL); // Only the ring's edge cells
+            for (long long dx = -r; dx <= r; dx += step) {
+                long long x = static_cast<long long>(column) + dx;
+                if (x < 0 || x >= static_cast<long long>(columns)) {
+                    continue;
+                }
+                size_t cell = static_cast<size_t>(y) * columns + static_cast<size_t>(x);
+                for (size_t slot = cellStart[cell]; slot < cellStart[cell] + cellCount[cell]; ++slot) {
+                    visit(items[slot]);
+                }
+            }
+        }
+    }
+
+public:
+    // Build the grid over the given points, all of them initially active
+    void build(const std::vector<RoutePoint>& routePoints) {
+        points = &routePoints;
+        size_t count = routePoints.size();
+        double maxLatitude = minLatitude = count ? routePoints[0].latitude : 0.0;
+        double maxLongitude = minLongitude = count ? routePoints[0].longitude : 0.0;
+        for (const auto& point : routePoints) {
+            minLatitude = std::min(minLatitude, point.latitude);
+            maxLatitude = std::max(maxLatitude, point.latitude);
+            minLongitude = std::min(minLongitude, point.longitude);
+            maxLongitude = std::max(maxLongitude, point.longitude);
+        }
+        double width = std::max(maxLongitude - minLongitude, 1e-6);
+        double height = std::max(maxLatitude - minLatitude, 1e-6);
+        double targetCells = std::max(1.0, count / 2.0);
+        cellSize = std::max(std::sqrt(width * height / targetCells), std::max(width, height) / targetCells);
+        columns = static_cast<size_t>(width / cellSize) + 1;
+        rows = static_cast<size_t>(height / cellSize) + 1;
+        
+        // Counting sort of the points by cell
+        std::vector<size_t> pointCell(count);
+        cellStart.assign(columns * rows + 1, 0);
+        for (size_t i = 0; i < count; ++i) {
+            size_t column, row;
+            cellOf(routePoints[i].latitude, routePoints[i].longitude, column, row);
+            pointCell[i] = row * columns + column;
+            cellStart[pointCell[i] + 1]++;
+        }
+        for (size_t cell = 0; cell < columns * rows; ++cell) {
+            cellStart[cell + 1] += cellStart[cell];
+        }
+        cellCount.assign(columns * rows, 0);
+        items.assign(count, 0);
+        slotOf.assign(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            size_t cell = pointCell[i];
+            size_t slot = cellStart[cell] + cellCount[cell]++;
+            items[slot] = i;
+            slotOf[i] = slot;
+        }
+    }
+
+    // Mark a point as visited so nearestActive skips it
+    void remove(size_t pointIndex) {
+        size_t column, row;
+        cellOf((*points)[pointIndex].latitude, (*points)[pointIndex].longitude, column, row);
+        size_t cell = row * columns + column;
+        size_t last = cellStart[cell] + cellCount[cell] - 1;
+        size_t slot = slotOf[pointIndex];
+        std::swap(items[slot], items[last]); // Move the point behind the cell's active range
+        slotOf[items[slot]] = slot;
+        slotOf[items[last]] = last;
+        cellCount[cell]--;
+    }
+
+    // Function to find the closest active point to a location, returns points.size() if none remain
+    size_t nearestActive(double latitude, double longitude) const {
+        size_t column, row;
+        cellOf(latitude, longitude, column, row);
+        size_t best = points->size();
+        double bestDistance = std::numeric_limits<double>::max();
+        size_t maxRing = std::max(columns, rows);
+        for (size_t ring = 0; ring <= maxRing; ++ring) {
+            visitRing(column, row, ring, [&](size_t candidate) {
+                double distance = planarDistance2((*points)[candidate], latitude, longitude);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = candidate;
+                }
+            });
+            double reach = ring * cellSize; // Cells further out are at least this far away
+            if (best != points->size() && bestDistance <= reach * reach) {
+                break;
+            }
+        }
+        return best;
+    }
+
+    // Function to find the k points closest to a point (excluding itself), nearest first
+    void nearest(size_t pointIndex, size_t k, std::vector<std::pair<double, size_t>>& found) const {
+        const RoutePoint& origin = (*points)[pointIndex];
+        size_t column, row;
+        cellOf(origin.latitude, origin.longitude, column, row);
+        found.clear();
+        size_t maxRing = std::max(columns, rows);
+        for (size_t ring = 0; ring <= maxRing; ++ring) {
+            visitRing(column, row, ring, [&](size_t candidate) {
+                if (candidate != pointIndex) {
+                    found.push_back({planarDistance2((*points)[candidate], origin.latitude, origin.longitude), candidate});
+                }
+            });
+            if (found.size() >= k) {
+                std::nth_element(found.begin(), found.begin() + (k - 1), found.end());
+                double reach = ring * cellSize;
+                if (found[k - 1].first <= reach * reach) {
+                    break;
+                }
+            }
+        }
+        size_t keep = std::min(k, found.size());
+        std::partial_sort(found.begin(), found.begin() + keep, found.end());
+        found.resize(keep);
+    }
+};
+
+// RouteStats struct
+// Measurements from one route optimisation
+struct RouteStats {
+    double greedyDistance = 0.0; // Tour length after the nearest-neighbour construction
+    double finalDistance = 0.0; // Tour length after local search
+    size_t twoOptMoves = 0; // Improving 2-opt moves applied
+    size_t orOptMoves = 0; // Improving Or-opt moves applied
+    double elapsedMs = 0.0; // Wall time spent planning
+};
+
+// RouteOptimizer class
+// Plans a closed tour from a depot through every stop. A greedy nearest-neighbour tour is
+// built with a spatial grid, then improved by 2-opt and Or-opt moves restricted to each
+// stop's nearest neighbours. Distances are computed on demand, so memory stays linear
+// in the number of stops instead of needing a full distance matrix.
+class RouteOptimizer {
+private:
+    static const size_t neighbourCount = 8; // Candidate neighbours considered per stop
+    static const size_t maxSegmentLength = 3; // Longest segment Or-opt relocates
+    
+    std::vector<RoutePoint> points; // Stops followed by the depot
+    std::vector<GeoVector> vectors; // Unit vectors of points, so distances need no trigonometry
+    std::vector<size_t> tour; // Node order around the cycle
+    std::vector<size_t> position; // position[node] is the node's slot in tour
+    std::vector<size_t> neighbours; // neighbourCount candidates per node, nearest first
+    std::vector<size_t> scratch; // Reused buffer for segment moves
+    std::deque<size_t> active; // Nodes whose surroundings may still improve
+    std::vector<char> queued; // Whether each node is in the active queue
+    RouteStats stats;
+
+    // Helper function to get the great-circle distance between two nodes
+    double distance(size_t a, size_t b) const {
+        return geoDistance(vectors[a], vectors[b]);
+    }
+
+    size_t next(size_t node) const { return tour[(position[node] + 1) % tour.size()]; }
+    size_t prev(size_t node) const { return tour[(position[node] + tour.size() - 1) % tour.size()]; }
+
+    // Helper function to queue a node for another improvement pass
+    void activate(size_t node) {
+        if (!queued[node]) {
+            queued[node] = 1;
+            active.push_back(node);
+        }
+    }
+
+    // Helper function to reverse the tour path running forward from one node to another.
+    // Reversing the rest of the cycle instead gives the same tour, so the shorter side is used.
+    void reversePath(size_t from, size_t to) {
+        size_t n = tour.size();
+        size_t i = position[from];
+        size_t j = position[to];
+        size_t length = (j + n - i) % n + 1;
+        if (length * 2 > n) {
+            size_t start = (j + 1) % n;
+            j = (i + n - 1) % n;
+            i = start;
+            length = n - length;
+        }
+        for (size_t k = 0; k < length / 2; ++k) {
+            std::swap(tour[i], tour[j]);
+            position[tour[i]] = i;
+            position[tour[j]] = j;
+            i = (i + 1) % n;
+            j = (j + n - 1) % n;
+        }
+    }
+
+    // Helper function to move the segment of length nodes starting at first so it sits
+    // between target and next(target), optionally reversed
+    void moveSegment(size_t first, size_t length, size_t target, bool reversed) {
+        size_t n = tour.size();
+        size_t last = tour[(position[first] + length - 1) % n];
+        size_t targetNext = next(target);
+        size_t forwardSpan = (position[target] + n - position[first]) % n + 1; // first .. target
+        size_t backwardSpan = (position[last] + n - position[targetNext]) % n + 1; // targetNext .. last
+        
+        scratch.clear();
+        auto pushSegment = [&]() {
+            for (size_t k = 0; k < length; ++k) {
+                size_t offset = reversed ? length - 1 - k : k;
+                scratch.push_back(tour[(position[first] + offset) % n]);
+            }
+        };
+        size_t start;
+        if (forwardSpan <= backwardSpan) {
+            // first .. last, middle .. target  becomes  middle .. target, segment
+            start = position[first];
+            for (size_t k = length; k < forwardSpan; ++k) {
+                scratch.push_back(tour[(start + k) % n]);
+            }
+            pushSegment();
+        } else {
+            // targetNext .. middle, first .. last  becomes  segment, targetNext .. middle
+            start = position[targetNext];
+            pushSegment();
+            for (size_t k = 0; k + length < backwardSpan; ++k) {
+                scratch.push_back(tour[(start + k) % n]);
+            }
+        }
+        for (size_t k = 0; k < scratch.size(); ++k) {
+            size_t slot = (start + k) % n;
+            tour[slot] = scratch[k];
+            position[scratch[k]] = slot;
+        }
+    }
+
+    // Try an improving 2-opt move on one of the tour edges at node a
+    bool improveTwoOpt(size_t a) {
+        for (int direction = 0; direction < 2; ++direction) {
+            size_t aNext = direction == 0 ? next(a) : prev(a);
+            double removedA = distance(a, aNext);
+            for (size_t k = 0; k < neighbourCount; ++k) {
+                size_t c = neighbours[a * neighbourCount + k];
+                if (c == a) {
+                    break; // Fewer neighbours than slots
+                }
+                double addedA = distance(a, c);
+                if (addedA >= removedA) {
+                    break; // Neighbours are sorted, no closer candidate follows
+                }
+                size_t cNext = direction == 0 ? next(c) : prev(c);
+                if (c == aNext || cNext == a) {
+                    continue;
+                }
+                double delta = addedA + distance(aNext, cNext) - removedA - distance(c, cNext);
+                if (delta < -1e-9) {
+                    if (direction == 0) {
+                        reversePath(aNext, c);
+                    } else {
+                        reversePath(a, cNext);
+                    }
+                    stats.twoOptMoves++;
+                    activate(aNext);
+                    activate(c);
+                    activate(cNext);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Try an improving Or-opt move that relocates a short segment starting at node first
+    bool improveOrOpt(size_t first) {
+        size_t n = tour.size();
+        for (size_t length = 1; length <= maxSegmentLength && length + 3 <= n; ++length) {
+            size_t last = tour[(position[first] + length - 1) % n];
+            size_t before = prev(first);
+            size_t after = next(last);
+            double removal = distance(before, first) + distance(last, after) - distance(before, after);
+            if (removal <= 1e-9) {
+                continue;
+            }
+            auto inSegment = [&](size_t node) {
+                return (position[node] + n - position[first]) % n < length;
+            };
+            
+            for (size_t end = 0; end < 2; ++end) {
+                size_t endpoint = end == 0 ? first : last;
+                for (size_t k = 0; k < neighbourCount; ++k) {
+                    size_t candidate = neighbours[endpoint * neighbourCount + k];
+                    if (candidate == endpoint || distance(endpoint, candidate) >= removal) {
+                        break;
+                    }
+                    // Insert next to the candidate on either side
+                    for (size_t side = 0; side < 2; ++side) {
+                        size_t c = side == 0 ? candidate : prev(candidate);
+                        size_t d = next(c);
+                        if (c == before || inSegment(c) || inSegment(d)) {
+                            continue;
+                        }
+                        double base = distance(c, d) + removal;
+                        double forward = distance(c, first) + distance(last, d) - base;
+                        double backward = distance(c, last) + distance(first, d) - base;
+                        if (std::min(forward, backward) < -1e-9) {
+                            moveSegment(first, length, c, backward < forward);
+                            stats.orOptMoves++;
+                            activate(before);
+                            activate(after);
+                            activate(c);
+                            activate(d);
+                            activate(last);
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // Helper function to get the length of the current tour
+    double tourLength() const {
+        double total = 0.0;
+        for (size_t i = 0; i < tour.size(); ++i) {
+            total += distance(tour[i], tour[(i + 1) % tour.size()]);
+        }
+        return total;
+    }
+
+public:
+    // Plan a closed tour from the depot through every stop.
+    // Returns stop indexes in visiting order.
+    std::vector<size_t> plan(const RoutePoint& depot, const std::vector<RoutePoint>& stops) {
+        auto started = std::chrono::steady_clock::now();
+        stats = RouteStats();
+        size_t stopCount = stops.size();
+        points = stops;
+        points.push_back(depot);
+        size_t n = points.size();
+        vectors.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            vectors[i] = toGeoVector(points[i].latitude, points[i].longitude);
+        }
+        size_t depotNode = stopCount;
+        
+        SpatialGrid grid;
+        grid.build(points);
+        
+        // Candidate neighbour lists, padded with the node itself when there are fewer points
+        neighbours.assign(n * neighbourCount, 0);
+        std::vector<std::pair<double, size_t>> found;
+        for (size_t node = 0; node < n; ++node) {
+            grid.nearest(node, neighbourCount, found);
+            for (size_t k = 0; k < neighbourCount; ++k) {
+                neighbours[node * neighbourCount + k] = k < found.size() ? found[k].second : node;
+            }
+        }
+        
+        // Greedy nearest-neighbour construction starting from the depot
+        tour.clear();
+        tour.reserve(n);
+        position.assign(n, 0);
+        grid.remove(depotNode);
+        tour.push_back(depotNode);
+        size_t current = depotNode;
+        for (size_t step = 0; step < stopCount; ++step) {
+            current = grid.nearestActive(points[current].latitude, points[current].longitude);
+            grid.remove(current);
+            position[current] = tour.size();
+            tour.push_back(current);
+        }
+        stats.greedyDistance = tourLength();
+        
+        // Local search until no stop can be improved
+        if (n >= 5) {
+            queued.assign(n, 1);
+            active.assign(tour.begin(), tour.end());
+            while (!active.empty()) {
+                size_t node = active.front();
+                active.pop_front();
+                queued[node] = 0;
+                if (improveTwoOpt(node) || improveOrOpt(node)) {
+                    activate(node);
+                }
+            }
+        }
+        stats.finalDistance = tourLength();
+        
+        // Read the stops off in order, starting after the depot
+        std::vector<size_t> order;
+        order.reserve(stopCount);
+        for (size_t k = 1; k < n; ++k) {
+            order.push_back(tour[(position[depotNode] + k) % n]);
+        }
+        stats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        return order;
+    }
+
+    // Function to get the measurements of the last plan
+    const RouteStats& lastStats() const { return stats; }
+};
+
+// VehicleRoute struct
+// One trip planned by the fleet router
+struct VehicleRoute {
+    size_t vehicle = 0; // Index of the transporter serving the trip
+    std::vector<size_t> stops; // Stop indexes in visiting order
+    double load = 0.0; // Total load carried
+    double distance = 0.0; // Depot to depot distance
+    double cost = 0.0; // The transporter's cost for the distance
+};
+
+// FleetPlan struct
+// Result of a capacitated vehicle-routing plan
+struct FleetPlan {
+    std::vector<VehicleRoute> routes; // One entry per trip
+    std::vector<size_t> unserved; // Stops whose load exceeds every vehicle's capacity
+    double totalDistance = 0.0;
+    double totalCost = 0.0;
+    size_t relocations = 0; // Stops moved between trips by the local search
+    double elapsedMs = 0.0; // Wall time spent planning
+};
+
+// Utility function to run work(index) for every index below count on up to threadCount
+// threads, each taking the next unclaimed index until none are left
+template <typename Work>
+void parallelFor(size_t count, unsigned threadCount, Work work) {
+    size_t workers = std::min<size_t>(threadCount, count);
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            work(i);
+        }
+        return;
+    }
+    std::atomic<size_t> nextIndex(0);
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers; ++w) {
+        threads.emplace_back([&]() {
+            for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+                work(i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// FleetRouter class
+// Capacitated vehicle routing from one depot. Stops are swept by angle around the depot
+// into trips no heavier than the largest transporter, each trip is given the cheapest
+// transporter that can carry it, and every trip is sequenced with RouteOptimizer. A local
+// search then relocates stops between neighbouring trips. Trips are sequenced, and disjoint
+// pairs of neighbouring trips are improved, on several threads at once.
+// Each transporter is one vehicle that runs its trips one after another from the depot, so
+// a transporter may serve several trips of a plan; the plan minimises distance cost, not
+// the time the trips take.
+class FleetRouter {
+private:
+    static const size_t improvementRounds = 4; // Relocate/re-sequence passes after the sweep
+    
+    RoutePoint depot;
+    GeoVector depotVector;
+    const std::vector<RoutePoint>* stops = nullptr;
+    std::vector<GeoVector> stopVectors; // Unit vectors of the stops
+    const std::vector<double>* loads = nullptr;
+    const std::deque<Transporter>* vehicles = nullptr;
+    unsigned threadCount = 1;
+
+    // Helper function to get the distance between two stops, or the depot when index is npos
+    double distance(size_t a, size_t b) const {
+        return geoDistance(a == npos ? depotVector : stopVectors[a], b == npos ? depotVector : stopVectors[b]);
+    }
+
+    // Helper function to get the depot-to-depot length of a trip
+    double routeDistance(const std::vector<size_t>& route) const {
+        if (route.empty()) {
+            return 0.0;
+        }
+        double total = distance(npos, route.front()) + distance(route.back(), npos);
+        for (size_t i = 0; i + 1 < route.size(); ++i) {
+            total += distance(route[i], route[i + 1]);
+        }
+        return total;
+    }
+
+    // Helper function to give a trip the cheapest transporter able to carry its load and refresh its cost
+    void assignVehicle(VehicleRoute& route) const {
+        size_t best = 0;
+        double bestRate = std::numeric_limits<double>::max();
+        for (size_t v = 0; v < vehicles->size(); ++v) {
+            const Transporter& vehicle = (*vehicles)[v];
+            if (vehicle.canTransport(route.load) && vehicle.getCostPerKm() < bestRate) {
+                bestRate = vehicle.getCostPerKm();
+                best = v;
+            }
+        }
+        route.vehicle = best;
+        route.distance = routeDistance(route.stops);
+        route.cost = (*vehicles)[best].calculateTransportCost(route.distance);
+    }
+
+    // Helper function to re-sequence the given trips in parallel, one RouteOptimizer per task
+    void sequenceRoutes(std::vector<VehicleRoute>& routes, const std::vector<size_t>& which) const {
+        parallelFor(which.size(), threadCount, [&](size_t k) {
+            VehicleRoute& route = routes[which[k]];
+            std::vector<RoutePoint> points;
+            points.reserve(route.stops.size());
+            for (size_t stop : route.stops) {
+                points.push_back((*stops)[stop]);
+            }
+            RouteOptimizer optimizer;
+            std::vector<size_t> order = optimizer.plan(depot, points);
+            std::vector<size_t> sequenced;
+            sequenced.reserve(order.size());
+            for (size_t index : order) {
+                sequenced.push_back(route.stops[index]);
+            }
+            route.stops.swap(sequenced);
+            route.distance = routeDistance(route.stops);
+        });
+    }
+
+    // Move stops from one trip into another while that lowers the combined cost.
+    // Returns the number of stops moved.
+    size_t relocateStops(VehicleRoute& from, VehicleRoute& to) const {
+        size_t moved = 0;
+        const Transporter& toVehicle = (*vehicles)[to.vehicle];
+        for (size_t i = 0; i < from.stops.size();) {
+            size_t stop = from.stops[i];
+            double stopLoad = (*loads)[stop];
+            if (!toVehicle.canTransport(to.load + stopLoad)) {
+                ++i;
+                continue;
+            }
+            size_t before = i == 0 ? npos : from.stops[i - 1];
+            size_t after = i + 1 == from.stops.size() ? npos : from.stops[i + 1];
+            double saving = distance(before, stop) + distance(stop, after) - distance(before, after);
+            
+            // Cheapest place to insert the stop into the other trip
+            double bestInsertion = std::numeric_limits<double>::max();
+            size_t bestSlot = 0;
+            for (size_t slot = 0; slot <= to.stops.size(); ++slot) {
+                size_t u = slot == 0 ? npos : to.stops[slot - 1];
+                size_t v = slot == to.stops.size() ? npos : to.stops[slot];
+                double insertion = distance(u, stop) + distance(stop, v) - distance(u, v);
+                if (insertion < bestInsertion) {
+                    bestInsertion = insertion;
+                    bestSlot = slot;
+                }
+            }
+            
+            double delta = toVehicle.calculateTransportCost(bestInsertion)
+                         - (*vehicles)[from.vehicle].calculateTransportCost(saving);
+            if (delta < -1e-9) {
+                from.stops.erase(from.stops.begin() + static_cast<std::ptrdiff_t>(i));
+                from.load -= stopLoad;
+                to.stops.insert(to.stops.begin() + static_cast<std::ptrdiff_t>(bestSlot), stop);
+                to.load += stopLoad;
+                moved++;
+            } else {
+                ++i;
+            }
+        }
+        return moved;
+    }
+
+public:
+    static const size_t npos = static_cast<size_t>(-1); // Stands for the depot in distance()
+
+    // Plan trips from the depot covering every stop, loads[i] being the load delivered to stops[i]
+    FleetPlan plan(const RoutePoint& depotPoint, const std::vector<RoutePoint>& stopPoints,
+                   const std::vector<double>& stopLoads, const std::deque<Transporter>& fleet,
+                   unsigned threads = 0) {
+        auto started = std::chrono::steady_clock::now();
+        depot = depotPoint;
+        depotVector = toGeoVector(depot.latitude, depot.longitude);
+        stops = &stopPoints;
+        stopVectors.resize(stopPoints.size());
+        for (size_t i = 0; i < stopPoints.size(); ++i) {
+            stopVectors[i] = toGeoVector(stopPoints[i].latitude, stopPoints[i].longitude);
+        }
+        loads = &stopLoads;
+        vehicles = &fleet;
+        threadCount = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        
+        FleetPlan result;
+        if (fleet.empty()) {
+            throw std::runtime_error("No vehicles available for routing");
+        }
+        const Transporter* largest = &fleet.front();
+        for (const auto& vehicle : fleet) {
+            if (vehicle.getMaxCapacity() > largest->getMaxCapacity()) {
+                largest = &vehicle;
+            }
+        }
+        
+        // 1. Sweep the stops by angle around the depot and cut trips at the largest capacity
+        std::vector<std::pair<double, size_t>> byAngle;
+        byAngle.reserve(stopPoints.size());
+        for (size_t i = 0; i < stopPoints.size(); ++i) {
+            if (!largest->canTransport(stopLoads[i])) {
+                result.unserved.push_back(i);
+                continue;
+            }
+            double angle = std::atan2(stopPoints[i].latitude - depot.latitude, stopPoints[i].longitude - depot.longitude);
+            byAngle.push_back({angle, i});
+        }
+        std::sort(byAngle.begin(), byAngle.end());
+        
+        std::vector<VehicleRoute>& routes = result.routes;
+        for (const auto& entry : byAngle) {
+            size_t stop = entry.second;
+            if (routes.empty() || !largest->canTransport(routes.back().load + stopLoads[stop])) {
+                routes.emplace_back();
+            }
+            routes.back().stops.push_back(stop);
+            routes.back().load += stopLoads[stop];
+        }
+        for (auto& route : routes) {
+            assignVehicle(route);
+        }
+        
+        // 2. Sequence every trip
+        std::vector<size_t> all(routes.size());
+        for (size_t i = 0; i < routes.size(); ++i) {
+            all[i] = i;
+        }
+        sequenceRoutes(routes, all);
+        
+        // 3. Relocate stops between neighbouring trips. Even pairs (0-1, 2-3, ...) and then odd
+        //    pairs (1-2, 3-4, ...) are disjoint, so each half runs in parallel.
+        for (size_t round = 0; round < improvementRounds && routes.size() > 1; ++round) {
+            std::vector<char> changed(routes.size(), 0);
+            std::atomic<size_t> moved(0);
+            for (size_t parity = 0; parity < 2; ++parity) {
+                size_t pairCount = (routes.size() - parity) / 2;
+                parallelFor(pairCount, threadCount, [&](size_t k) {
+                    size_t a = parity + 2 * k;
+                    size_t b = a + 1;
+                    size_t count = relocateStops(routes[a], routes[b]) + relocateStops(routes[b], routes[a]);
+                    if (count > 0) {
+                        changed[a] = changed[b] = 1;
+                        moved += count;
+                    }
+                });
+            }
+            if (moved == 0) {
+                break;
+            }
+            result.relocations += moved;
+            
+            std::vector<size_t> touched;
+            for (size_t i = 0; i < routes.size(); ++i) {
+                if (changed[i]) {
+                    touched.push_back(i);
+                }
+            }
+            sequenceRoutes(routes, touched);
+            for (size_t i : touched) {
+                assignVehicle(routes[i]);
+            }
+        }
+        
+        // 4. Drop trips emptied by the local search and total up
+        routes.erase(std::remove_if(routes.begin(), routes.end(),
+                                    [](const VehicleRoute& route) { return route.stops.empty(); }),
+                     routes.end());
+        for (const auto& route : routes) {
+            result.totalDistance += route.distance;
+            result.totalCost += route.cost;
+        }
+        result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        return result;
+    }
+};
+
+// Binary snapshot format
+// snapshot.bin stores every entity list and the next-ID counters in one file:
+//   SnapshotHeader | string table | product ID pool | product, supplier, retailer,
+//   transporter and transaction records
+// Numeric fields live in fixed-width records; names, locations and other text are stored
+// once in the string table and referenced by offset and length. Every section starts on an
+// 8-byte boundary. Values are written in the host byte order.
+const char snapshotMagic[8] = {'M', 'A', 'D', 'S', 'S', 'N', 'A', 'P'};
+const uint32_t snapshotVersion = 3; // Version 2 added journalSequence, version 3 binary transaction fields and indexes
+
+// Reference to a string in the snapshot string table
+struct SnapshotString {
+    uint32_t offset; // Byte offset into the string table
+    uint32_t length; // Length of the string in bytes
+};
+
+// Fixed header at the start of snapshot.bin
+struct SnapshotHeader {
+    char magic[8];          // Always snapshotMagic
+    uint32_t version;       // Format version, bumped whenever a record layout changes
+    uint32_t headerSize;    // sizeof(SnapshotHeader) when the file was written
+    int32_t nextIds[5];     // Next product, supplier, retailer, transporter and transaction IDs
+    uint32_t reserved;      // Keeps the counts below 8-byte aligned
+    uint64_t stringBytes;   // Size of the string table in bytes
+    uint64_t idPoolCount;   // Number of product IDs in the shared ID pool
+    uint64_t productCount;
+    uint64_t supplierCount;
+    uint64_t retailerCount;
+    uint64_t transporterCount;
+    uint64_t transactionCount;
+    uint64_t journalSequence; // Last journal record already contained in this snapshot
+    uint64_t indexSections;   // 1 if the history indexes, totals and forecasts follow the transactions
+};
+
+struct ProductRecord {
+    double price;
+    int32_t id;
+    int32_t stock;
+    SnapshotString name;
+};
+
+struct SupplierRecord {
+    double latitude;
+    double longitude;
+    int32_t id;
+    uint32_t productOffset; // First product ID in the ID pool
+    uint32_t productCount;  // Number of product IDs in the ID pool
+    uint32_t reserved;
+    SnapshotString name;
+    SnapshotString location;
+    SnapshotString branch;
+    uint32_t padding[2];
+};
+
+struct RetailerRecord {
+    double latitude;
+    double longitude;
+    double creditBalance;
+    double annualCreditBalance;
+    int32_t id;
+    uint32_t productOffset; // First product ID in the ID pool
+    uint32_t productCount;  // Number of product IDs in the ID pool
+    uint32_t reserved;
+    SnapshotString name;
+    SnapshotString location;
+};
+
+struct TransporterRecord {
+    double costPerKm;
+    double maxCapacity;
+    int32_t id;
+    uint32_t reserved;
+    SnapshotString name;
+    SnapshotString transportType;
+};
+
+// Transaction layout of versions 1 and 2, which kept the time, status and order type as text
+struct TransactionRecordV2 {
+    double productCost;
+    double transportCost;
+    double totalCost;
+    int32_t id;
+    int32_t supplierId;
+    int32_t retailerId;
+    int32_t productId;
+    int32_t transporterId;
+    int32_t quantity;
+    SnapshotString timestamp;
+    SnapshotString status;
+    SnapshotString orderType;
+};
+
+struct TransactionRecord {
+    double productCost;
+    double transportCost;
+    double totalCost;
+    int64_t timestamp; // Seconds since the epoch
+    int32_t id;
+    int32_t supplierId;
+    int32_t retailerId;
+    int32_t productId;
+    int32_t transporterId;
+    int32_t quantity;
+    uint8_t status;    // TransactionStatus
+    uint8_t orderType; // OrderType
+    uint8_t padding[6];
+};
+
+static_assert(sizeof(SnapshotHeader) == 112, "Snapshot header layout changed");
+static_assert(sizeof(ProductRecord) == 24, "Product record layout changed");
+static_assert(sizeof(SupplierRecord) == 64, "Supplier record layout changed");
+static_assert(sizeof(RetailerRecord) == 64, "Retailer record layout changed");
+static_assert(sizeof(TransporterRecord) == 40, "Transporter record layout changed");
+static_assert(sizeof(TransactionRecordV2) == 72, "Transaction record layout changed");
+static_assert(sizeof(TransactionRecord) == 64, "Transaction record layout changed");
+
+// SnapshotWriter class
+// Builds a snapshot image in memory so it can be written with a single call
+class SnapshotWriter {
+private:
+    std::string strings; // String table contents
+    std::unordered_map<std::string, SnapshotString> interned; // Strings already in the table
+    std::vector<int32_t> idPool; // Product ID lists of suppliers and retailers
+    std::string records; // Encoded records, in section order
+
+    // Helper function to pad a buffer to the next 8-byte boundary
+    static void align(std::string& buffer) {
+        while (buffer.size() % 8 != 0) {
+            buffer.push_back('\0');
+        }
+    }
+
+public:
+    // Store a string once and return its reference (repeated values such as status share one entry)
+    SnapshotString intern(const std::string& text) {
+        auto it = interned.find(text);
+        if (it != interned.end()) {
+            return it->second;
+        }
+        SnapshotString ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size())};
+        strings += text;
+        interned.emplace(text, ref);
+        return ref;
+    }
+
+    // Append a list of product IDs to the ID pool, returns the offset of the first entry
+    uint32_t addIds(const std::vector<int>& ids) {
+        uint32_t offset = static_cast<uint32_t>(idPool.size());
+        idPool.insert(idPool.end(), ids.begin(), ids.end());
+        return offset;
+    }
+
+    // Append a fixed-width record
+    template <typename Record>
+    void addRecord(const Record& record) {
+        records.append(reinterpret_cast<const char*>(&record), sizeof(Record));
+    }
+
+    // Append an array of fixed-width values
+    template <typename T>
+    void addArray(const T* values, size_t count) {
+        records.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+    }
+
+    // Pad the record area at the end of a section
+    void endSection() {
+        align(records);
+    }
+
+    // Hand over the encoded records alone, for sections written after the image from finish()
+    std::string takeRecords() {
+        return std::move(records);
+    }
+
+    // Assemble the final file image
+    std::string finish(SnapshotHeader header) {
+        header.stringBytes = strings.size();
+        header.idPoolCount = idPool.size();
+        
+        std::string image;
+        image.reserve(sizeof(header) + strings.size() + idPool.size() * sizeof(int32_t) + records.size() + 16);
+        image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        image += strings;
+        align(image);
+        image.append(reinterpret_cast<const char*>(idPool.data()), idPool.size() * sizeof(int32_t));
+        align(image);
+        image += records;
+        return image;
+    }
+};
+
+// SnapshotReader class
+// Walks a snapshot image that was mapped or read into memory in one go
+class SnapshotReader {
+private:
+    std::string_view buffer; // The whole snapshot file
+    size_t cursor; // Current read position
+    const char* strings; // Start of the string table
+    size_t stringBytes; // Size of the string table
+    std::vector<int32_t> idPool; // Decoded product ID pool
+
+    // Helper function to make sure the next bytes are inside the buffer
+    void require(size_t bytes) const {
+        if (cursor + bytes > buffer.size()) {
+            throw std::runtime_error("Snapshot file is truncated");
+        }
+    }
+
+    // Helper function to move the cursor to the next 8-byte boundary
+    void align() {
+        cursor = (cursor + 7) & ~static_cast<size_t>(7);
+    }
+
+public:
+    SnapshotHeader header; // Header of the snapshot being read
+
+    // Constructor validates the header and locates the string table and ID pool
+    explicit SnapshotReader(std::string_view data)
+        : buffer(data), cursor(0), strings(nullptr), stringBytes(0) {
+        // Version 1 headers stop before journalSequence and version 2 headers before
+        // indexSections; the missing fields then read as zero
+        const size_t version1HeaderSize = 96;
+        require(version1HeaderSize);
+        header = SnapshotHeader();
+        std::memcpy(&header, buffer.data(), version1HeaderSize);
+        if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0) {
+            throw std::runtime_error("Not a snapshot file");
+        }
+        const size_t version2HeaderSize = 104;
+        bool knownLayout = (header.version == 1 && header.headerSize == version1HeaderSize) ||
+                           (header.version == 2 && header.headerSize == version2HeaderSize) ||
+                           (header.version == snapshotVersion && header.headerSize == sizeof(SnapshotHeader));
+        if (!knownLayout) {
+            throw std::runtime_error("Unsupported snapshot version");
+        }
+        require(header.headerSize);
+        std::memcpy(&header, buffer.data(), header.headerSize);
+        cursor = header.headerSize;
+        
+        require(static_cast<size_t>(header.stringBytes));
+        strings = buffer.data() + cursor;
+        stringBytes = static_cast<size_t>(header.stringBytes);
+        cursor += stringBytes;
+        align();
+        
+        size_t idBytes = static_cast<size_t>(header.idPoolCount) * sizeof(int32_t);
+        require(idBytes);
+        idPool.resize(static_cast<size_t>(header.idPoolCount));
+        if (idBytes > 0) {
+            std::memcpy(idPool.data(), buffer.data() + cursor, idBytes);
+        }
+        cursor += idBytes;
+        align();
+    }
+
+    // Read the next fixed-width record
+    template <typename Record>
+    Record next() {
+        require(sizeof(Record));
+        Record record;
+        std::memcpy(&record, buffer.data() + cursor, sizeof(Record));
+        cursor += sizeof(Record);
+        return record;
+    }
+
+    // Read an array of fixed-width values
+    template <typename T>
+    void nextArray(std::vector<T>& values, size_t count) {
+        if (count > (buffer.size() - cursor) / sizeof(T)) {
+            throw std::runtime_error("Snapshot file is truncated");
+        }
+        values.resize(count);
+        if (count > 0) {
+            std::memcpy(values.data(), buffer.data() + cursor, count * sizeof(T));
+        }
+        cursor += count * sizeof(T);
+    }
+
+    // Skip padding at the end of a section
+    void endSection() {
+        align();
+    }
+
+    // Resolve a string table reference to a view into the snapshot image
+    std::string_view text(const SnapshotString& ref) const {
+        if (static_cast<size_t>(ref.offset) + ref.length > stringBytes) {
+            throw std::runtime_error("Snapshot string reference out of range");
+        }
+        return std::string_view(strings + ref.offset, ref.length);
+    }
+
+    // Resolve a range of the product ID pool without copying it
+    std::pair<const int32_t*, const int32_t*> ids(uint32_t offset, uint32_t count) const {
+        if (static_cast<size_t>(offset) + count > idPool.size()) {
+            throw std::runtime_error("Snapshot ID pool reference out of range");
+        }
+        return {idPool.data() + offset, idPool.data() + offset + count};
+    }
+};
+
+// Utility function to encode a transaction as its snapshot record
+TransactionRecord toSnapshotRecord(const Transaction& transaction) {
+    TransactionRecord record = {};
+    record.productCost = transaction.getProductCost();
+    record.transportCost = transaction.getTransportCost();
+    record.totalCost = transaction.getTotalCost();
+    record.id = transaction.getId();
+    record.supplierId = transaction.getSupplierId();
+    record.retailerId = transaction.getRetailerId();
+    record.productId = transaction.getProductId();
+    record.transporterId = transaction.getTransporterId();
+    record.quantity = transaction.getQuantity();
+    record.timestamp = transaction.getTimestamp();
+    record.status = static_cast<uint8_t>(transaction.getStatus());
+    record.orderType = static_cast<uint8_t>(transaction.getOrderType());
+    return record;
+}
+
+// SnapshotImage struct
+// A snapshot captured on the owning thread, ready to be written from another one. The
+// transaction history is not copied: stored transactions never change and the pool only
+// appends, so a view of its first records stays valid while new orders arrive.
+struct SnapshotImage {
+    std::string head; // Header, string table, ID pool and entity sections
+    RecordPool<Transaction>::Prefix transactions; // Transaction section, encoded while writing
+    std::string tail; // Index sections
+    uint64_t journalSequence = 0; // Last journal record the snapshot contains
+};
+
+// Utility function to write a captured snapshot, encoding the transaction section in 1 MB blocks
+bool writeSnapshotImage(const std::string& filename, const SnapshotImage& image) {
+    return writeFileReplacingWith(filename, [&image](std::ofstream& file) {
+        file.write(image.head.data(), static_cast<std::streamsize>(image.head.size()));
+        
+        const size_t blockRecords = (1 << 20) / sizeof(TransactionRecord);
+        std::vector<TransactionRecord> block;
+        block.reserve(std::min(blockRecords, image.transactions.size()));
+        for (size_t first = 0; first < image.transactions.size() && file; first += blockRecords) {
+            size_t last = std::min(first + blockRecords, image.transactions.size());
+            block.clear();
+            for (size_t i = first; i < last; ++i) {
+                block.push_back(toSnapshotRecord(image.transactions[i]));
+            }
+            file.write(reinterpret_cast<const char*>(block.data()),
+                       static_cast<std::streamsize>(block.size() * sizeof(TransactionRecord)));
+        }
+        
+        file.write(image.tail.data(), static_cast<std::streamsize>(image.tail.size()));
+    });
+}
+
+// SnapshotSaver class
+// Writer thread for checkpoint snapshots. One image is written at a time and at most one
+// more waits behind it; a newer capture replaces the waiting one, since it contains
+// everything the older one would have written. Finished writes are reported by collect().
+class SnapshotSaver {
+public:
+    struct Result {
+        std::string filename;
+        uint64_t journalSequence; // Last journal record the snapshot contains
+        uint64_t journalPosition; // Journal position given to submit
+        bool ok;
+    };
+
+private:
+    struct Job {
+        std::string filename;
+        SnapshotImage image;
+        uint64_t journalPosition;
+    };
+    
+    std::thread worker;
+    std::mutex stateMutex; // Guards everything below
+    std::condition_variable wake; // Wakes the writer
+    std::condition_variable idle; // Wakes threads waiting in settle()
+    std::unique_ptr<Job> waiting; // Next image to write
+    bool writing = false; // True while the writer holds an image
+    bool stopping = false;
+    std::vector<Result> finished; // Results not yet collected
+
+    // Writer thread body
+    void run() {
+        for (;;) {
+            std::unique_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                wake.wait(lock, [this]() { return waiting || stopping; });
+                if (!waiting) {
+                    return; // Stopping and nothing left to write
+                }
+                job = std::move(waiting);
+                writing = true;
+            }
+            
+            bool ok;
+            try {
+                ScopedTimer writeTimer(MetricId::SnapshotWrite);
+                ok = writeSnapshotImage(job->filename, job->image);
+            }
+            catch (const std::exception& e) {
+                ok = false;
+            }
+            
+            std::lock_guard<std::mutex> lock(stateMutex);
+            finished.push_back(Result{job->filename, job->image.journalSequence, job->journalPosition, ok});
+            writing = false;
+            idle.notify_all();
+        }
+    }
+
+public:
+    // Constructor to start the writer thread
+    SnapshotSaver() {
+        worker = std::thread(&SnapshotSaver::run, this);
+    }
+
+    SnapshotSaver(const SnapshotSaver&) = delete;
+    SnapshotSaver& operator=(const SnapshotSaver&) = delete;
+
+    // Destructor to finish the queued images and stop the writer thread
+    ~SnapshotSaver() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+            wake.notify_one();
+        }
+        worker.join();
+    }
+
+    // Queue an image to be written to filename; journalPosition is handed back with the result
+    void submit(const std::string& filename, SnapshotImage image, uint64_t journalPosition) {
+        std::unique_ptr<Job> job(new Job{filename, std::move(image), journalPosition});
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            waiting.swap(job); // An older image that has not started yet is dropped
+            wake.notify_one();
+        }
+    }
+
+    // Wait until every queued image is written
+    void settle() {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        idle.wait(lock, [this]() { return !waiting && !writing; });
+    }
+
+    // Take the results of the writes finished since the last call, oldest first
+    std::vector<Result> collect() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        std::vector<Result> results;
+        results.swap(finished);
+        return results;
+    }
+};
+
+// Write-ahead journal
+// journal.dat is an append-only log of every mutation made since the last checkpoint
+// snapshot. Each record is laid out as
+//   uint32 payload length | uint64 sequence | uint8 type | payload | uint32 checksum
+// and the snapshot header remembers the last sequence it already contains, so replaying
+// after a crash in the middle of a checkpoint never applies a record twice.
+enum class JournalRecordType : uint8_t {
+    AddProduct = 1,
+    AddSupplier = 2,
+    LinkSupplierProduct = 3,
+    AddRetailer = 4,
+    AddTransporter = 5,
+    TransactionText = 6, // Written by earlier versions, with the timestamp, status and order type as text
+    Transaction = 7
+};
+
+// JournalEncoder class
+// Builds the payload of one journal record
+class JournalEncoder {
+private:
+    std::string bytes; // Encoded payload
+
+public:
+    // Append a fixed-width value
+    template <typename T>
+    void put(const T& value) {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // Append a length-prefixed string
+    void putString(const std::string& text) {
+        put(static_cast<uint32_t>(text.size()));
+        bytes += text;
+    }
+
+    const std::string& data() const { return bytes; }
+};
+
+// JournalDecoder class
+// Reads the payload of one journal record
+class JournalDecoder {
+private:
+    const char* data; // Start of the payload
+    size_t size; // Payload size
+    size_t cursor; // Current read position
+
+public:
+    JournalDecoder(const char* payload, size_t length) : data(payload), size(length), cursor(0) {}
+
+    // Read a fixed-width value
+    template <typename T>
+    T get() {
+        if (cursor + sizeof(T) > size) {
+            throw std::runtime_error("Journal record is truncated");
+        }
+        T value;
+        std::memcpy(&value, data + cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    // Read a length-prefixed string as a view into the payload
+    std::string_view getString() {
+        uint32_t length = get<uint32_t>();
+        if (cursor + length > size) {
+            throw std::runtime_error("Journal record is truncated");
+        }
+        std::string_view text(data + cursor, length);
+        cursor += length;
+        return text;
+    }
+};
+
+// Utility function to compute an FNV-1a checksum over a byte range
+uint32_t fnv1a(const char* data, size_t length, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Journal class
+// Owns the open journal file and hands out record sequence numbers.
+// Records are staged in memory and written by flush(), so like before nothing reaches
+// disk until the operator saves.
+class Journal {
+private:
+    std::ofstream file; // Journal opened for appending, closed while detached
+    std::string pending; // Encoded records not yet written to the file
+    uint64_t lastSequence = 0; // Sequence number of the most recent record
+    size_t recordCount = 0; // Records appended since the last checkpoint
+    uint64_t fileBytes = 0; // Bytes in the journal file
+    uint64_t droppedBytes = 0; // Bytes cut from the front of the file by dropThrough()
+
+public:
+    // Attach to a journal file, continuing after the given sequence number
+    bool open(const std::string& filename, uint64_t sequence, size_t existingRecords) {
+        close();
+        file.open(filename, std::ios::binary | std::ios::app);
+        lastSequence = sequence;
+        recordCount = existingRecords;
+        file.seekp(0, std::ios::end);
+        fileBytes = file ? static_cast<uint64_t>(file.tellp()) : 0;
+        droppedBytes = 0;
+        return file.is_open();
+    }
+
+    // Start an empty journal after a checkpoint that contains everything up to the given sequence
+    bool reset(const std::string& filename, uint64_t sequence) {
+        close();
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        lastSequence = sequence;
+        recordCount = 0;
+        fileBytes = 0;
+        droppedBytes = 0;
+        return file.is_open();
+    }
+
+    // Start counting towards the next checkpoint, once a snapshot of the current state is taken
+    void markCheckpoint() {
+        recordCount = 0;
+    }
+
+    // Position after the last flushed record, counted from when the journal was opened or
+    // reset. Taken right after a flush, it marks the records a snapshot is about to contain.
+    uint64_t getPosition() const {
+        return droppedBytes + fileBytes;
+    }
+
+    // Cut the journal file back to the records after a position from getPosition(), once a
+    // snapshot containing everything before it is safely written. Records staged since
+    // are kept. The tail is copied to a new file; usually there is none.
+    bool dropThrough(const std::string& filename, uint64_t position) {
+        if (!file.is_open() || position <= droppedBytes) {
+            return file.is_open();
+        }
+        uint64_t cut = std::min(position - droppedBytes, fileBytes);
+        file.close();
+        
+        bool ok = true;
+        if (cut < fileBytes) {
+            std::string tail(static_cast<size_t>(fileBytes - cut), '\0');
+            std::ifstream in(filename, std::ios::binary);
+            in.seekg(static_cast<std::streamoff>(cut));
+            in.read(&tail[0], static_cast<std::streamsize>(tail.size()));
+            ok = in && writeFileReplacing(filename, tail);
+        } else {
+            std::ofstream truncated(filename, std::ios::binary | std::ios::trunc);
+            ok = truncated.is_open();
+        }
+        if (ok) {
+            fileBytes -= cut;
+            droppedBytes += cut;
+        }
+        file.open(filename, std::ios::binary | std::ios::app);
+        return ok && file.is_open();
+    }
+
+    // Detach from the journal; mutations are no longer logged until the next checkpoint
+    void close() {
+        if (file.is_open()) {
+            file.close();
+        }
+        pending.clear();
+    }
+
+    bool isOpen() const { return file.is_open(); }
+    uint64_t getLastSequence() const { return lastSequence; }
+    size_t getRecordCount() const { return recordCount; }
+
+    // Stage one record for the next flush
+    void append(JournalRecordType type, const JournalEncoder& payload) {
+        if (!file.is_open()) {
+            return;
+        }
+        const std::string& body = payload.data();
+        uint32_t length = static_cast<uint32_t>(body.size());
+        uint64_t sequence = ++lastSequence;
+        uint8_t typeByte = static_cast<uint8_t>(type);
+        
+        uint32_t checksum = fnv1a(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+        checksum = fnv1a(reinterpret_cast<const char*>(&typeByte), sizeof(typeByte), checksum);
+        checksum = fnv1a(body.data(), body.size(), checksum);
+        
+        pending.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        pending.append(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+        pending.append(reinterpret_cast<const char*>(&typeByte), sizeof(typeByte));
+        pending += body;
+        pending.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        recordCount++;
+    }
+
+    // Write staged records to the journal file in one call
+    bool flush() {
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+        file.flush();
+        fileBytes += pending.size();
+        pending.clear();
+        return static_cast<bool>(file);
+    }
+
+    // Read every intact record from a journal image, calling handler(type, decoder) for
+    // those after the given sequence. Stops at the first torn or corrupt record and
+    // returns the byte length of the intact prefix.
+    template <typename Handler>
+    static size_t replay(const std::vector<char>& buffer, uint64_t afterSequence, Handler handler,
+                         uint64_t& lastSequence, size_t& records) {
+        const size_t fixedBytes = sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint32_t);
+        size_t cursor = 0;
+        lastSequence = afterSequence;
+        records = 0;
+        
+        while (cursor + fixedBytes <= buffer.size()) {
+            const char* record = buffer.data() + cursor;
+            uint32_t length;
+            uint64_t sequence;
+            uint8_t typeByte;
+            std::memcpy(&length, record, sizeof(length));
+            if (cursor + fixedBytes + length > buffer.size()) {
+                break; // Torn record at the end of the file
+            }
+            std::memcpy(&sequence, record + 4, sizeof(sequence));
+            std::memcpy(&typeByte, record + 12, sizeof(typeByte));
+            const char* body = record + 13;
+            uint32_t storedChecksum;
+            std::memcpy(&storedChecksum, body + length, sizeof(storedChecksum));
+            
+            uint32_t checksum = fnv1a(record + 4, sizeof(sequence) + sizeof(typeByte));
+            checksum = fnv1a(body, length, checksum);
+            if (checksum != storedChecksum) {
+                break; // Corrupt record, nothing after it can be trusted
+            }
+            
+            if (sequence > afterSequence) {
+                JournalDecoder decoder(body, length);
+                handler(static_cast<JournalRecordType>(typeByte), decoder);
+                lastSequence = sequence;
+                records++;
+            }
+            cursor += fixedBytes + length;
+        }
+        return cursor;
+    }
+};
+
+// InventoryPlan struct
+// Demand-proportional stock allocation worked out for one product, by retailer slot
+struct InventoryPlan {
+    int productId = 0;
+    int totalStock = 0; // Stock on hand
+    long long totalDemand = 0; // Completed quantity in the history
+    std::vector<int> demand; // Completed quantity delivered to each retailer
+    std::vector<int> initialAllocation; // Allocation before scaling to the stock on hand
+    std::vector<int> allocation; // Final allocation
+    bool adjusted = false; // True if the initial allocation had to be scaled down
+    double currentHoldingCost = 0.0; // Holding cost of an equal split
+    double optimizedHoldingCost = 0.0; // Holding cost of the final allocation
+    double savings = 0.0;
+};
+
+// ScenarioSpec struct
+// One what-if scenario: the seasonal forecast orders replayed with another demand level,
+// contract thresholds and fleet
+struct ScenarioSpec {
+    std::string name; // Label in the scenario report
+    double demandMultiplier = 1.0; // Scales every order quantity
+    double priceThresholdScale = 1.0; // Scales the limit of every PriceThresholdContract
+    std::vector<int> transporterIds; // Transporters in the fleet, empty for all of them
+};
+
+// ScenarioResult struct
+// Outcome of one what-if scenario
+struct ScenarioResult {
+    size_t orders = 0; // Orders with a positive quantity after scaling
+    size_t completed = 0;
+    size_t failedContract = 0;
+    size_t failedCredit = 0;
+    size_t stockOuts = 0; // Orders refused for insufficient stock
+    size_t rejected = 0; // Orders without a known supplier, product or transporter in the fleet
+    long long unitsDelivered = 0;
+    double revenue = 0.0; // Total cost of the completed orders
+    double transportCost = 0.0; // Transport cost of the completed orders
+    size_t productsSoldOut = 0; // Products left without stock at the end
+    size_t pagesCopied = 0; // Copy-on-write pages of stock and credit the scenario changed
+
+    // Function to get the share of recorded orders that failed, as in the distribution report
+    double failureRate() const {
+        size_t recorded = completed + failedContract + failedCredit;
+        return recorded == 0 ? 0.0 : static_cast<double>(failedContract + failedCredit) / recorded;
+    }
+};
+
+// ScenarioOrder struct
+// A forecast order resolved to entity slots once, for every scenario to reuse
+struct ScenarioOrder {
+    int supplierSlot = -1;
+    int retailerSlot = -1;
+    int productSlot = -1;
+    int transporterSlot = -1; // -1 if the transporter is unknown
+    int quantity = 0; // Quantity before the scenario's demand multiplier
+    double distance = 0.0; // Supplier to retailer, in km
+    OrderType orderType = OrderType::Regular;
+    bool usable = false; // Known supplier, retailer and product, and the supplier stocks it
+};
+
+// ScenarioState struct
+// The state a scenario changes, forked copy-on-write from the live values
+struct ScenarioState {
+    CowColumn<int> stock; // By product slot
+    CowColumn<double> credit; // By retailer slot
+
+    // Function to fork the state for another scenario
+    ScenarioState fork() {
+        return ScenarioState{stock.fork(), credit.fork()};
+    }
+};
+
+// ProductionPlanningSystem class
+class ProductionPlanningSystem {
+    private:
+        // Entities live in deques so pointers returned by the find helpers stay valid as the lists grow
+        std::deque<Product> products; // List of products in the system
+        std::deque<Supplier> suppliers; // List of suppliers in the system
+        std::deque<Retailer> retailers; // List of retailers in the system
+        std::deque<Transporter> transporters; // List of transporters in the system
+        RecordPool<Transaction> transactions; // List of transactions in the system, in stable chunks
+        std::vector<std::unique_ptr<SmartContract>> contracts; // List of smart contracts in the system
+        Blockchain blockchain; // Blockchain instance to store transaction data
+        ChainWriter chainWriter; // Writer thread that appends every block to blockchain
+        Journal journal; // Write-ahead journal, attached after the first load or checkpoint
+        SnapshotSaver snapshotSaver; // Writer thread for checkpoints, declared after the data it views so it stops first
+        bool savedDataUnreadable = false; // Saved data is on disk but failed to load, so saves must not replace it
+        
+        // ID -> slot indexes kept in step with the lists above
+        IdIndex productIndex;
+        IdIndex supplierIndex;
+        IdIndex retailerIndex;
+        IdIndex transporterIndex;
+        IdIndex transactionIndex;
+        SupplyIndex supplyIndex; // Supplier <-> product links, by slot
+        TransactionColumns transactionColumns; // Columnar copy of transactions for the reports
+        FleetColumns fleetColumns; // Columnar copy of transporter rates for the order planner
+        ReportTotals reportTotals; // Running distribution report figures
+        TransactionHistoryIndex historyIndex; // Retailer, product and time indexes over transactions
+        DemandForecaster forecaster; // Per retailer and product demand forecasts
+        DistanceService distances; // Supplier -> retailer distances, by slot
+        ContractContext contractContext; // Entities visible to the smart contracts
+        ContractEngine contractEngine; // Compiled plan that validates order batches against the contracts
+        
+        int nextProductId; // Next available product ID
+        int nextSupplierId; // Next available supplier ID
+        int nextRetailerId; // Next available retailer ID
+        int nextTransporterId; // Next available transporter ID
+        std::atomic<int> nextTransactionId; // Next available transaction ID, assigned under ledgerMutex
+        
+        // Order processing may run on many threads at once. Stock and credit are only changed
+        // with the owning product's and retailer's stripe held (product stripe first, so two
+        // orders can never wait on each other), and the transaction history, journal and chain
+        // have a single writer at a time. Batches hold intakeGate shared while they run. Adding
+        // entities, loading and clearing hold it exclusive, so the lists and indexes a batch
+        // reads never change under it, and so do saves, so a save never sees an order whose stock and credit are
+        // applied but whose record is not yet journaled.
+        LockStripes productStripes;
+        LockStripes retailerStripes;
+        std::mutex ledgerMutex;
+        std::shared_mutex intakeGate;
+        
+        static const size_t ordersPerBlock = 256; // Maximum orders recorded in one batch block
+        static constexpr size_t simulationBatchSize = 4096; // Orders per createTransactions call in the simulation
+        static const size_t checkpointInterval = 10000; // Journal records before saveData compacts into a snapshot
+
+    // Helper function to resolve an ID through an index into its container
+    template <typename Container>
+    static typename Container::value_type* lookup(Container& items, const IdIndex& index, int id) {
+        int slot = index.find(id);
+        if (slot < 0) {
+            return nullptr; // ID not present in the index
+        }
+        return &items[static_cast<size_t>(slot)];
+    }
+
+    // Helper function to find entities by ID
+Product* findProduct(int id) {
+    return lookup(products, productIndex, id); // Return pointer to the product, nullptr if not found
+}
+
+Supplier* findSupplier(int id) {
+    return lookup(suppliers, supplierIndex, id); // Return pointer to the supplier, nullptr if not found
+}
+
+Retailer* findRetailer(int id) {
+    return lookup(retailers, retailerIndex, id); // Return pointer to the retailer, nullptr if not found
+}
+
+   // Helper function to find a transporter by ID
+Transporter* findTransporter(int id) {
+    return lookup(transporters, transporterIndex, id); // Return pointer to the transporter, nullptr if not found
+}
+
+// Helper function to find a transaction by ID
+Transaction* findTransaction(int id) {
+    return lookup(transactions, transactionIndex, id); // Return pointer to the transaction, nullptr if not found
+}
+
+// Helper function to append a transaction to the history and index it
+void storeTransaction(const Transaction& transaction) {
+    transactions.push_back(transaction);
+    transactionIndex.insert(transaction.getId(), transactions.size() - 1);
+    transactionColumns.append(transaction);
+    reportTotals.add(transaction);
+    historyIndex.add(transaction, transactions.size() - 1);
+    forecaster.observe(transaction);
+    
+    if (journal.isOpen()) {
+        JournalEncoder record;
+        record.put<int32_t>(transaction.getId());
+        record.put<int32_t>(transaction.getSupplierId());
+        record.put<int32_t>(transaction.getRetailerId());
+        record.put<int32_t>(transaction.getProductId());
+        record.put<int32_t>(transaction.getTransporterId());
+        record.put<int32_t>(transaction.getQuantity());
+        record.put(transaction.getProductCost());
+        record.put(transaction.getTransportCost());
+        record.put(transaction.getTotalCost());
+        record.put<int64_t>(transaction.getTimestamp()); // Seconds since the epoch, as in TransactionRecord
+        record.put(static_cast<uint8_t>(transaction.getStatus()));
+        record.put(static_cast<uint8_t>(transaction.getOrderType()));
+        journal.append(JournalRecordType::Transaction, record);
+    }
+}
+
+// Helper function to rebuild the ID indexes and per-slot copies, which take one linear pass
+void rebuildLookupIndexes() {
+    productIndex.rebuild(products);
+    supplierIndex.rebuild(suppliers);
+    retailerIndex.rebuild(retailers);
+    transporterIndex.rebuild(transporters);
+    fleetColumns.rebuild(transporters);
+    transactionIndex.rebuild(transactions);
+    supplyIndex.rebuild(suppliers, productIndex);
+    transactionColumns.rebuild(transactions);
+    distances.rebuild(suppliers, retailers);
+    contractEngine.invalidate();
+}
+
+// Helper function to rebuild every index from the current lists
+void rebuildIndexes() {
+    rebuildLookupIndexes();
+    reportTotals.rebuild(transactions);
+    historyIndex.rebuild(transactions);
+    forecaster.rebuild(transactions, historyIndex.between(-TransactionHistoryIndex::allTime, TransactionHistoryIndex::allTime));
+}
+
+// Helper function to drop every ID index
+void clearIndexes() {
+    productIndex.clear();
+    supplierIndex.clear();
+    retailerIndex.clear();
+    transporterIndex.clear();
+    fleetColumns.clear();
+    transactionIndex.clear();
+    supplyIndex.clear();
+    transactionColumns.clear();
+    reportTotals.clear();
+    historyIndex.clear();
+    forecaster.clear();
+    distances.clear();
+    contractEngine.invalidate();
+}
+
+public:
+    // How the system fills itself when constructed
+    enum class StartupMode {
+        SampleData, // Start from the built-in sample data
+        Resume      // Start from the saved data, or the sample data if nothing has been saved
+    };
+
+    // Constructor to initialize the production planning system
+    explicit ProductionPlanningSystem(StartupMode mode = StartupMode::SampleData) 
+        : chainWriter(blockchain, "blockchain.dat"),
+          contractContext{products, suppliers, retailers, transporters,
+                          productIndex, supplierIndex, retailerIndex, transporterIndex},
+          nextProductId(1), nextSupplierId(1), nextRetailerId(1), 
+          nextTransporterId(1), nextTransactionId(1) {
+        // Add default smart contract
+        addContract(std::make_unique<PriceThresholdContract>(4000.0));
+        
+        if (mode == StartupMode::Resume) {
+            auto start = std::chrono::steady_clock::now();
+            if (loadData()) {
+                double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "Resumed " << transactions.size() << " transactions and " << blockchain.size()
+                          << " blocks from saved data in " << std::fixed << std::setprecision(1)
+                          << elapsedMs << " ms" << std::endl;
+                return;
+            }
+            if (savedDataUnreadable) {
+                // Starting over would let the next save replace data that may still be recovered
+                throw std::runtime_error("saved data could not be loaded; the files were left as they are");
+            }
+            std::cerr << "No saved data to resume from, starting with sample data" << std::endl;
+            clearAllData(); // Drop whatever a partial load left behind
+        }
+        
+        // Initialize with sample data
+        loadSampleData();
+    }
+    
+    // Function to add a smart contract that every later order must satisfy
+    void addContract(std::unique_ptr<SmartContract> contract) {
+        std::unique_lock<std::shared_mutex> entityLock(intakeGate); // Batches validate against the list
+        contracts.push_back(std::move(contract));
+        contractEngine.invalidate();
+    }
+    
+    void loadSampleData() {
+        // Sample products
+        addProduct("Rice", 5.50, 1000); // Add product "Rice" with price 5.50 and stock 1000
+        addProduct("Vegetables", 3.20, 800); // Add product "Vegetables" with price 3.20 and stock 800
+        addProduct("Fruits", 4.75, 600); // Add product "Fruits" with price 4.75 and stock 600
+        
+        // Sample suppliers
+        addSupplier("Malayan Agro", "Lot 348, Kampung Datuk Keramat, 50400 Kuala Lumpur", 
+                   "Federal Territory of Kuala Lumpur", 3.168, 101.708); // Add supplier "Malayan Agro"
+        addSupplier("Farm Fresh Produce", "Jalan Tun Razak, 55000 Kuala Lumpur", 
+                   "Federal Territory of Kuala Lumpur", 3.161, 101.720); // Add supplier "Farm Fresh Produce"
+        
+        // Link products to suppliers
+        linkSupplierProduct(1, 1); // Add product ID 1 to supplier 1
+        linkSupplierProduct(1, 2); // Add product ID 2 to supplier 1
+        linkSupplierProduct(2, 2); // Add product ID 2 to supplier 2
+        linkSupplierProduct(2, 3); // Add product ID 3 to supplier 2
+        
+        // Sample retailers
+        addRetailer("SuperMart", "Bukit Bintang, 55100 Kuala Lumpur", 
+                   3.148, 101.698, 10000.0, 100000.0); // Add retailer "SuperMart"
+        addRetailer("FreshMart", "Petaling Jaya, 47800 Selangor", 
+                   3.107, 101.607, 8000.0, 80000.0); // Add retailer "FreshMart"
+        addRetailer("QuickMart", "Shah Alam, 40000 Selangor", 
+                   3.073, 101.518, 5000.0, 50000.0); // Add retailer "QuickMart"
+        
+        // Sample transporters
+        addTransporter("FastTruck", "Ordinary Ground Transfer", 2.50, 2000.0); // Add transporter "FastTruck"
+        addTransporter("SpeedyDel", "Express Delivery", 3.75, 1500.0); // Add transporter "SpeedyDel"
+        
+        // Create blockchain with genesis block
+        // Additional blocks will be added when transactions are created
+    }
+
+    // CRUD operations for products
+int addProduct(const std::string& name, double price, int stock) {
+    std::unique_lock<std::shared_mutex> entityLock(intakeGate); // No batch reads the lists while they change
+    try {
+        Product newProduct(nextProductId, name, price, stock); // Create a new product
+        products.push_back(newProduct); // Add the new product to the products list
+        productIndex.insert(newProduct.getId(), products.size() - 1); // Index the new product
+        
+        if (journal.isOpen()) {
+            JournalEncoder record;
+            record.put<int32_t>(newProduct.getId());
+            record.putString(name);
+            record.put(price);
+            record.put<int32_t>(stock);
+            journal.append(JournalRecordType::AddProduct, record);
+        }
+        
+        // Add to blockchain
+        std::string blockData = "Added Product | " + newProduct.toString(); // Prepare block data
+        chainWriter.submit(std::move(blockData)); // Add a new block to the blockchain
+        
+        return nextProductId++; // Return the product ID and increment the next available product ID
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error adding product: " << e.what() << std::endl; // Print error message
+        return -1; // Return -1 to indicate failure
+    }
+}
+
+void displayProducts() const {
+    std::cout << "\n===== PRODUCTS =====" << std::endl; // Print header
+    if (products.empty()) {
+        std::cout << "No products available." << std::endl; // Print message if no products
+        return;
+    }
+    
+    for (size_t p = 0; p < products.size(); ++p) {
+        std::cout << products[p].toString() << std::endl; // Print each product's details
+        
+        // Show the suppliers carrying it
+        std::cout << "  Suppliers: ";
+        const std::vector<int>& supplierSlots = supplyIndex.suppliersOf(p);
+        if (supplierSlots.empty()) {
+            std::cout << "None"; // Print message if no supplier carries the product
+        }
+        for (size_t i = 0; i < supplierSlots.size(); ++i) {
+            std::cout << (i > 0 ? ", " : "") << suppliers[supplierSlots[i]].getName();
+        }
+        std::cout << std::endl;
+    }
+}
+
+// CRUD operations for suppliers
+int addSupplier(const std::string& name, const std::string& location, 
+               const std::string& branch, double latitude, double longitude) {
+    std::unique_lock<std::shared_mutex> entityLock(intakeGate); // No batch reads the lists while they change
+    try {
+        Supplier newSupplier(nextSupplierId, name, location, branch, latitude, longitude); // Create a new supplier
+        suppliers.push_back(newSupplier); // Add the new supplier to the suppliers list
+        supplierIndex.insert(newSupplier.getId(), suppliers.size() - 1); // Index the new supplier
+        distances.setSupplier(suppliers.size() - 1, latitude, longitude);
+        
+        if (journal.isOpen()) {
+            JournalEncoder record;
+            record.put<int32_t>(newSupplier.getId());
+            record.putString(name);
+            record.putString(location);
+            record.putString(branch);
+            record.put(latitude);
+            record.put(longitude);
+            journal.append(JournalRecordType::AddSupplier, record);
+        }
+        
+        // Add to blockchain
+        std::string blockData = "Added Supplier | " + newSupplier.toString(); // Prepare block data
+        chainWriter.submit(std::move(blockData)); // Add a new block to the blockchain
+        
+        return nextSupplierId++; // Return the supplier ID and increment the next available supplier ID
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error adding supplier: " << e.what() << std::endl; // Print error message
+        return -1; // Return -1 to indicate failure
+    }
+}
+// Link a product to a supplier's list of supplied products (linking twice is a no-op)
+bool linkSupplierProduct(int supplierId, int productId) {
+    std::unique_lock<std::shared_mutex> entityLock(intakeGate); // No batch reads the lists while they change
+    return linkSupplierProductHeld(supplierId, productId);
+}
+
+// Same as linkSupplierProduct for a caller already holding intakeGate exclusive (journal replay)
+bool linkSupplierProductHeld(int supplierId, int productId) {
+    int supplierSlot = supplierIndex.find(supplierId);
+    int productSlot = productIndex.find(productId);
+    if (supplierSlot < 0 || productSlot < 0) {
+        return false; // Both the supplier and the product must exist
+    }
+    if (!supplyIndex.link(static_cast<size_t>(supplierSlot), static_cast<size_t>(productSlot))) {
+        return true; // Already linked
+    }
+    suppliers[supplierSlot].addProduct(productId);
+    
+    if (journal.isOpen()) {
+        JournalEncoder record;
+        record.put<int32_t>(supplierId);
+        record.put<int32_t>(productId);
+        journal.append(JournalRecordType::LinkSupplierProduct, record);
+    }
+    return true;
+}
 
-    // Static function to deserialize a transaction from a serialized string
-    static Transaction deserialize(const std::string& str) {
-        std::stringstream ss(str);
-        std::string item;
-        std::vector<std::string> parts;
-        
-        // Splitting the input string by '|' delimiter
-        while (std::getline(ss, item, '|')) {
-            parts.push_back(item);
+// Function to get the IDs of the suppliers carrying a product, empty if the product is unknown
+std::vector<int> suppliersOfProduct(int productId) const {
+    std::vector<int> supplierIds;
+    int productSlot = productIndex.find(productId);
+    if (productSlot >= 0) {
+        for (int supplierSlot : supplyIndex.suppliersOf(static_cast<size_t>(productSlot))) {
+            supplierIds.push_back(suppliers[supplierSlot].getId());
         }
+    }
+    return supplierIds;
+}
 
-        // Ensure the correct number of fields is present
-        if (parts.size() < 12) {
-            throw std::runtime_error("Invalid transaction data format");
+void displaySuppliers() const {
+    std::cout << "\n===== SUPPLIERS =====" << std::endl; // Print header
+    if (suppliers.empty()) {
+        std::cout << "No suppliers available." << std::endl; // Print message if no suppliers
+        return;
+    }
+    
+    for (const auto& supplier : suppliers) {
+        std::cout << supplier.toString() << std::endl; // Print each supplier's details
+        
+        // Show linked products
+        std::cout << "  Products: ";
+        const auto& productIds = supplier.getProductIds();
+        if (productIds.empty()) {
+            std::cout << "None"; // Print message if no products linked to supplier
+        } else {
+            for (size_t i = 0; i < productIds.size(); ++i) {
+                int productSlot = productIndex.find(productIds[i]);
+                if (productSlot >= 0) {
+                    std::cout << products[productSlot].getName(); // Print product name
+                }
+                if (i < productIds.size() - 1) {
+                    std::cout << ", "; // Print comma separator between product names
+                }
+            }
         }
+        std::cout << std::endl; // New line after listing products
+    }
+}
 
-        // Extract and convert data from string format
-        int id = std::stoi(parts[0]);
-        int supplierId = std::stoi(parts[1]);
-        int retailerId = std::stoi(parts[2]);
-        int productId = std::stoi(parts[3]);
-        int transporterId = std::stoi(parts[4]);
-        int quantity = std::stoi(parts[5]);
+// CRUD operations for retailers
+int addRetailer(const std::string& name, const std::string& location, 
+               double latitude, double longitude, double initialCredit, double annualCredit) {
+    std::unique_lock<std::shared_mutex> entityLock(intakeGate); // No batch reads the lists while they change
+    try {
+        Retailer newRetailer(nextRetailerId, name, location, latitude, longitude, initialCredit, annualCredit); // Create a new retailer
+        retailers.push_back(newRetailer); // Add the new retailer to the retailers list
+        retailerIndex.insert(newRetailer.getId(), retailers.size() - 1); // Index the new retailer
+        distances.setRetailer(retailers.size() - 1, latitude, longitude);
         
-        Transaction transaction(id, supplierId, retailerId, productId, transporterId, quantity);
+        if (journal.isOpen()) {
+            JournalEncoder record;
+            record.put<int32_t>(newRetailer.getId());
+            record.putString(name);
+            record.putString(location);
+            record.put(latitude);
+            record.put(longitude);
+            record.put(initialCredit);
+            record.put(annualCredit);
+            journal.append(JournalRecordType::AddRetailer, record);
+        }
         
-        transaction.setProductCost(std::stod(parts[6]));
-        transaction.setTransportCost(std::stod(parts[7]));
-        transaction.totalCost = std::stod(parts[8]);
-        transaction.timestamp = parts[9];
-        transaction.status = parts[10];
-        transaction.orderType = parts[11];
+        // Add to blockchain
+        std::string blockData = "Added Retailer | " + newRetailer.toString(); // Prepare block data
+        chainWriter.submit(std::move(blockData)); // Add a new block to the blockchain
         
-        return transaction;
+        return nextRetailerId++; // Return the retailer ID and increment the next available retailer ID
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error adding retailer: " << e.what() << std::endl; // Print error message
+        return -1; // Return -1 to indicate failure
+    }
+}
+void displayRetailers() const {
+    std::cout << "\n===== RETAILERS =====" << std::endl; // Print header
+    if (retailers.empty()) {
+        std::cout << "No retailers available." << std::endl; // Print message if no retailers
+        return;
     }
-};
-
-// PriceThresholdContract class
-class PriceThresholdContract : public SmartContract {
-    private:
-        double maxAllowedCost; // Maximum allowed cost for a transaction
-    
-    public:
-        // Constructor to initialize the contract with a cost threshold
-        PriceThresholdContract(double threshold) : maxAllowedCost(threshold) {}
-    
-        // Override the validate function to check if the transaction cost is within the allowed limit
-        bool validate(const Transaction& transaction) const override {
-            return transaction.getTotalCost() <= maxAllowedCost; // Return true if the transaction cost is within the limit
-        }
     
-        // Override the getDescription function to provide a description of the contract
-        std::string getDescription() const override {
-            std::stringstream ss;
-            ss << "Price Threshold Contract: Maximum allowed cost is RM" 
-               << std::fixed << std::setprecision(2) << maxAllowedCost; // Format the description with the cost threshold
-            return ss.str(); // Return the description as a string
-        }
-    };
+    for (const auto& retailer : retailers) {
+        std::cout << retailer.toString() << std::endl; // Print each retailer's details
+    }
+}
 
-// ProductionPlanningSystem class
-class ProductionPlanningSystem {
-    private:
-        std::vector<Product> products; // List of products in the system
-        std::vector<Supplier> suppliers; // List of suppliers in the system
-        std::vector<Retailer> retailers; // List of retailers in the system
-        std::vector<Transporter> transporters; // List of transporters in the system
-        std::vector<Transaction> transactions; // List of transactions in the system
-        std::vector<SmartContract*> contracts; // List of smart contracts in the system
-        Blockchain blockchain; // Blockchain instance to store transaction data
+// CRUD operations for transporters
+int addTransporter(const std::string& name, const std::string& type, 
+                 double costPerKm, double capacity) {
+    std::unique_lock<std::shared_mutex> entityLock(intakeGate); // No batch reads the lists while they change
+    try {
+        Transporter newTransporter(nextTransporterId, name, type, costPerKm, capacity); // Create a new transporter
+        transporters.push_back(newTransporter); // Add the new transporter to the transporters list
+        transporterIndex.insert(newTransporter.getId(), transporters.size() - 1); // Index the new transporter
+        fleetColumns.add(newTransporter);
         
-        int nextProductId; // Next available product ID
-        int nextSupplierId; // Next available supplier ID
-        int nextRetailerId; // Next available retailer ID
-        int nextTransporterId; // Next available transporter ID
-        int nextTransactionId; // Next available transaction ID
-
-    // Helper function to find entities by ID
-Product* findProduct(int id) {
-    for (auto& product : products) {
-        if (product.getId() == id) {
-            return &product; // Return pointer to the product if found
+        if (journal.isOpen()) {
+            JournalEncoder record;
+            record.put<int32_t>(newTransporter.getId());
+            record.putString(name);
+            record.putString(type);
+            record.put(costPerKm);
+            record.put(capacity);
+            journal.append(JournalRecordType::AddTransporter, record);
         }
+        
+        // Add to blockchain
+        std::string blockData = "Added Transporter | " + newTransporter.toString(); // Prepare block data
+        chainWriter.submit(std::move(blockData)); // Add a new block to the blockchain
+        
+        return nextTransporterId++; // Return the transporter ID and increment the next available transporter ID
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error adding transporter: " << e.what() << std::endl; // Print error message
+        return -1; // Return -1 to indicate failure
     }
-    return nullptr; // Return nullptr if product not found
 }
 
-Supplier* findSupplier(int id) {
-    for (auto& supplier : suppliers) {
-        if (supplier.getId() == id) {
-            return &supplier; // Return pointer to the supplier if found
-        }
+void displayTransporters() const {
+    std::cout << "\n===== TRANSPORTERS =====" << std::endl; // Print header
+    if (transporters.empty()) {
+        std::cout << "No transporters available." << std::endl; // Print message if no transporters
+        return;
+    }
+    
+    for (const auto& transporter : transporters) {
+        std::cout << transporter.toString() << std::endl; // Print each transporter's details
     }
-    return nullptr; // Return nullptr if supplier not found
 }
-
-Retailer* findRetailer(int id) {
-    for (auto& retailer : retailers) {
-        if (retailer.getId() == id) {
-            return &retailer; // Return pointer to the retailer if found
+    // Transaction operations
+int createTransaction(int supplierId, int retailerId, int productId, int transporterId, int quantity, OrderType orderType = OrderType::Regular) {
+    try {
+        OrderRequest order{supplierId, retailerId, productId, transporterId, quantity, orderType};
+        OrderResult result = createTransactions(&order, 1)[0]; // Process as a batch of one
+        
+        switch (result.outcome) {
+            case OrderOutcome::Completed:
+                break;
+            case OrderOutcome::FailedContract:
+                std::cout << "Transaction failed validation: " << contracts[result.contractIndex]->getDescription() << std::endl;
+                break;
+            case OrderOutcome::FailedCredit:
+                std::cout << "Transaction failed: Insufficient retailer credit" << std::endl;
+                break;
+            default:
+                std::cerr << "Error creating transaction: " << orderOutcomeToString(result.outcome) << std::endl;
+                break;
         }
+        
+        return result.transactionId;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error creating transaction: " << e.what() << std::endl;
+        return -1;
     }
-    return nullptr; // Return nullptr if retailer not found
 }
 
-   // Helper function to find a transporter by ID
-Transporter* findTransporter(int id) {
-    for (auto& transporter : transporters) {
-        if (transporter.getId() == id) {
-            return &transporter; // Return pointer to the transporter if found
+// Order planner
+// Prices every supplier carrying the product against every transporter that can carry the
+// quantity (one unit taken as 1kg) and keeps the cheapest pair that passes the smart
+// contracts. Costs are computed as a supplier x transporter grid over contiguous arrays; the
+// contract plan then checks the cheapest candidates first, a round at a time, so a typical
+// order only validates the first round. A supplier or transporter slot of -1 lets the
+// planner choose that side; a pinned one is used as given.
+// The caller holds intakeGate shared (createTransactions, planOrder), so the entity lists and
+// indexes it walks do not change under it; many threads may plan at once.
+bool planSource(size_t retailerSlot, size_t productSlot, int supplierSlot, int transporterSlot, int quantity,
+                SourcePlan& plan) {
+    ScopedTimer planTimer(MetricId::OrderPlan);
+    plan = SourcePlan();
+    
+    std::vector<int> supplierSlots;
+    if (supplierSlot >= 0) {
+        supplierSlots.push_back(supplierSlot);
+    } else {
+        supplierSlots = supplyIndex.suppliersOf(productSlot);
+    }
+    std::vector<int> transporterSlots;
+    std::vector<double> costsPerKm;
+    transporterSlots.reserve(fleetColumns.capacities.size());
+    costsPerKm.reserve(fleetColumns.capacities.size());
+    if (transporterSlot >= 0) {
+        transporterSlots.push_back(transporterSlot);
+        costsPerKm.push_back(fleetColumns.costsPerKm[transporterSlot]);
+    } else {
+        const double weight = quantity; // As Transporter::canTransport, over the fleet columns
+        for (size_t t = 0; t < fleetColumns.capacities.size(); ++t) {
+            if (weight <= fleetColumns.capacities[t]) {
+                transporterSlots.push_back(static_cast<int>(t));
+                costsPerKm.push_back(fleetColumns.costsPerKm[t]);
+            }
         }
     }
-    return nullptr; // Return nullptr if transporter not found
-}
-
-// Helper function to find a transaction by ID
-Transaction* findTransaction(int id) {
-    for (auto& transaction : transactions) {
-        if (transaction.getId() == id) {
-            return &transaction; // Return pointer to the transaction if found
+    size_t supplierCount = supplierSlots.size();
+    size_t transporterCount = transporterSlots.size();
+    size_t candidateCount = supplierCount * transporterCount;
+    plan.candidates = candidateCount;
+    if (candidateCount == 0) {
+        return false;
+    }
+    
+    // Price the grid, one row of transporters per supplier
+    std::vector<double> supplierDistances(supplierCount);
+    distances.suppliersToRetailer(supplierSlots.data(), supplierCount, retailerSlot, supplierDistances.data());
+    double productCost = products[productSlot].getPrice() * quantity;
+    std::vector<double> totalCosts(candidateCount);
+    for (size_t s = 0; s < supplierCount; ++s) {
+        double distance = supplierDistances[s];
+        double* row = totalCosts.data() + s * transporterCount;
+        for (size_t t = 0; t < transporterCount; ++t) {
+            row[t] = productCost + distance * costsPerKm[t];
+        }
+    }
+    
+    // Validate the cheapest candidates first; ties go to the lower slots. The first round is
+    // the cheapest candidate alone, found with a plain scan, as it usually passes. Later
+    // rounds select the next cheapest out of the unchecked rest, four times as many each round.
+    std::vector<uint32_t> ranking;
+    auto cheaper = [&totalCosts](uint32_t a, uint32_t b) {
+        return totalCosts[a] < totalCosts[b] || (totalCosts[a] == totalCosts[b] && a < b);
+    };
+    const int retailerId = retailers[retailerSlot].getId();
+    const int productId = products[productSlot].getId();
+    RuleBatch batch;
+    std::vector<Transaction> candidates;
+    std::vector<short> failedContract;
+    size_t roundSize = 1;
+    for (size_t begin = 0; begin < candidateCount; begin += roundSize, roundSize *= 4) {
+        size_t end = std::min(candidateCount, begin + roundSize);
+        if (begin == 0) {
+            ranking.push_back(static_cast<uint32_t>(positionOfMinimum(totalCosts.data(), candidateCount)));
+        } else {
+            if (ranking.size() == 1) {
+                uint32_t checked = ranking[0];
+                ranking.resize(candidateCount);
+                std::iota(ranking.begin(), ranking.end(), 0u);
+                std::swap(ranking[0], ranking[checked]); // Keep the candidate already checked in front
+            }
+            auto first = ranking.begin() + static_cast<std::ptrdiff_t>(begin);
+            auto last = ranking.begin() + static_cast<std::ptrdiff_t>(end) - 1; // Most expensive of the round
+            std::nth_element(first, last, ranking.end(), cheaper);
+            std::sort(first, last, cheaper);
+        }
+        batch.clear();
+        candidates.clear();
+        for (size_t k = begin; k < end; ++k) {
+            size_t s = ranking[k] / transporterCount;
+            size_t t = ranking[k] % transporterCount;
+            Transaction candidate(0, suppliers[supplierSlots[s]].getId(), retailerId, productId,
+                                  transporters[transporterSlots[t]].getId(), quantity);
+            candidate.setProductCost(productCost);
+            candidate.setTransportCost(transporters[transporterSlots[t]].calculateTransportCost(supplierDistances[s]));
+            candidate.calculateTotalCost();
+            batch.append(candidate, supplierSlots[s], static_cast<int>(retailerSlot), static_cast<int>(productSlot), transporterSlots[t]);
+            candidates.push_back(candidate);
+        }
+        contractEngine.validate(contracts, contractContext, batch, candidates, failedContract);
+        for (size_t k = 0; k < candidates.size(); ++k) {
+            if (failedContract[k] < 0) {
+                const Transaction& chosen = candidates[k];
+                plan.supplierId = chosen.getSupplierId();
+                plan.transporterId = chosen.getTransporterId();
+                plan.distance = supplierDistances[ranking[begin + k] / transporterCount];
+                plan.productCost = chosen.getProductCost();
+                plan.transportCost = chosen.getTransportCost();
+                plan.totalCost = chosen.getTotalCost();
+                return true;
+            }
         }
     }
-    return nullptr; // Return nullptr if transaction not found
+    return false; // Every candidate fails a contract
 }
 
-public:
-    // Constructor to initialize the production planning system
-    ProductionPlanningSystem() 
-        : nextProductId(1), nextSupplierId(1), nextRetailerId(1), 
-          nextTransporterId(1), nextTransactionId(1) {
-        // Add default smart contract
-        contracts.push_back(new PriceThresholdContract(4000.0));
-        
-        // Initialize with sample data
-        loadSampleData();
-    }
-    ~ProductionPlanningSystem() {
-        // Destructor to clean up dynamically allocated smart contracts
-        for (auto contract : contracts) {
-            delete contract; // Delete each smart contract to free memory
-        }
+// Function to find the cheapest supplier and transporter for an order that passes the
+// smart contracts, returns false if there is none. Safe to call from many threads at once.
+bool planOrder(int retailerId, int productId, int quantity, SourcePlan& plan) {
+    std::shared_lock<std::shared_mutex> intakeLock(intakeGate); // Entities are not added while planning
+    int retailerSlot = retailerIndex.find(retailerId);
+    int productSlot = productIndex.find(productId);
+    if (retailerSlot < 0 || productSlot < 0) {
+        plan = SourcePlan();
+        return false;
     }
+    return planSource(static_cast<size_t>(retailerSlot), static_cast<size_t>(productSlot), -1, -1, quantity, plan);
+}
+
+// Batch transaction ingestion
+// Validates the whole batch against the smart contracts in one pass, applies stock and
+// credit changes in submission order and records the batch as a run of blocks.
+// Nothing is printed; the caller gets one OrderResult per order instead.
+// Safe to call from many threads at once, and alongside entity adds, loads and resets,
+// which wait for running batches to finish.
+std::vector<OrderResult> createTransactions(const OrderRequest* orders, size_t count) {
+    std::shared_lock<std::shared_mutex> intakeLock(intakeGate); // Held until the batch is journaled
+    std::vector<OrderResult> results(count, OrderResult{-1, OrderOutcome::Completed, -1});
     
-    void loadSampleData() {
-        // Sample products
-        addProduct("Rice", 5.50, 1000); // Add product "Rice" with price 5.50 and stock 1000
-        addProduct("Vegetables", 3.20, 800); // Add product "Vegetables" with price 3.20 and stock 800
-        addProduct("Fruits", 4.75, 600); // Add product "Fruits" with price 4.75 and stock 600
-        
-        // Sample suppliers
-        addSupplier("Malayan Agro", "Lot 348, Kampung Datuk Keramat, 50400 Kuala Lumpur", 
-                   "Federal Territory of Kuala Lumpur", 3.168, 101.708); // Add supplier "Malayan Agro"
-        addSupplier("Farm Fresh Produce", "Jalan Tun Razak, 55000 Kuala Lumpur", 
-                   "Federal Territory of Kuala Lumpur", 3.161, 101.720); // Add supplier "Farm Fresh Produce"
+    // Orders that passed entity checks and have been priced
+    std::vector<Transaction> pending;
+    std::vector<size_t> pendingOrder; // Index into orders for each pending transaction
+    std::vector<Product*> pendingProduct;
+    std::vector<Retailer*> pendingRetailer;
+    RuleBatch ruleBatch; // Columns of the pending orders read by the contract plan
+    pending.reserve(count);
+    pendingOrder.reserve(count);
+    pendingProduct.reserve(count);
+    pendingRetailer.reserve(count);
+    ruleBatch.reserve(count);
+    
+    // 1. Resolve entities and price every order
+    ScopedTimer resolveTimer(MetricId::OrderResolve);
+    for (size_t i = 0; i < count; ++i) {
+        const OrderRequest& order = orders[i];
+        bool autoSupplier = order.supplierId == autoSource;
+        bool autoTransporter = order.transporterId == autoSource;
+        int supplierSlot = autoSupplier ? -1 : supplierIndex.find(order.supplierId);
+        int retailerSlot = retailerIndex.find(order.retailerId);
+        int productSlot = productIndex.find(order.productId);
+        int transporterSlot = autoTransporter ? -1 : transporterIndex.find(order.transporterId);
         
-        // Link products to suppliers
-        Supplier* s1 = findSupplier(1); // Find supplier with ID 1
-        Supplier* s2 = findSupplier(2); // Find supplier with ID 2
+        if (supplierSlot < 0 && !autoSupplier) {
+            results[i].outcome = OrderOutcome::UnknownSupplier;
+            continue;
+        }
+        if (retailerSlot < 0) {
+            results[i].outcome = OrderOutcome::UnknownRetailer;
+            continue;
+        }
+        if (productSlot < 0) {
+            results[i].outcome = OrderOutcome::UnknownProduct;
+            continue;
+        }
+        if (transporterSlot < 0 && !autoTransporter) {
+            results[i].outcome = OrderOutcome::UnknownTransporter;
+            continue;
+        }
         
-        if (s1) {
-            s1->addProduct(1); // Add product ID 1 to supplier 1
-            s1->addProduct(2); // Add product ID 2 to supplier 1
+        // Check if supplier has this product
+        if (!autoSupplier && !supplyIndex.supplies(static_cast<size_t>(supplierSlot), static_cast<size_t>(productSlot))) {
+            results[i].outcome = OrderOutcome::ProductNotSupplied;
+            continue;
         }
         
-        if (s2) {
-            s2->addProduct(2); // Add product ID 2 to supplier 2
-            s2->addProduct(3); // Add product ID 3 to supplier 2
+        // Let the planner fill in the automatic side(s) with the cheapest eligible source
+        if (autoSupplier || autoTransporter) {
+            SourcePlan plan;
+            if (!planSource(static_cast<size_t>(retailerSlot), static_cast<size_t>(productSlot), supplierSlot,
+                            transporterSlot, order.quantity, plan)) {
+                results[i].outcome = OrderOutcome::NoEligibleSource;
+                continue;
+            }
+            supplierSlot = supplierIndex.find(plan.supplierId);
+            transporterSlot = transporterIndex.find(plan.transporterId);
         }
+        Retailer* retailer = &retailers[retailerSlot];
+        Product* product = &products[productSlot];
+        Transporter* transporter = &transporters[transporterSlot];
         
-        // Sample retailers
-        addRetailer("SuperMart", "Bukit Bintang, 55100 Kuala Lumpur", 
-                   3.148, 101.698, 10000.0, 100000.0); // Add retailer "SuperMart"
-        addRetailer("FreshMart", "Petaling Jaya, 47800 Selangor", 
-                   3.107, 101.607, 8000.0, 80000.0); // Add retailer "FreshMart"
-        addRetailer("QuickMart", "Shah Alam, 40000 Selangor", 
-                   3.073, 101.518, 5000.0, 50000.0); // Add retailer "QuickMart"
+        // Calculate distance, product and transport cost
+        double distance = distances.supplierToRetailer(static_cast<size_t>(supplierSlot), static_cast<size_t>(retailerSlot));
         
-        // Sample transporters
-        addTransporter("FastTruck", "Ordinary Ground Transfer", 2.50, 2000.0); // Add transporter "FastTruck"
-        addTransporter("SpeedyDel", "Express Delivery", 3.75, 1500.0); // Add transporter "SpeedyDel"
+        // The ID is assigned once the order is stored in step 4
+        Transaction transaction(0, suppliers[supplierSlot].getId(), order.retailerId, order.productId,
+                                transporter->getId(), order.quantity);
+        transaction.setProductCost(product->getPrice() * order.quantity);
+        transaction.setTransportCost(transporter->calculateTransportCost(distance));
+        transaction.calculateTotalCost();
+        transaction.setOrderType(order.orderType);
         
-        // Create blockchain with genesis block
-        // Additional blocks will be added when transactions are created
+        pending.push_back(transaction);
+        pendingOrder.push_back(i);
+        pendingProduct.push_back(product);
+        pendingRetailer.push_back(retailer);
+        ruleBatch.append(transaction, supplierSlot, retailerSlot, productSlot, transporterSlot);
+    }
+    resolveTimer.stop();
+    
+    // 2. Validate the batch column-wise against the compiled contract plan, remembering the
+    //    first contract each order fails
+    std::vector<short> failedContract;
+    {
+        ScopedTimer validateTimer(MetricId::OrderValidate);
+        contractEngine.validate(contracts, contractContext, ruleBatch, pending, failedContract);
+    }
+    
+    // 3. Apply stock and credit changes in submission order. The stock check, credit
+    //    deduction and stock deduction of an order happen under its product and retailer
+    //    stripes, so concurrent orders never see half of an order applied.
+    ScopedTimer applyTimer(MetricId::OrderApply);
+    std::vector<Transaction> accepted;
+    std::vector<const char*> blockLabels; // Block entry label of each accepted transaction
+    std::vector<size_t> acceptedOrder; // Index into orders for each accepted transaction
+    accepted.reserve(pending.size());
+    blockLabels.reserve(pending.size());
+    acceptedOrder.reserve(pending.size());
+    for (size_t k = 0; k < pending.size(); ++k) {
+        OrderResult& result = results[pendingOrder[k]];
+        Transaction& transaction = pending[k];
+        Product* product = pendingProduct[k];
+        const char* label;
+        {
+            std::lock_guard<std::mutex> productLock(productStripes.forId(product->getId()));
+            
+            // Check product stock against what earlier orders left behind
+            if (!product->hasEnoughStock(transaction.getQuantity())) {
+                result.outcome = OrderOutcome::InsufficientStock;
+                continue;
+            }
+            
+            if (failedContract[k] >= 0) {
+                transaction.setStatus(TransactionStatus::Failed);
+                result.outcome = OrderOutcome::FailedContract;
+                result.contractIndex = failedContract[k];
+                label = "Failed Transaction | ";
+            } else {
+                std::lock_guard<std::mutex> retailerLock(retailerStripes.forId(pendingRetailer[k]->getId()));
+                if (!pendingRetailer[k]->deductCredit(transaction.getTotalCost())) {
+                    transaction.setStatus(TransactionStatus::Failed);
+                    result.outcome = OrderOutcome::FailedCredit;
+                    label = "Failed Transaction (Credit) | ";
+                } else {
+                    product->updateStock(-transaction.getQuantity());
+                    transaction.setStatus(TransactionStatus::Completed);
+                    result.outcome = OrderOutcome::Completed;
+                    label = "Completed Transaction | ";
+                }
+            }
+        }
+        
+        blockLabels.push_back(label);
+        accepted.push_back(transaction);
+        acceptedOrder.push_back(pendingOrder[k]);
+    }
+    
+    applyTimer.stop();
+    
+    // 4. Number, store and record the batch on the blockchain, one writer at a time, so
+    //    transactions, journal records and blocks all follow ID order
+    {
+        std::lock_guard<std::mutex> ledgerLock(ledgerMutex);
+        ScopedTimer storeTimer(MetricId::OrderStore);
+        for (size_t k = 0; k < accepted.size(); ++k) {
+            accepted[k].setId(nextTransactionId++);
+            results[acceptedOrder[k]].transactionId = accepted[k].getId();
+            storeTransaction(accepted[k]);
+        }
+        appendBatchBlocks(accepted, blockLabels);
     }
+    
+    return results;
+}
 
-    // CRUD operations for products
-int addProduct(const std::string& name, double price, int stock) {
+// Convenience overload of the batch ingestion API for a vector of orders
+std::vector<OrderResult> createTransactions(const std::vector<OrderRequest>& orders) {
+    return createTransactions(orders.data(), orders.size());
+}
+
+// Helper function to write accepted transactions as a run of blocks, up to ordersPerBlock
+// entries each. A batch with a single entry is written exactly like a standalone
+// transaction block. Each payload is formatted straight into one string and moved to the
+// writer, so no per-entry strings are built.
+void appendBatchBlocks(const std::vector<Transaction>& entries, const std::vector<const char*>& labels) {
+    if (entries.empty()) {
+        return;
+    }
+    if (entries.size() == 1) {
+        std::string blockData = labels[0];
+        entries[0].appendBlockData(blockData);
+        chainWriter.submit(std::move(blockData));
+        return;
+    }
+    
+    const size_t entryLengthHint = 224; // Typical label plus block data length of one order
+    for (size_t start = 0; start < entries.size(); start += ordersPerBlock) {
+        size_t end = std::min(entries.size(), start + ordersPerBlock);
+        
+        std::string blockData;
+        blockData.reserve(32 + (end - start) * entryLengthHint);
+        blockData += "Transaction Batch | Orders: ";
+        blockData += std::to_string(end - start);
+        for (size_t i = start; i < end; ++i) {
+            blockData += " || "; // Separator between orders in one block
+            blockData += labels[i];
+            entries[i].appendBlockData(blockData);
+        }
+        chainWriter.submit(std::move(blockData));
+    }
+}
+void displayTransactions() const {
+    std::cout << "\n===== TRANSACTIONS =====" << std::endl; // Print header
+    if (transactions.empty()) {
+        std::cout << "No transactions available." << std::endl; // Print message if no transactions
+        return;
+    }
+    
+    for (const auto& transaction : transactions) {
+        std::cout << transaction.toString() << std::endl; // Print each transaction's details
+        std::cout << "--------------------------------------" << std::endl; // Separator line
+    }
+}
+
+// History query API
+// Each query returns the matching transactions in time order; from and to are inclusive
+// epoch times. The pointers stay valid until the history is reloaded or reset.
+std::vector<const Transaction*> queryRetailerTransactions(int retailerId, int64_t from = -TransactionHistoryIndex::allTime,
+                                                          int64_t to = TransactionHistoryIndex::allTime) {
+    std::lock_guard<std::mutex> ledgerLock(ledgerMutex);
+    return resolveSlots(historyIndex.retailerHistory(retailerId, from, to));
+}
+
+std::vector<const Transaction*> queryProductTransactions(int productId, int64_t from = -TransactionHistoryIndex::allTime,
+                                                         int64_t to = TransactionHistoryIndex::allTime) {
+    std::lock_guard<std::mutex> ledgerLock(ledgerMutex);
+    return resolveSlots(historyIndex.productHistory(productId, from, to));
+}
+
+std::vector<const Transaction*> queryTransactionsBetween(int64_t from, int64_t to) {
+    std::lock_guard<std::mutex> ledgerLock(ledgerMutex);
+    return resolveSlots(historyIndex.between(from, to));
+}
+
+// Helper function to turn matched slots into transactions
+std::vector<const Transaction*> resolveSlots(TransactionSlotRange slots) const {
+    std::vector<const Transaction*> matches;
+    matches.reserve(slots.size());
+    for (uint32_t slot : slots) {
+        matches.push_back(&transactions[slot]);
+    }
+    return matches;
+}
+
+// Function to query the transaction history by retailer, product or date range
+void queryTransactionHistory() {
     try {
-        Product newProduct(nextProductId, name, price, stock); // Create a new product
-        products.push_back(newProduct); // Add the new product to the products list
+        std::cout << "\n===== TRANSACTION HISTORY QUERY =====" << std::endl;
+        std::cout << "1. By Retailer  2. By Product  3. By Date Range" << std::endl;
+        std::cout << "Enter your choice: ";
+        int choice;
+        if (!(std::cin >> choice) || choice < 1 || choice > 3) {
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            throw std::runtime_error("Invalid choice");
+        }
+        
+        int id = 0;
+        if (choice != 3) {
+            std::cout << (choice == 1 ? "Enter retailer ID: " : "Enter product ID: ");
+            if (!(std::cin >> id)) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                throw std::runtime_error("Invalid ID");
+            }
+        }
         
-        // Add to blockchain
-        std::string blockData = "Added Product | " + newProduct.toString(); // Prepare block data
-        blockchain.addBlock(blockData); // Add a new block to the blockchain
+        // Date range in whole days, or every date when left as 0
+        std::string fromDate, toDate;
+        std::cout << "Enter start date (YYYYMMDD, or 0 for any): ";
+        std::cin >> fromDate;
+        std::cout << "Enter end date (YYYYMMDD, or 0 for any): ";
+        std::cin >> toDate;
+        int64_t from = -TransactionHistoryIndex::allTime;
+        int64_t to = TransactionHistoryIndex::allTime;
+        if (fromDate != "0") {
+            from = parseTimestamp(fromDate + ":00:00");
+            if (from == 0) {
+                throw std::runtime_error("Invalid start date");
+            }
+        }
+        if (toDate != "0") {
+            to = parseTimestamp(toDate + ":23:59");
+            if (to == 0) {
+                throw std::runtime_error("Invalid end date");
+            }
+            to += 59; // Include the last minute of the day
+        }
         
-        return nextProductId++; // Return the product ID and increment the next available product ID
+        auto start = std::chrono::steady_clock::now();
+        std::vector<const Transaction*> matches = choice == 1 ? queryRetailerTransactions(id, from, to)
+                                                : choice == 2 ? queryProductTransactions(id, from, to)
+                                                : queryTransactionsBetween(from, to);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        
+        for (const Transaction* transaction : matches) {
+            std::cout << transaction->toString() << std::endl;
+            std::cout << "--------------------------------------" << std::endl;
+        }
+        std::cout << matches.size() << " transaction(s) found in " << std::fixed << std::setprecision(3)
+                  << elapsedMs << " ms" << std::endl;
     }
     catch (const std::exception& e) {
-        std::cerr << "Error adding product: " << e.what() << std::endl; // Print error message
-        return -1; // Return -1 to indicate failure
+        std::cerr << "Error querying transactions: " << e.what() << std::endl;
     }
 }
 
-void displayProducts() const {
-    std::cout << "\n===== PRODUCTS =====" << std::endl; // Print header
-    if (products.empty()) {
-        std::cout << "No products available." << std::endl; // Print message if no products
+// Function to write the metrics to a file, as JSON when the name ends in .json and in the
+// Prometheus text format otherwise
+bool exportMetrics(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    bool json = filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0;
+    if (json) {
+        writeJsonMetrics(file);
+    } else {
+        writePrometheusMetrics(file);
+    }
+    return static_cast<bool>(file);
+}
+
+// Function to display timing of the instrumented operations since start-up
+void showMetrics() {
+    if (!metricsEnabled) {
+        std::cout << "Metrics were compiled out (MADS_DISABLE_METRICS)." << std::endl;
         return;
     }
+    settleChain(); // Let the writer thread record the blocks submitted so far
+    std::array<MetricHistogram, metricCount> histograms = MetricsRegistry::instance().snapshot();
+    std::cout << "\n===== METRICS =====" << std::endl;
+    std::cout << std::left << std::setw(16) << "Operation" << std::right << std::setw(10) << "Count"
+              << std::setw(12) << "Total(ms)" << std::setw(12) << "Mean(us)"
+              << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (size_t m = 0; m < metricCount; ++m) {
+        const MetricHistogram& histogram = histograms[m];
+        double meanUs = histogram.count == 0 ? 0.0 : histogram.totalNs / 1e3 / histogram.count;
+        std::cout << std::left << std::setw(16) << metricName(static_cast<MetricId>(m)) << std::right
+                  << std::setw(10) << histogram.count << std::setw(12) << histogram.totalNs / 1e6
+                  << std::setw(12) << meanUs << std::setw(12) << histogram.percentileNs(0.50) / 1e3
+                  << std::setw(12) << histogram.percentileNs(0.99) / 1e3 << std::endl;
+    }
+    std::cout << "Percentiles are bucket upper bounds (powers of two nanoseconds)." << std::endl;
     
-    for (const auto& product : products) {
-        std::cout << product.toString() << std::endl; // Print each product's details
+    char choice;
+    std::cout << "Export metrics to metrics.prom? (y/n): ";
+    std::cin >> choice;
+    if (choice == 'y' || choice == 'Y') {
+        if (exportMetrics("metrics.prom")) {
+            std::cout << "Metrics exported to metrics.prom" << std::endl;
+        }
     }
 }
 
-// CRUD operations for suppliers
-int addSupplier(const std::string& name, const std::string& location, 
-               const std::string& branch, double latitude, double longitude) {
+// Blockchain operations
+// Wait until every block submitted so far is linked into the chain
+void settleChain() {
+    chainWriter.settle();
+}
+
+void displayBlockchain() {
+    std::unique_lock<std::mutex> chainLock = chainWriter.settle(); // Show every block submitted so far
+    std::cout << "\n===== BLOCKCHAIN =====" << std::endl; // Print header
+    if (blockchain.size() <= 1) {
+        std::cout << "Only genesis block available." << std::endl; // Print message if only genesis block is available
+    }
+    
+    blockchain.displayChain(); // Display all blocks in the blockchain
+    
+    ChainVerificationResult verification = blockchain.verify();
+    if (verification.valid) {
+        std::cout << "Blockchain integrity: VALID" << std::endl; // Print message if blockchain is valid
+    } else {
+        std::cout << "Blockchain integrity: COMPROMISED at block position "
+                  << verification.firstInvalidBlock << std::endl; // Print message if blockchain is compromised
+    }
+    if (verification.legacyBlocks > 0) {
+        std::cout << verification.legacyBlocks
+                  << " legacy block(s) predate content hashing and were checked for linkage only." << std::endl;
+    }
+    if (blockchain.segmentCount() > 0) {
+        std::cout << blockchain.segmentCount() << " sealed ledger segment(s) were read from disk." << std::endl;
+    }
+}
+
+// Data persistence
+// A save makes every change durable at once by flushing the new blocks and the buffered
+// journal records. Once the journal has grown past checkpointInterval records, the save
+// also captures a snapshot, which is written in the background while orders keep coming
+// in; the journal is cut back when the write completes. With the journal detached (first
+// save after startup or reset) nothing else holds the data yet, so that checkpoint is
+// written before saveData returns.
+bool saveData() {
     try {
-        Supplier newSupplier(nextSupplierId, name, location, branch, latitude, longitude); // Create a new supplier
-        suppliers.push_back(newSupplier); // Add the new supplier to the suppliers list
-        
-        // Add to blockchain
-        std::string blockData = "Added Supplier | " + newSupplier.toString(); // Prepare block data
-        blockchain.addBlock(blockData); // Add a new block to the blockchain
+        ScopedTimer saveTimer(MetricId::SaveData);
+        if (savedDataUnreadable) {
+            std::cerr << "Error saving data: the saved data failed to load and is not overwritten; "
+                      << "load it again or reset the system first" << std::endl;
+            return false;
+        }
+        collectSnapshots();
+        if (!journal.isOpen()) {
+            return checkpoint();
+        }
         
-        return nextSupplierId++; // Return the supplier ID and increment the next available supplier ID
+        // Wait for the writer to append new blocks, then make the journal durable. No batch
+        // is between its stock changes and its records while the journal is flushed and the
+        // snapshot captured, so both are the same cut.
+        if (!chainWriter.flush()) {
+            return false; // Return false if saving blockchain fails
+        }
+        std::unique_lock<std::shared_mutex> intakeLock(intakeGate);
+        {
+            ScopedTimer journalTimer(MetricId::JournalFlush);
+            if (!journal.flush()) {
+                return false;
+            }
+        }
+        if (journal.getRecordCount() >= checkpointInterval) {
+            startCheckpoint();
+        }
+        return true;
     }
     catch (const std::exception& e) {
-        std::cerr << "Error adding supplier: " << e.what() << std::endl; // Print error message
-        return -1; // Return -1 to indicate failure
+        std::cerr << "Error saving data: " << e.what() << std::endl; // Print error message
+        return false; // Return false if an exception occurs
     }
 }
-void displaySuppliers() const {
-    std::cout << "\n===== SUPPLIERS =====" << std::endl; // Print header
-    if (suppliers.empty()) {
-        std::cout << "No suppliers available." << std::endl; // Print message if no suppliers
-        return;
+
+// Capture a snapshot of the state the journal was just flushed up to and hand it to the
+// snapshot writer
+void startCheckpoint() {
+    ScopedTimer checkpointTimer(MetricId::Checkpoint);
+    uint64_t position = journal.getPosition();
+    snapshotSaver.submit("snapshot.bin", captureSnapshot(journal.getLastSequence()), position);
+    journal.markCheckpoint();
+}
+
+// Helper function to act on the background snapshots written since the last call: each
+// one lets the journal drop the records it contains, a failed one leaves the journal whole
+void collectSnapshots() {
+    for (const SnapshotSaver::Result& result : snapshotSaver.collect()) {
+        if (!result.ok) {
+            std::cerr << "Error saving data: could not write " << result.filename
+                      << "; the journal still holds every change" << std::endl;
+        } else if (journal.isOpen() && !journal.dropThrough("journal.dat", result.journalPosition)) {
+            std::cerr << "Error saving data: could not compact journal.dat" << std::endl;
+        }
     }
-    
-    for (const auto& supplier : suppliers) {
-        std::cout << supplier.toString() << std::endl; // Print each supplier's details
-        
-        // Show linked products
-        std::cout << "  Products: ";
-        const auto& productIds = supplier.getProductIds();
-        if (productIds.empty()) {
-            std::cout << "None"; // Print message if no products linked to supplier
-        } else {
-            for (size_t i = 0; i < productIds.size(); ++i) {
-                for (const auto& product : products) {
-                    if (product.getId() == productIds[i]) {
-                        std::cout << product.getName(); // Print product name
-                        break;
-                    }
-                }
-                if (i < productIds.size() - 1) {
-                    std::cout << ", "; // Print comma separator between product names
-                }
-            }
+}
+
+// Helper function to wait for background snapshots before the state they view is replaced.
+// Their journal positions are discarded, as the journal is about to be reopened or reset.
+void settleSnapshots() {
+    snapshotSaver.settle();
+    for (const SnapshotSaver::Result& result : snapshotSaver.collect()) {
+        if (!result.ok) {
+            std::cerr << "Error saving data: could not write " << result.filename << std::endl;
         }
-        std::cout << std::endl; // New line after listing products
     }
 }
 
-// CRUD operations for retailers
-int addRetailer(const std::string& name, const std::string& location, 
-               double latitude, double longitude, double initialCredit, double annualCredit) {
-    try {
-        Retailer newRetailer(nextRetailerId, name, location, latitude, longitude, initialCredit, annualCredit); // Create a new retailer
-        retailers.push_back(newRetailer); // Add the new retailer to the retailers list
-        
-        // Add to blockchain
-        std::string blockData = "Added Retailer | " + newRetailer.toString(); // Prepare block data
-        blockchain.addBlock(blockData); // Add a new block to the blockchain
-        
-        return nextRetailerId++; // Return the retailer ID and increment the next available retailer ID
+// Compact the current state into snapshot.bin and start an empty journal
+bool checkpoint() {
+    ScopedTimer checkpointTimer(MetricId::Checkpoint);
+    settleSnapshots(); // Both write through snapshot.bin.tmp
+    if (!chainWriter.flush()) {
+        return false; // Return false if saving blockchain fails
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error adding retailer: " << e.what() << std::endl; // Print error message
-        return -1; // Return -1 to indicate failure
+    
+    // The snapshot records the last journal sequence it contains, so if we crash before the
+    // journal is truncated the stale records are skipped on the next load
+    std::unique_lock<std::shared_mutex> intakeLock(intakeGate);
+    uint64_t sequence = journal.getLastSequence();
+    if (!saveSnapshot("snapshot.bin", sequence)) {
+        return false;
     }
+    return journal.reset("journal.dat", sequence);
 }
-void displayRetailers() const {
-    std::cout << "\n===== RETAILERS =====" << std::endl; // Print header
-    if (retailers.empty()) {
-        std::cout << "No retailers available." << std::endl; // Print message if no retailers
-        return;
+
+// Write the binary snapshot (see SnapshotHeader for the layout)
+bool saveSnapshot(const std::string& filename, uint64_t journalSequence) const {
+    return writeSnapshotImage(filename, captureSnapshot(journalSequence));
+}
+
+// Capture everything but the transaction section of a snapshot, which is only viewed
+SnapshotImage captureSnapshot(uint64_t journalSequence) const {
+    SnapshotWriter writer;
+    for (const auto& product : products) {
+        ProductRecord record = {};
+        record.price = product.getPrice();
+        record.id = product.getId();
+        record.stock = product.getStock();
+        record.name = writer.intern(product.getName());
+        writer.addRecord(record);
+    }
+    writer.endSection();
+    
+    for (const auto& supplier : suppliers) {
+        SupplierRecord record = {};
+        record.latitude = supplier.getLatitude();
+        record.longitude = supplier.getLongitude();
+        record.id = supplier.getId();
+        record.productOffset = writer.addIds(supplier.getProductIds());
+        record.productCount = static_cast<uint32_t>(supplier.getProductIds().size());
+        record.name = writer.intern(supplier.getName());
+        record.location = writer.intern(supplier.getLocation());
+        record.branch = writer.intern(supplier.getBranch());
+        writer.addRecord(record);
     }
+    writer.endSection();
     
     for (const auto& retailer : retailers) {
-        std::cout << retailer.toString() << std::endl; // Print each retailer's details
+        RetailerRecord record = {};
+        record.latitude = retailer.getLatitude();
+        record.longitude = retailer.getLongitude();
+        record.creditBalance = retailer.getCreditBalance();
+        record.annualCreditBalance = retailer.getAnnualCreditBalance();
+        record.id = retailer.getId();
+        record.productOffset = writer.addIds(retailer.getProductIds());
+        record.productCount = static_cast<uint32_t>(retailer.getProductIds().size());
+        record.name = writer.intern(retailer.getName());
+        record.location = writer.intern(retailer.getLocation());
+        writer.addRecord(record);
+    }
+    writer.endSection();
+    
+    for (const auto& transporter : transporters) {
+        TransporterRecord record = {};
+        record.costPerKm = transporter.getCostPerKm();
+        record.maxCapacity = transporter.getMaxCapacity();
+        record.id = transporter.getId();
+        record.name = writer.intern(transporter.getName());
+        record.transportType = writer.intern(transporter.getTransportType());
+        writer.addRecord(record);
     }
+    writer.endSection();
+    
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.nextIds[0] = nextProductId;
+    header.nextIds[1] = nextSupplierId;
+    header.nextIds[2] = nextRetailerId;
+    header.nextIds[3] = nextTransporterId;
+    header.nextIds[4] = nextTransactionId;
+    header.productCount = products.size();
+    header.supplierCount = suppliers.size();
+    header.retailerCount = retailers.size();
+    header.transporterCount = transporters.size();
+    header.transactionCount = transactions.size();
+    header.journalSequence = journalSequence;
+    header.indexSections = 1;
+    
+    SnapshotImage image;
+    image.head = writer.finish(header);
+    image.transactions = transactions.prefix();
+    image.journalSequence = journalSequence;
+    
+    // Indexes over the history, so a restart does not have to sort or replay it again.
+    // They only add records, so they go through a writer of their own after the transactions.
+    SnapshotWriter indexWriter;
+    historyIndex.writeTo(indexWriter);
+    reportTotals.writeTo(indexWriter);
+    forecaster.writeTo(indexWriter);
+    indexWriter.endSection();
+    image.tail = indexWriter.takeRecords();
+    return image;
 }
 
-// CRUD operations for transporters
-int addTransporter(const std::string& name, const std::string& type, 
-                 double costPerKm, double capacity) {
-    try {
-        Transporter newTransporter(nextTransporterId, name, type, costPerKm, capacity); // Create a new transporter
-        transporters.push_back(newTransporter); // Add the new transporter to the transporters list
-        
-        // Add to blockchain
-        std::string blockData = "Added Transporter | " + newTransporter.toString(); // Prepare block data
-        blockchain.addBlock(blockData); // Add a new block to the blockchain
-        
-        return nextTransporterId++; // Return the transporter ID and increment the next available transporter ID
+// Read the binary snapshot into the (already cleared) entity lists.
+// journalSequence receives the last journal record the snapshot already contains, and
+// indexesRestored tells whether the history indexes came with it or must be rebuilt.
+bool loadSnapshot(const std::string& filename, uint64_t& journalSequence, bool& indexesRestored) {
+    MappedFile mapping;
+    if (!mapping.open(filename)) {
+        return false; // Return false if the snapshot cannot be read
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error adding transporter: " << e.what() << std::endl; // Print error message
-        return -1; // Return -1 to indicate failure
+    
+    SnapshotReader reader(std::string_view(mapping.data(), mapping.size()));
+    const SnapshotHeader& header = reader.header;
+    
+    for (uint64_t i = 0; i < header.productCount; ++i) {
+        ProductRecord record = reader.next<ProductRecord>();
+        products.push_back(Product(record.id, std::string(reader.text(record.name)), record.price, record.stock));
+    }
+    reader.endSection();
+    
+    for (uint64_t i = 0; i < header.supplierCount; ++i) {
+        SupplierRecord record = reader.next<SupplierRecord>();
+        Supplier supplier(record.id, std::string(reader.text(record.name)), std::string(reader.text(record.location)),
+                          std::string(reader.text(record.branch)), record.latitude, record.longitude);
+        auto productIds = reader.ids(record.productOffset, record.productCount);
+        for (const int32_t* productId = productIds.first; productId != productIds.second; ++productId) {
+            supplier.addProduct(*productId);
+        }
+        suppliers.push_back(supplier);
+    }
+    reader.endSection();
+    
+    for (uint64_t i = 0; i < header.retailerCount; ++i) {
+        RetailerRecord record = reader.next<RetailerRecord>();
+        Retailer retailer(record.id, std::string(reader.text(record.name)), std::string(reader.text(record.location)),
+                          record.latitude, record.longitude, record.creditBalance, record.annualCreditBalance);
+        auto productIds = reader.ids(record.productOffset, record.productCount);
+        for (const int32_t* productId = productIds.first; productId != productIds.second; ++productId) {
+            retailer.addProduct(*productId);
+        }
+        retailers.push_back(retailer);
+    }
+    reader.endSection();
+    
+    for (uint64_t i = 0; i < header.transporterCount; ++i) {
+        TransporterRecord record = reader.next<TransporterRecord>();
+        transporters.push_back(Transporter(record.id, std::string(reader.text(record.name)), std::string(reader.text(record.transportType)),
+                                           record.costPerKm, record.maxCapacity));
+    }
+    reader.endSection();
+    
+    transactions.reserve(static_cast<size_t>(header.transactionCount));
+    if (header.version >= 3) {
+        for (uint64_t i = 0; i < header.transactionCount; ++i) {
+            TransactionRecord record = reader.next<TransactionRecord>();
+            if (record.status > static_cast<uint8_t>(TransactionStatus::Other) ||
+                record.orderType > static_cast<uint8_t>(OrderType::Other)) {
+                throw std::runtime_error("Snapshot transaction record is corrupt");
+            }
+            transactions.push_back(Transaction::restore(record.id, record.supplierId, record.retailerId,
+                                                        record.productId, record.transporterId, record.quantity,
+                                                        record.productCost, record.transportCost, record.totalCost,
+                                                        record.timestamp, static_cast<TransactionStatus>(record.status),
+                                                        static_cast<OrderType>(record.orderType)));
+        }
+    } else {
+        for (uint64_t i = 0; i < header.transactionCount; ++i) {
+            TransactionRecordV2 record = reader.next<TransactionRecordV2>();
+            transactions.push_back(Transaction::restore(record.id, record.supplierId, record.retailerId,
+                                                        record.productId, record.transporterId, record.quantity,
+                                                        record.productCost, record.transportCost, record.totalCost,
+                                                        parseTimestamp(reader.text(record.timestamp)),
+                                                        parseTransactionStatus(reader.text(record.status)),
+                                                        parseOrderType(reader.text(record.orderType))));
+        }
+    }
+    reader.endSection();
+    
+    indexesRestored = false;
+    if (header.indexSections != 0) {
+        try {
+            historyIndex.readFrom(reader, transactions.size());
+            reportTotals.readFrom(reader);
+            forecaster.readFrom(reader);
+            indexesRestored = true;
+        }
+        catch (const std::exception& e) {
+            // The entity data is intact, so fall back to rebuilding the indexes from it
+            std::cerr << "Rebuilding history indexes: " << e.what() << std::endl;
+            historyIndex.clear();
+            reportTotals.clear();
+            forecaster.clear();
+        }
     }
+    
+    // Next IDs travel in the same file, so they can never drift from the entity lists
+    nextProductId = header.nextIds[0];
+    nextSupplierId = header.nextIds[1];
+    nextRetailerId = header.nextIds[2];
+    nextTransporterId = header.nextIds[3];
+    nextTransactionId = header.nextIds[4];
+    journalSequence = header.journalSequence;
+    
+    return true;
 }
 
-void displayTransporters() const {
-    std::cout << "\n===== TRANSPORTERS =====" << std::endl; // Print header
-    if (transporters.empty()) {
-        std::cout << "No transporters available." << std::endl; // Print message if no transporters
-        return;
-    }
+// Replay journal records written after the snapshot, then attach the journal for appending
+bool replayJournal(const std::string& filename, uint64_t snapshotSequence) {
+    std::vector<char> buffer;
+    readWholeFile(filename, buffer); // A missing journal simply means nothing to replay
     
-    for (const auto& transporter : transporters) {
-        std::cout << transporter.toString() << std::endl; // Print each transporter's details
+    uint64_t lastSequence = snapshotSequence;
+    size_t records = 0;
+    size_t intactBytes = Journal::replay(buffer, snapshotSequence,
+        [this](JournalRecordType type, JournalDecoder& record) { applyJournalRecord(type, record); },
+        lastSequence, records);
+    
+    if (intactBytes < buffer.size()) {
+        // Drop a torn tail left by a crash so new records are not appended after garbage
+        std::cerr << "Discarding " << (buffer.size() - intactBytes) << " bytes of incomplete journal data" << std::endl;
+        std::filesystem::resize_file(filename, intactBytes);
     }
+    
+    return journal.open(filename, lastSequence, records);
 }
-    // Transaction operations
-int createTransaction(int supplierId, int retailerId, int productId, int transporterId, int quantity, const std::string& orderType = "Regular") {
-    try {
-        // Validate entities exist
-        Supplier* supplier = findSupplier(supplierId);
-        Retailer* retailer = findRetailer(retailerId);
-        Product* product = findProduct(productId);
-        Transporter* transporter = findTransporter(transporterId);
-        
-        if (!supplier) {
-            throw std::runtime_error("Supplier ID not found");
+
+// Apply one replayed journal record to the in-memory state
+void applyJournalRecord(JournalRecordType type, JournalDecoder& record) {
+    switch (type) {
+        case JournalRecordType::AddProduct: {
+            int id = record.get<int32_t>();
+            std::string name(record.getString());
+            double price = record.get<double>();
+            int stock = record.get<int32_t>();
+            products.push_back(Product(id, name, price, stock));
+            productIndex.insert(id, products.size() - 1);
+            nextProductId = std::max(nextProductId, id + 1);
+            break;
         }
-        if (!retailer) {
-            throw std::runtime_error("Retailer ID not found");
+        case JournalRecordType::AddSupplier: {
+            int id = record.get<int32_t>();
+            std::string name(record.getString());
+            std::string location(record.getString());
+            std::string branch(record.getString());
+            double latitude = record.get<double>();
+            double longitude = record.get<double>();
+            suppliers.push_back(Supplier(id, name, location, branch, latitude, longitude));
+            supplierIndex.insert(id, suppliers.size() - 1);
+            distances.setSupplier(suppliers.size() - 1, latitude, longitude);
+            nextSupplierId = std::max(nextSupplierId, id + 1);
+            break;
         }
-        if (!product) {
-            throw std::runtime_error("Product ID not found");
+        case JournalRecordType::LinkSupplierProduct: {
+            int supplierId = record.get<int32_t>();
+            int productId = record.get<int32_t>();
+            linkSupplierProductHeld(supplierId, productId); // loadData holds intakeGate
+            break;
         }
-        if (!transporter) {
-            throw std::runtime_error("Transporter ID not found");
+        case JournalRecordType::AddRetailer: {
+            int id = record.get<int32_t>();
+            std::string name(record.getString());
+            std::string location(record.getString());
+            double latitude = record.get<double>();
+            double longitude = record.get<double>();
+            double initialCredit = record.get<double>();
+            double annualCredit = record.get<double>();
+            retailers.push_back(Retailer(id, name, location, latitude, longitude, initialCredit, annualCredit));
+            retailerIndex.insert(id, retailers.size() - 1);
+            distances.setRetailer(retailers.size() - 1, latitude, longitude);
+            nextRetailerId = std::max(nextRetailerId, id + 1);
+            break;
         }
-        
-        // Check if supplier has this product
-        bool supplierHasProduct = false;
-        for (int id : supplier->getProductIds()) {
-            if (id == productId) {
-                supplierHasProduct = true;
-                break;
+        case JournalRecordType::AddTransporter: {
+            int id = record.get<int32_t>();
+            std::string name(record.getString());
+            std::string transportType(record.getString());
+            double costPerKm = record.get<double>();
+            double capacity = record.get<double>();
+            transporters.push_back(Transporter(id, name, transportType, costPerKm, capacity));
+            transporterIndex.insert(id, transporters.size() - 1);
+            fleetColumns.add(transporters.back());
+            nextTransporterId = std::max(nextTransporterId, id + 1);
+            break;
+        }
+        case JournalRecordType::TransactionText:
+        case JournalRecordType::Transaction: {
+            int id = record.get<int32_t>();
+            int supplierId = record.get<int32_t>();
+            int retailerId = record.get<int32_t>();
+            int productId = record.get<int32_t>();
+            int transporterId = record.get<int32_t>();
+            int quantity = record.get<int32_t>();
+            double productCost = record.get<double>();
+            double transportCost = record.get<double>();
+            double totalCost = record.get<double>();
+            int64_t timestamp;
+            TransactionStatus status;
+            OrderType orderType;
+            if (type == JournalRecordType::Transaction) {
+                timestamp = record.get<int64_t>();
+                status = static_cast<TransactionStatus>(record.get<uint8_t>());
+                orderType = static_cast<OrderType>(record.get<uint8_t>());
+            } else {
+                timestamp = parseTimestamp(record.getString());
+                status = parseTransactionStatus(record.getString());
+                orderType = parseOrderType(record.getString());
+            }
+            
+            // Re-apply the stock and credit effects of a completed order
+            if (status == TransactionStatus::Completed) {
+                Product* product = findProduct(productId);
+                Retailer* retailer = findRetailer(retailerId);
+                if (product) {
+                    product->updateStock(-quantity);
+                }
+                if (retailer) {
+                    retailer->deductCredit(totalCost);
+                }
             }
+            storeTransaction(Transaction::restore(id, supplierId, retailerId, productId, transporterId, quantity,
+                                                  productCost, transportCost, totalCost, timestamp, status, orderType));
+            nextTransactionId = std::max(nextTransactionId.load(), id + 1);
+            break;
         }
-        
-        if (!supplierHasProduct) {
-            throw std::runtime_error("This supplier does not supply this product");
+        default:
+            throw std::runtime_error("Unknown journal record type");
+    }
+}
+
+// Helper function to write one serialized line per item to a text data file
+template <typename Container>
+static bool exportLines(const std::string& filename, const Container& items) {
+    std::string contents;
+    for (const auto& item : items) {
+        contents += item.serialize();
+        contents += '\n';
+    }
+    return writeFileReplacing(filename, contents);
+}
+
+// Export all data in the pipe-delimited text format (*.dat files)
+bool exportTextData() {
+    try {
+        // Save blockchain (blockchain.dat is already a text file, so only new blocks are written)
+        if (!chainWriter.flush()) {
+            return false; // Return false if saving blockchain fails
         }
         
-        // Check product stock
-        if (!product->hasEnoughStock(quantity)) {
-            throw std::runtime_error("Insufficient product stock");
+        // Each file is built in memory and replaces the old one in a single write
+        if (!exportLines("products.dat", products) || !exportLines("suppliers.dat", suppliers) ||
+            !exportLines("retailers.dat", retailers) || !exportLines("transporters.dat", transporters) ||
+            !exportLines("transactions.dat", transactions)) {
+            return false; // Return false if writing a data file fails
         }
         
-        // Calculate costs
-        double productCost = product->getPrice() * quantity;
-        
-        // Calculate distance and transport cost
-        double distance = calculateDistance(
-            supplier->getLatitude(), supplier->getLongitude(),
-            retailer->getLatitude(), retailer->getLongitude()
-        );
-        
-        double transportCost = transporter->calculateTransportCost(distance);
-        
-        // Create transaction
-        Transaction transaction(nextTransactionId, supplierId, retailerId, productId, transporterId, quantity);
-        transaction.setProductCost(productCost);
-        transaction.setTransportCost(transportCost);
-        transaction.calculateTotalCost();
-        transaction.setOrderType(orderType);
-        
-        // Validate with smart contracts
-        bool isValid = true;
-        for (const auto& contract : contracts) {
-            if (!contract->validate(transaction)) {
-                isValid = false;
-                std::cout << "Transaction failed validation: " << contract->getDescription() << std::endl;
-                break;
-            }
+        // Save next IDs
+        std::string ids;
+        for (int id : {nextProductId, nextSupplierId, nextRetailerId, nextTransporterId, nextTransactionId.load()}) {
+            ids += std::to_string(id);
+            ids += '\n';
         }
-        
-        if (!isValid) {
-            transaction.setStatus("Failed");
-            transactions.push_back(transaction);
-            
-            // Add to blockchain
-            std::string blockData = "Failed Transaction | " + transaction.getBlockData();
-            blockchain.addBlock(blockData);
-            
-            return nextTransactionId++;
+        if (!writeFileReplacing("nextids.dat", ids)) {
+            return false; // Return false if writing the ID file fails
         }
         
-        // Check retailer credit
-        double totalCost = transaction.getTotalCost();
-        if (!retailer->deductCredit(totalCost)) {
-            transaction.setStatus("Failed");
-            std::cout << "Transaction failed: Insufficient retailer credit" << std::endl;
-            transactions.push_back(transaction);
-            
-            // Add to blockchain
-            std::string blockData = "Failed Transaction (Credit) | " + transaction.getBlockData();
-            blockchain.addBlock(blockData);
-            
-            return nextTransactionId++;
+        return true; // Return true if all data is exported successfully
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error exporting data: " << e.what() << std::endl; // Print error message
+        return false; // Return false if an exception occurs
+    }
+}
+// Helper function to tell whether any data a save writes is on disk
+static bool hasSavedData() {
+    for (const char* filename : {"snapshot.bin", "journal.dat", "blockchain.dat", "products.dat", "suppliers.dat",
+                                 "retailers.dat", "transporters.dat", "transactions.dat", "nextids.dat"}) {
+        if (fileExists(filename)) {
+            return true;
         }
+    }
+    return false;
+}
+
+// A load that fails part way leaves saved data on disk the system no longer matches, so
+// saves are refused until a load succeeds or the system is reset
+bool loadData() {
+    savedDataUnreadable = hasSavedData(); // Cleared once everything has loaded
+    try {
+        settleSnapshots(); // A snapshot still being written views the transactions cleared below
+        std::unique_lock<std::shared_mutex> entityLock(intakeGate); // No batch runs against a half-loaded state
+        journal.close(); // Detach while the state is rebuilt
         
-        // Update product stock
-        product->updateStock(-quantity);
+        // Clear existing data
+        products.clear();
+        suppliers.clear();
+        retailers.clear();
+        transporters.clear();
+        transactions.clear(); // Keep the chunks for the records about to be loaded
+        clearIndexes();
         
-        // Complete transaction
-        transaction.setStatus("Completed");
-        transactions.push_back(transaction);
+        // Load blockchain once the writer has linked every queued block, on its own thread
+        // while the entity data loads
+        std::future<bool> chainLoad = std::async(std::launch::async, [this]() {
+            std::unique_lock<std::mutex> chainLock = chainWriter.settle();
+            return blockchain.loadFromFile("blockchain.dat");
+        });
         
-        // Add to blockchain
-        std::string blockData = "Completed Transaction | " + transaction.getBlockData();
-        blockchain.addBlock(blockData);
+        // Prefer the binary snapshot plus journal tail, fall back to the text export
+        if (fileExists("snapshot.bin")) {
+            uint64_t snapshotSequence = 0;
+            bool indexesRestored = false;
+            if (!loadSnapshot("snapshot.bin", snapshotSequence, indexesRestored)) {
+                return false; // Return false if the snapshot cannot be read
+            }
+            // Replay looks entities up by ID, and keeps restored history indexes up to date
+            if (indexesRestored) {
+                rebuildLookupIndexes();
+            } else {
+                rebuildIndexes();
+            }
+            if (!replayJournal("journal.dat", snapshotSequence)) {
+                return false; // Return false if the journal cannot be reopened
+            }
+        } else {
+            loadTextData(); // Journal stays detached; the next save takes a checkpoint
+            rebuildIndexes(); // Re-index everything that was loaded
+        }
         
-        return nextTransactionId++;
+        if (!chainLoad.get()) {
+            journal.close(); // Nothing is logged against a state that failed to load
+            return false; // Return false if loading blockchain fails
+        }
+        savedDataUnreadable = false;
+        return true; // Return true if all data is loaded successfully
     }
     catch (const std::exception& e) {
-        std::cerr << "Error creating transaction: " << e.what() << std::endl;
-        return -1;
-    }
-}
-void displayTransactions() const {
-    std::cout << "\n===== TRANSACTIONS =====" << std::endl; // Print header
-    if (transactions.empty()) {
-        std::cout << "No transactions available." << std::endl; // Print message if no transactions
-        return;
-    }
-    
-    for (const auto& transaction : transactions) {
-        std::cout << transaction.toString() << std::endl; // Print each transaction's details
-        std::cout << "--------------------------------------" << std::endl; // Separator line
+        std::cerr << "Error loading data: " << e.what() << std::endl; // Print error message
+        return false; // Return false if an exception occurs
     }
 }
 
-// Blockchain operations
-void displayBlockchain() const {
-    std::cout << "\n===== BLOCKCHAIN =====" << std::endl; // Print header
-    if (blockchain.size() <= 1) {
-        std::cout << "Only genesis block available." << std::endl; // Print message if only genesis block is available
+// Helper function to parse every line of a .dat file into a container on the calling thread.
+// Returns the messages of the lines that could not be parsed.
+template <typename Container>
+static std::vector<std::string> loadTextFile(const std::string& filename, const char* recordName, Container& items) {
+    std::vector<std::string> errors;
+    std::vector<char> buffer;
+    if (!readWholeFile(filename, buffer)) {
+        return errors; // A missing file simply means no records of this kind
     }
+    forEachLine(std::string_view(buffer.data(), buffer.size()), [&](std::string_view line) {
+        try {
+            items.push_back(Container::value_type::deserialize(line)); // Deserialize record from file
+        }
+        catch (const std::exception& e) {
+            errors.push_back(std::string("Error deserializing ") + recordName + ": " + e.what());
+        }
+    });
+    return errors;
+}
+
+// Read entity lists and next IDs from the pipe-delimited text files. Each file is read in one
+// go and parsed on its own thread straight into its container.
+bool loadTextData() {
+    std::future<std::vector<std::string>> loads[] = {
+        std::async(std::launch::async, [this]() { return loadTextFile("products.dat", "product", products); }),
+        std::async(std::launch::async, [this]() { return loadTextFile("suppliers.dat", "supplier", suppliers); }),
+        std::async(std::launch::async, [this]() { return loadTextFile("retailers.dat", "retailer", retailers); }),
+        std::async(std::launch::async, [this]() { return loadTextFile("transporters.dat", "transporter", transporters); }),
+        std::async(std::launch::async, [this]() { return loadTextFile("transactions.dat", "transaction", transactions); })
+    };
     
-    blockchain.displayChain(); // Display all blocks in the blockchain
+    // Load next IDs
+    std::ifstream idFile("nextids.dat");
+    if (idFile.is_open()) {
+        idFile >> nextProductId;
+        idFile >> nextSupplierId;
+        idFile >> nextRetailerId;
+        idFile >> nextTransporterId;
+        int transactionId = nextTransactionId;
+        idFile >> transactionId;
+        nextTransactionId = transactionId;
+        idFile.close();
+    }
     
-    if (blockchain.isChainValid()) {
-        std::cout << "Blockchain integrity: VALID" << std::endl; // Print message if blockchain is valid
-    } else {
-        std::cout << "Blockchain integrity: COMPROMISED" << std::endl; // Print message if blockchain is compromised
+    // Report bad lines in file order once every file is in
+    for (auto& load : loads) {
+        for (const std::string& message : load.get()) {
+            std::cerr << message << std::endl; // Print error message
+        }
     }
+    return true;
 }
 
-// Data persistence
-bool saveData() const {
-    try {
-        // Save blockchain
-        if (!blockchain.saveToFile("blockchain.dat")) {
-            return false; // Return false if saving blockchain fails
-        }
+    // Simulation and Reports
+    // Helper function to build the simulation's orders from the demand forecasts. Every
+    // product a retailer has bought is reordered at its forecast size, through the supplier
+    // and transporter of the latest order; retailers with no history get the seasonal
+    // starter profile.
+    std::vector<OrderRequest> forecastSeasonalOrders(size_t& forecastOrders) {
+        const int highDemandProductId = 1; // Rice
+        const int normalDemandProductId = 2; // Vegetables
         
-        // Save products
-        std::ofstream productFile("products.dat");
-        if (!productFile.is_open()) {
-            return false; // Return false if opening product file fails
-        }
-        for (const auto& product : products) {
-            productFile << product.serialize() << std::endl; // Save each product to file
-        }
-        productFile.close();
+        std::vector<OrderRequest> orders;
+        forecastOrders = 0;
+        std::lock_guard<std::mutex> ledgerLock(ledgerMutex); // Forecasts are updated with the history
         
-        // Save suppliers
-        std::ofstream supplierFile("suppliers.dat");
-        if (!supplierFile.is_open()) {
-            return false; // Return false if opening supplier file fails
-        }
-        for (const auto& supplier : suppliers) {
-            supplierFile << supplier.serialize() << std::endl; // Save each supplier to file
-        }
-        supplierFile.close();
+        // Visit the forecasts by retailer slot, then product slot, as the lists are ordered,
+        // rather than probing every retailer and product pair
+        struct SlotForecast {
+            int retailerSlot;
+            int productSlot;
+            const DemandForecast* forecast;
+        };
+        std::vector<SlotForecast> ordered;
+        ordered.reserve(forecaster.size());
+        forecaster.forEach([&](int retailerId, int productId, const DemandForecast& forecast) {
+            int retailerSlot = retailerIndex.find(retailerId);
+            int productSlot = productIndex.find(productId);
+            if (retailerSlot >= 0 && productSlot >= 0) {
+                ordered.push_back(SlotForecast{retailerSlot, productSlot, &forecast});
+            }
+        });
+        std::sort(ordered.begin(), ordered.end(), [](const SlotForecast& a, const SlotForecast& b) {
+            return a.retailerSlot != b.retailerSlot ? a.retailerSlot < b.retailerSlot : a.productSlot < b.productSlot;
+        });
         
-        // Save retailers
-        std::ofstream retailerFile("retailers.dat");
-        if (!retailerFile.is_open()) {
-            return false; // Return false if opening retailer file fails
+        size_t next = 0;
+        for (size_t slot = 0; slot < retailers.size(); ++slot) {
+            const Retailer& retailer = retailers[slot];
+            size_t before = orders.size();
+            for (; next < ordered.size() && ordered[next].retailerSlot == static_cast<int>(slot); ++next) {
+                const DemandForecast* forecast = ordered[next].forecast;
+                int quantity = static_cast<int>(std::lround(forecast->nextQuantity()));
+                if (quantity > 0) {
+                    orders.push_back(OrderRequest{forecast->supplierId, retailer.getId(), products[ordered[next].productSlot].getId(),
+                                                  forecast->transporterId, quantity, OrderType::Seasonal});
+                }
+            }
+            forecastOrders += orders.size() - before;
+            
+            if (orders.size() == before) {
+                // High demand product transaction (large quantity)
+                orders.push_back(OrderRequest{1, retailer.getId(), highDemandProductId, 1, 100, OrderType::Seasonal});
+                
+                // Normal demand product transaction
+                orders.push_back(OrderRequest{2, retailer.getId(), normalDemandProductId, 2, 50, OrderType::Seasonal});
+            }
         }
-        for (const auto& retailer : retailers) {
-            retailerFile << retailer.serialize() << std::endl; // Save each retailer to file
+        return orders;
+    }
+
+    // Function to run the seasonal simulation without printing anything. Forecasts the
+    // seasonal demand, processes the orders through batch ingestion and calls
+    // rejected(order, result) for every order refused before a transaction was created.
+    template <typename RejectHandler>
+    SeasonalRunStats simulateSeason(RejectHandler rejected) {
+        SeasonalRunStats stats;
+        std::vector<OrderRequest> orders = forecastSeasonalOrders(stats.forecastOrders);
+        stats.orders = orders.size();
+        for (size_t start = 0; start < orders.size(); start += simulationBatchSize) {
+            size_t count = std::min(simulationBatchSize, orders.size() - start);
+            std::vector<OrderResult> results = createTransactions(orders.data() + start, count);
+            for (size_t i = 0; i < results.size(); ++i) {
+                if (results[i].outcome == OrderOutcome::Completed) {
+                    stats.completed++;
+                } else if (results[i].transactionId != -1) {
+                    stats.failed++;
+                } else {
+                    stats.rejected++;
+                    rejected(orders[start + i], results[i]);
+                }
+            }
         }
-        retailerFile.close();
+        return stats;
+    }
+
+    void runSeasonalSimulation() {
+        std::cout << "\n===== RUNNING SEASONAL SIMULATION =====" << std::endl;
         
-        // Save transporters
-        std::ofstream transporterFile("transporters.dat");
-        if (!transporterFile.is_open()) {
-            return false; // Return false if opening transporter file fails
-        }
-        for (const auto& transporter : transporters) {
-            transporterFile << transporter.serialize() << std::endl; // Save each transporter to file
+        SeasonalRunStats stats = simulateSeason([](const OrderRequest& order, const OrderResult& result) {
+            std::cout << "Order for retailer " << order.retailerId << " rejected: "
+                      << orderOutcomeToString(result.outcome) << std::endl;
+        });
+        
+        std::cout << "Orders from demand forecasts: " << stats.forecastOrders << " of " << stats.orders
+                  << " (" << forecaster.size() << " retailer-product forecasts)" << std::endl;
+        std::cout << "Seasonal orders processed: " << stats.orders
+                  << " (Completed: " << stats.completed << ", Failed: " << stats.failed
+                  << ", Rejected: " << stats.rejected << ")" << std::endl;
+        std::cout << "Seasonal simulation complete." << std::endl;
+    }
+
+    // What-if scenarios
+    // Every scenario replays the seasonal forecast orders through the ordering rules of
+    // createTransactions, against its own copy-on-write fork of stock and credit. Nothing is
+    // stored, journaled or recorded on the blockchain, so the live state stays as it was.
+    // Scenarios run in parallel, each on a single thread, and results come back in spec order.
+    std::vector<ScenarioResult> runScenarios(const std::vector<ScenarioSpec>& specs) {
+        size_t forecastOrders = 0;
+        std::vector<OrderRequest> orders = forecastSeasonalOrders(forecastOrders);
+        
+        // Resolve every order once; only quantities, the fleet and the state differ per scenario
+        std::vector<ScenarioOrder> resolved(orders.size());
+        for (size_t i = 0; i < orders.size(); ++i) {
+            const OrderRequest& order = orders[i];
+            ScenarioOrder& entry = resolved[i];
+            entry.supplierSlot = supplierIndex.find(order.supplierId);
+            entry.retailerSlot = retailerIndex.find(order.retailerId);
+            entry.productSlot = productIndex.find(order.productId);
+            entry.transporterSlot = transporterIndex.find(order.transporterId);
+            entry.quantity = order.quantity;
+            entry.orderType = order.orderType;
+            entry.usable = entry.supplierSlot >= 0 && entry.retailerSlot >= 0 && entry.productSlot >= 0 &&
+                           supplyIndex.supplies(static_cast<size_t>(entry.supplierSlot), static_cast<size_t>(entry.productSlot));
+            if (entry.usable) {
+                entry.distance = distances.supplierToRetailer(static_cast<size_t>(entry.supplierSlot),
+                                                              static_cast<size_t>(entry.retailerSlot));
+            }
         }
-        transporterFile.close();
         
-        // Save transactions
-        std::ofstream transactionFile("transactions.dat");
-        if (!transactionFile.is_open()) {
-            return false; // Return false if opening transaction file fails
+        // Fork the live stock and credit once per scenario
+        std::vector<int> stock(products.size());
+        for (size_t slot = 0; slot < products.size(); ++slot) {
+            stock[slot] = products[slot].getStock();
         }
-        for (const auto& transaction : transactions) {
-            transactionFile << transaction.serialize() << std::endl; // Save each transaction to file
+        std::vector<double> credit(retailers.size());
+        for (size_t slot = 0; slot < retailers.size(); ++slot) {
+            credit[slot] = retailers[slot].getCreditBalance();
+        }
+        ScenarioState live{CowColumn<int>(stock), CowColumn<double>(credit)};
+        std::vector<ScenarioState> states;
+        states.reserve(specs.size());
+        for (size_t s = 0; s < specs.size(); ++s) {
+            states.push_back(live.fork());
         }
-        transactionFile.close();
-        
-        // Save next IDs
-        std::ofstream idFile("nextids.dat");
-        if (!idFile.is_open()) {
-            return false; // Return false if opening ID file fails
-        }
-        idFile << nextProductId << std::endl;
-        idFile << nextSupplierId << std::endl;
-        idFile << nextRetailerId << std::endl;
-        idFile << nextTransporterId << std::endl;
-        idFile << nextTransactionId << std::endl;
-        idFile.close();
         
-        return true; // Return true if all data is saved successfully
+        std::vector<RuleStep> plan = ContractEngine::compilePlan(contracts);
+        std::vector<ScenarioResult> results(specs.size());
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        parallelFor(specs.size(), threads, [&](size_t s) {
+            results[s] = runScenario(specs[s], resolved, plan, states[s]);
+            states[s] = ScenarioState(); // Hand back the copied pages
+        });
+        return results;
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error saving data: " << e.what() << std::endl; // Print error message
-        return false; // Return false if an exception occurs
-    }
-}
-bool loadData() {
-    try {
-        // Clear existing data
-        products.clear();
-        suppliers.clear();
-        retailers.clear();
-        transporters.clear();
-        transactions.clear();
-        
-        // Load blockchain
-        if (!blockchain.loadFromFile("blockchain.dat")) {
-            return false; // Return false if loading blockchain fails
+
+    // Helper function to run one scenario over resolved orders, changing only its own state.
+    // Stock, contract and credit checks are made in the same order as in createTransactions.
+    ScenarioResult runScenario(const ScenarioSpec& spec, const std::vector<ScenarioOrder>& orders,
+                               std::vector<RuleStep> plan, ScenarioState& state) const {
+        for (auto& step : plan) {
+            if (!step.fallback && dynamic_cast<const PriceThresholdContract*>(contracts[step.contractIndex].get())) {
+                step.limit *= spec.priceThresholdScale;
+            }
         }
         
-        // Load products
-        std::ifstream productFile("products.dat");
-        if (productFile.is_open()) {
-            std::string line;
-            while (std::getline(productFile, line)) {
-                try {
-                    Product product = Product::deserialize(line); // Deserialize product from file
-                    products.push_back(product); // Add product to list
-                }
-                catch (const std::exception& e) {
-                    std::cerr << "Error deserializing product: " << e.what() << std::endl; // Print error message
-                }
+        // Orders for a transporter outside the fleet go to the cheapest one in it
+        std::vector<char> inFleet(transporters.size(), spec.transporterIds.empty() ? 1 : 0);
+        for (int id : spec.transporterIds) {
+            int slot = transporterIndex.find(id);
+            if (slot >= 0) {
+                inFleet[slot] = 1;
+            }
+        }
+        int cheapestSlot = -1;
+        for (size_t slot = 0; slot < transporters.size(); ++slot) {
+            if (inFleet[slot] && (cheapestSlot < 0 || fleetColumns.costsPerKm[slot] < fleetColumns.costsPerKm[cheapestSlot])) {
+                cheapestSlot = static_cast<int>(slot);
             }
-            productFile.close();
         }
         
-        // Load suppliers
-        std::ifstream supplierFile("suppliers.dat");
-        if (supplierFile.is_open()) {
-            std::string line;
-            while (std::getline(supplierFile, line)) {
-                try {
-                    Supplier supplier = Supplier::deserialize(line); // Deserialize supplier from file
-                    suppliers.push_back(supplier); // Add supplier to list
+        ScenarioResult result;
+        std::vector<Transaction> pending;
+        std::vector<size_t> pendingOrder; // Index into orders for each pending transaction
+        std::vector<short> failedContract;
+        RuleBatch batch;
+        for (size_t start = 0; start < orders.size(); start += simulationBatchSize) {
+            size_t end = std::min(start + simulationBatchSize, orders.size());
+            pending.clear();
+            pendingOrder.clear();
+            batch.clear();
+            
+            // 1. Price the orders of this batch
+            for (size_t i = start; i < end; ++i) {
+                const ScenarioOrder& order = orders[i];
+                int quantity = static_cast<int>(std::lround(order.quantity * spec.demandMultiplier));
+                if (quantity <= 0) {
+                    continue;
                 }
-                catch (const std::exception& e) {
-                    std::cerr << "Error deserializing supplier: " << e.what() << std::endl; // Print error message
+                result.orders++;
+                int transporterSlot = order.transporterSlot >= 0 && inFleet[order.transporterSlot] ? order.transporterSlot : cheapestSlot;
+                if (!order.usable || transporterSlot < 0) {
+                    result.rejected++;
+                    continue;
                 }
+                
+                const Product& product = products[order.productSlot];
+                const Transporter& transporter = transporters[transporterSlot];
+                Transaction transaction(0, suppliers[order.supplierSlot].getId(), retailers[order.retailerSlot].getId(),
+                                        product.getId(), transporter.getId(), quantity);
+                transaction.setProductCost(product.getPrice() * quantity);
+                transaction.setTransportCost(transporter.calculateTransportCost(order.distance));
+                transaction.calculateTotalCost();
+                transaction.setOrderType(order.orderType);
+                
+                pending.push_back(transaction);
+                pendingOrder.push_back(i);
+                batch.append(transaction, order.supplierSlot, order.retailerSlot, order.productSlot, transporterSlot);
             }
-            supplierFile.close();
-        }
-        
-        // Load retailers
-        std::ifstream retailerFile("retailers.dat");
-        if (retailerFile.is_open()) {
-            std::string line;
-            while (std::getline(retailerFile, line)) {
-                try {
-                    Retailer retailer = Retailer::deserialize(line); // Deserialize retailer from file
-                    retailers.push_back(retailer); // Add retailer to list
+            
+            // 2. Validate against the scenario's contract plan
+            ContractEngine::run(plan, batch, pending, failedContract);
+            
+            // 3. Apply stock and credit changes in submission order
+            for (size_t k = 0; k < pending.size(); ++k) {
+                const ScenarioOrder& order = orders[pendingOrder[k]];
+                const Transaction& transaction = pending[k];
+                int stockLeft = state.stock[order.productSlot];
+                if (stockLeft < transaction.getQuantity()) {
+                    result.stockOuts++;
+                    continue;
                 }
-                catch (const std::exception& e) {
-                    std::cerr << "Error deserializing retailer: " << e.what() << std::endl; // Print error message
+                if (failedContract[k] >= 0) {
+                    result.failedContract++;
+                    continue;
+                }
+                double creditLeft = state.credit[order.retailerSlot];
+                if (creditLeft < transaction.getTotalCost()) {
+                    result.failedCredit++;
+                    continue;
                 }
+                state.credit.set(order.retailerSlot, creditLeft - transaction.getTotalCost());
+                state.stock.set(order.productSlot, stockLeft - transaction.getQuantity());
+                result.completed++;
+                result.unitsDelivered += transaction.getQuantity();
+                result.revenue += transaction.getTotalCost();
+                result.transportCost += transaction.getTransportCost();
             }
-            retailerFile.close();
         }
         
-        // Load transporters
-        std::ifstream transporterFile("transporters.dat");
-        if (transporterFile.is_open()) {
-            std::string line;
-            while (std::getline(transporterFile, line)) {
-                try {
-                    Transporter transporter = Transporter::deserialize(line); // Deserialize transporter from file
-                    transporters.push_back(transporter); // Add transporter to list
+        for (size_t slot = 0; slot < state.stock.size(); ++slot) {
+            if (state.stock[slot] <= 0) {
+                result.productsSoldOut++;
+            }
+        }
+        result.pagesCopied = state.stock.copiedPages() + state.credit.copiedPages();
+        return result;
+    }
+
+    // Function to build every combination of demand multipliers, price threshold scales and
+    // fleets (an empty fleet stands for all transporters)
+    static std::vector<ScenarioSpec> scenarioGrid(const std::vector<double>& demandMultipliers,
+                                                  const std::vector<double>& thresholdScales,
+                                                  const std::vector<std::vector<int>>& fleets) {
+        std::vector<ScenarioSpec> specs;
+        for (const auto& fleet : fleets) {
+            std::string fleetName = "all";
+            if (!fleet.empty()) {
+                fleetName.clear();
+                for (size_t i = 0; i < fleet.size(); ++i) {
+                    fleetName += (i == 0 ? "T" : "+T") + std::to_string(fleet[i]);
                 }
-                catch (const std::exception& e) {
-                    std::cerr << "Error deserializing transporter: " << e.what() << std::endl; // Print error message
+            }
+            for (double threshold : thresholdScales) {
+                for (double demand : demandMultipliers) {
+                    std::stringstream name;
+                    name << std::fixed << std::setprecision(2) << "demand x" << demand << ", cap x" << threshold
+                         << ", fleet " << fleetName;
+                    specs.push_back(ScenarioSpec{name.str(), demand, threshold, fleet});
                 }
             }
-            transporterFile.close();
+        }
+        return specs;
+    }
+
+    // Function to print scenario results side by side. Differences are against the first
+    // unchanged scenario (demand x1, cap x1, every transporter), or the first one if none is.
+    static void printScenarioReport(const std::vector<ScenarioSpec>& specs, const std::vector<ScenarioResult>& results) {
+        std::cout << "\n===== WHAT-IF SCENARIO REPORT =====" << std::endl;
+        if (results.empty()) {
+            std::cout << "No scenarios to compare." << std::endl;
+            return;
+        }
+        size_t base = 0;
+        for (size_t s = 0; s < specs.size(); ++s) {
+            if (specs[s].demandMultiplier == 1.0 && specs[s].priceThresholdScale == 1.0 && specs[s].transporterIds.empty()) {
+                base = s;
+                break;
+            }
         }
         
-        // Load transactions
-        std::ifstream transactionFile("transactions.dat");
-        if (transactionFile.is_open()) {
-            std::string line;
-            while (std::getline(transactionFile, line)) {
-                try {
-                    Transaction transaction = Transaction::deserialize(line); // Deserialize transaction from file
-                    transactions.push_back(transaction); // Add transaction to list
-                }
-                catch (const std::exception& e) {
-                    std::cerr << "Error deserializing transaction: " << e.what() << std::endl; // Print error message
+        std::cout << "Baseline: " << specs[base].name << std::endl;
+        std::cout << std::left << std::setw(40) << "Scenario" << std::right << std::setw(8) << "Orders"
+                  << std::setw(10) << "Complete" << std::setw(9) << "Fail %" << std::setw(11) << "Stock-outs"
+                  << std::setw(15) << "Revenue (RM)" << std::setw(10) << "vs base" << std::setw(15) << "Transport (RM)"
+                  << std::setw(9) << "Sold out" << std::endl;
+        std::cout << std::fixed;
+        size_t best = 0;
+        for (size_t s = 0; s < results.size(); ++s) {
+            const ScenarioResult& result = results[s];
+            double baseRevenue = results[base].revenue;
+            std::stringstream change;
+            change << std::fixed << std::setprecision(1) << std::showpos
+                   << (baseRevenue > 0 ? 100.0 * (result.revenue - baseRevenue) / baseRevenue : 0.0) << "%";
+            std::cout << std::left << std::setw(40) << specs[s].name.substr(0, 39) << std::right << std::setw(8) << result.orders
+                      << std::setw(10) << result.completed << std::setw(9) << std::setprecision(1) << 100.0 * result.failureRate()
+                      << std::setw(11) << result.stockOuts << std::setw(15) << std::setprecision(2) << result.revenue
+                      << std::setw(10) << change.str() << std::setw(15) << result.transportCost
+                      << std::setw(9) << result.productsSoldOut << std::endl;
+            if (result.revenue > results[best].revenue) {
+                best = s;
+            }
+        }
+        std::cout << "Highest revenue: " << specs[best].name << std::endl;
+    }
+
+    // Helper function to parse a comma separated list of numbers, keeping the defaults if
+    // the text is blank
+    static std::vector<double> parseNumberList(const std::string& text, std::vector<double> defaults) {
+        if (trimmed(text).empty()) {
+            return defaults;
+        }
+        std::vector<double> values;
+        FieldReader items(text, "what-if list", ',');
+        while (items.hasMore()) {
+            std::string_view item = trimmed(items.text());
+            double value = items.toNumber<double>(item);
+            if (value < 0) {
+                throw std::runtime_error("Invalid number '" + std::string(item) + "' in what-if list data");
+            }
+            values.push_back(value);
+        }
+        return values;
+    }
+
+    // Helper function to strip the spaces typed around a list entry
+    static std::string_view trimmed(std::string_view text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos) {
+            return std::string_view();
+        }
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    // Helper function to parse fleets written as transporter ID lists separated by ';'
+    // (e.g. "1,2;3"), where '*' or blank text stands for every transporter
+    static std::vector<std::vector<int>> parseFleetList(const std::string& text) {
+        std::vector<std::vector<int>> fleets;
+        std::stringstream stream(text);
+        std::string fleetText;
+        while (std::getline(stream, fleetText, ';')) {
+            if (fleetText.find_first_not_of(" \t\r*") == std::string::npos) {
+                fleets.emplace_back();
+                continue;
+            }
+            std::vector<int> ids;
+            FieldReader items(fleetText, "fleet list", ',');
+            while (items.hasMore()) {
+                std::string_view item = trimmed(items.text());
+                int id = items.toNumber<int>(item); // Rejects fractional IDs such as 1.9
+                if (id < 0) {
+                    throw std::runtime_error("Invalid number '" + std::string(item) + "' in fleet list data");
                 }
+                ids.push_back(id);
             }
-            transactionFile.close();
+            fleets.push_back(std::move(ids));
         }
-        
-        // Load next IDs
-        std::ifstream idFile("nextids.dat");
-        if (idFile.is_open()) {
-            idFile >> nextProductId;
-            idFile >> nextSupplierId;
-            idFile >> nextRetailerId;
-            idFile >> nextTransporterId;
-            idFile >> nextTransactionId;
-            idFile.close();
+        if (fleets.empty()) {
+            fleets.emplace_back();
         }
-        
-        return true; // Return true if all data is loaded successfully
+        return fleets;
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error loading data: " << e.what() << std::endl; // Print error message
-        return false; // Return false if an exception occurs
+
+    // Function to run a grid of what-if scenarios and print the side-by-side report
+    void runScenarioGrid(const std::string& demandText, const std::string& thresholdText, const std::string& fleetText) {
+        std::vector<ScenarioSpec> specs = scenarioGrid(parseNumberList(demandText, {0.8, 1.0, 1.2, 1.5}),
+                                                       parseNumberList(thresholdText, {0.5, 1.0, 2.0}),
+                                                       parseFleetList(fleetText));
+        auto start = std::chrono::steady_clock::now();
+        std::vector<ScenarioResult> results = runScenarios(specs);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printScenarioReport(specs, results);
+        std::cout << specs.size() << " scenario(s) in " << std::fixed << std::setprecision(1) << elapsedMs
+                  << " ms; live data unchanged." << std::endl;
     }
-}
 
-    // Simulation and Reports
-    void runSeasonalSimulation() {
-        std::cout << "\n===== RUNNING SEASONAL SIMULATION =====" << std::endl;
-        
-        // 1. Create seasonal demand
-        int highDemandProductId = 1; // Rice
-        int normalDemandProductId = 2; // Vegetables
-        
-        // 2. Process transactions for all retailers
-        for (const auto& retailer : retailers) {
-            // High demand product transaction (large quantity)
-            std::cout << "Creating seasonal high-demand transaction for " << retailer.getName() << std::endl;
-            createTransaction(1, retailer.getId(), highDemandProductId, 1, 100, "Seasonal");
-            
-            // Normal demand product transaction
-            std::cout << "Creating seasonal normal-demand transaction for " << retailer.getName() << std::endl;
-            createTransaction(2, retailer.getId(), normalDemandProductId, 2, 50, "Seasonal");
+    // Function to ask for the scenario grid and run it
+    void runWhatIfScenarios() {
+        try {
+            std::string demandText;
+            std::string thresholdText;
+            std::string fleetText;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::cout << "Demand multipliers, comma separated (blank for 0.8,1,1.2,1.5): ";
+            std::getline(std::cin, demandText);
+            std::cout << "Price threshold scales (blank for 0.5,1,2): ";
+            std::getline(std::cin, thresholdText);
+            std::cout << "Fleets as transporter IDs, ';' between fleets, '*' for all (blank for all): ";
+            std::getline(std::cin, fleetText);
+            runScenarioGrid(demandText, thresholdText, fleetText);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error running scenarios: " << e.what() << std::endl;
         }
-        
-        std::cout << "Seasonal simulation complete." << std::endl;
     }
 
     void generateDistributionReport() const {
         std::cout << "\n===== DISTRIBUTION REPORT =====" << std::endl;
         
-        // Count transactions by status
-        int completed = 0;
-        int failed = 0;
-        double totalRevenue = 0.0;
-        std::unordered_map<int, int> productQuantities;
-        
-        for (const auto& transaction : transactions) {
-            if (transaction.getStatus() == "Completed") {
-                completed++;
-                totalRevenue += transaction.getTotalCost();
-                
-                // Add to product quantities
-                int productId = transaction.getProductId();
-                int quantity = transaction.getQuantity();
-                productQuantities[productId] += quantity;
-            } else if (transaction.getStatus() == "Failed") {
-                failed++;
-            }
-        }
-        
         // Print summary
-        std::cout << "Completed Transactions: " << completed << std::endl;
-        std::cout << "Failed Transactions: " << failed << std::endl;
-        std::cout << "Total Revenue: RM" << std::fixed << std::setprecision(2) << totalRevenue << std::endl;
+        std::cout << "Completed Transactions: " << reportTotals.completed << std::endl;
+        std::cout << "Failed Transactions: " << reportTotals.failed << std::endl;
+        std::cout << "Total Revenue: RM" << std::fixed << std::setprecision(2) << reportTotals.totalRevenue << std::endl;
         
         // Print product distribution
         std::cout << "\nProduct Distribution:" << std::endl;
-        for (const auto& pair : productQuantities) {
-            int productId = pair.first;
-            int quantity = pair.second;
-            
-            for (const auto& product : products) {
-                if (product.getId() == productId) {
-                    std::cout << product.getName() << ": " << quantity << " units" << std::endl;
-                    break;
-                }
+        for (const auto& product : products) {
+            auto it = reportTotals.productQuantities.find(product.getId());
+            if (it != reportTotals.productQuantities.end()) {
+                std::cout << product.getName() << ": " << it->second << " units" << std::endl;
             }
         }
     }
@@ -1507,9 +7851,14 @@ bool loadData() {
             
             // 4. Select supplier
             int supplierId;
-            std::cout << "\nEnter Supplier ID: ";
+            std::cout << "\nEnter Supplier ID (" << autoSource << " to pick the cheapest source automatically): ";
             std::cin >> supplierId;
             
+            if (supplierId == autoSource) {
+                createPlannedTransaction(retailerId);
+                return;
+            }
+            
             Supplier* supplier = findSupplier(supplierId);
             if (!supplier) {
                 throw std::runtime_error("Supplier not found");
@@ -1530,15 +7879,9 @@ bool loadData() {
             std::cin >> productId;
             
             // Check if supplier has this product
-            bool hasProduct = false;
-            for (int id : supplier->getProductIds()) {
-                if (id == productId) {
-                    hasProduct = true;
-                    break;
-                }
-            }
-            
-            if (!hasProduct) {
+            int supplierSlot = supplierIndex.find(supplierId);
+            int productSlot = productIndex.find(productId);
+            if (productSlot < 0 || !supplyIndex.supplies(static_cast<size_t>(supplierSlot), static_cast<size_t>(productSlot))) {
                 throw std::runtime_error("This supplier does not provide this product");
             }
             
@@ -1573,24 +7916,73 @@ bool loadData() {
         }
     }
 
+    // Order form for automatic sourcing: the planner picks the supplier and transporter
+    void createPlannedTransaction(int retailerId) {
+        displayProducts();
+        
+        int productId;
+        std::cout << "\nEnter Product ID: ";
+        std::cin >> productId;
+        if (!findProduct(productId)) {
+            throw std::runtime_error("Product not found");
+        }
+        
+        int quantity;
+        std::cout << "Enter Quantity: ";
+        std::cin >> quantity;
+        if (quantity <= 0) {
+            throw std::runtime_error("Quantity must be positive");
+        }
+        
+        SourcePlan plan;
+        if (!planOrder(retailerId, productId, quantity, plan)) {
+            throw std::runtime_error("No supplier and transporter can fulfil this order (" +
+                                     std::to_string(plan.candidates) + " candidate(s) checked)");
+        }
+        std::cout << "\nCheapest source out of " << plan.candidates << " candidate(s): "
+                  << findSupplier(plan.supplierId)->getName() << " via " << findTransporter(plan.transporterId)->getName()
+                  << std::fixed << std::setprecision(2)
+                  << "\nDistance: " << plan.distance << " km | Product cost: RM" << plan.productCost
+                  << " | Transport cost: RM" << plan.transportCost << " | Total: RM" << plan.totalCost << std::endl;
+        
+        int transactionId = createTransaction(plan.supplierId, retailerId, productId, plan.transporterId, quantity);
+        if (transactionId != -1) {
+            std::cout << "\nTransaction " << transactionId << " created successfully." << std::endl;
+        } else {
+            std::cout << "\nTransaction failed." << std::endl;
+        }
+    }
+
+    // Function to drop every entity, transaction and block, leaving a genesis-only chain
+    void clearAllData() {
+        settleSnapshots(); // A snapshot still being written views the transactions released below
+        std::unique_lock<std::shared_mutex> entityLock(intakeGate); // Released before resetSystem reloads samples
+        
+        // Clear all data structures
+        products.clear();
+        suppliers.clear();
+        retailers.clear();
+        transporters.clear();
+        transactions.release(); // Hand the chunks back; the sample data needs only one
+        clearIndexes();
+        journal.close(); // The next save writes a fresh checkpoint
+        savedDataUnreadable = false; // A reset deliberately starts over
+        
+        // Reset ID counters
+        nextProductId = 1;
+        nextSupplierId = 1;
+        nextRetailerId = 1;
+        nextTransporterId = 1;
+        nextTransactionId = 1;
+        
+        // Reinitialize blockchain (create new genesis block)
+        std::unique_lock<std::mutex> chainLock = chainWriter.settle();
+        blockchain = Blockchain();
+    }
+
     void resetSystem() {
         try {
-            // Clear all data structures
-            products.clear();
-            suppliers.clear();
-            retailers.clear();
-            transporters.clear();
-            transactions.clear();
-            
-            // Reset ID counters
-            nextProductId = 1;
-            nextSupplierId = 1;
-            nextRetailerId = 1;
-            nextTransporterId = 1;
-            nextTransactionId = 1;
-            
-            // Reinitialize blockchain (create new genesis block)
-            blockchain = Blockchain();
+            clearAllData();
             
             // Re-initialize with sample data
             loadSampleData();
@@ -1622,102 +8014,47 @@ bool loadData() {
                 throw std::runtime_error("Supplier not found");
             }
             
-            // Create distance matrix between all retailers
-            std::vector<std::vector<double>> distances(retailers.size(), std::vector<double>(retailers.size(), 0.0));
-            for (size_t i = 0; i < retailers.size(); ++i) {
-                for (size_t j = 0; j < retailers.size(); ++j) {
-                    if (i != j) {
-                        distances[i][j] = calculateDistance(
-                            retailers[i].getLatitude(), retailers[i].getLongitude(),
-                            retailers[j].getLatitude(), retailers[j].getLongitude()
-                        );
-                    }
-                }
-            }
-            
-            // Map to convert retailer index to ID
-            std::vector<int> indexToId(retailers.size());
-            std::unordered_map<int, size_t> idToIndex;
-            for (size_t i = 0; i < retailers.size(); ++i) {
-                indexToId[i] = retailers[i].getId();
-                idToIndex[retailers[i].getId()] = i;
+            // Plan the tour with the spatial route optimiser (no distance matrix is built)
+            std::vector<RoutePoint> stops;
+            stops.reserve(retailers.size());
+            for (const auto& retailer : retailers) {
+                stops.push_back(RoutePoint{retailer.getLatitude(), retailer.getLongitude()});
             }
+            RouteOptimizer optimizer;
+            std::vector<size_t> order = optimizer.plan(RoutePoint{supplier->getLatitude(), supplier->getLongitude()}, stops);
+            const RouteStats& routeStats = optimizer.lastStats();
             
-            // Greedy TSP algorithm
             std::vector<int> route;
-            std::vector<bool> visited(retailers.size(), false);
-            
-            // Calculate distance from supplier to each retailer
-            std::vector<double> supplierDistances(retailers.size());
-            for (size_t i = 0; i < retailers.size(); ++i) {
-                supplierDistances[i] = calculateDistance(
-                    supplier->getLatitude(), supplier->getLongitude(),
-                    retailers[i].getLatitude(), retailers[i].getLongitude()
-                );
-            }
-            
-            // Start with nearest retailer to supplier
-            size_t currentIndex = 0;
-            double minDist = std::numeric_limits<double>::max();
-            for (size_t i = 0; i < retailers.size(); ++i) {
-                if (supplierDistances[i] < minDist) {
-                    minDist = supplierDistances[i];
-                    currentIndex = i;
-                }
-            }
-            
-            route.push_back(indexToId[currentIndex]);
-            visited[currentIndex] = true;
-            
-            // Greedy selection of nearest unvisited retailer
-            for (size_t i = 1; i < retailers.size(); ++i) {
-                size_t nextIndex = 0;
-                double minDist = std::numeric_limits<double>::max();
-                
-                for (size_t j = 0; j < retailers.size(); ++j) {
-                    if (!visited[j] && distances[currentIndex][j] < minDist) {
-                        minDist = distances[currentIndex][j];
-                        nextIndex = j;
-                    }
-                }
-                
-                route.push_back(indexToId[nextIndex]);
-                visited[nextIndex] = true;
-                currentIndex = nextIndex;
-            }
-            
-            // Calculate total route distance including return to supplier
-            double totalDistance = supplierDistances[idToIndex[route[0]]]; // Supplier to first retailer
-            
-            for (size_t i = 0; i < route.size() - 1; ++i) {
-                totalDistance += distances[idToIndex[route[i]]][idToIndex[route[i+1]]];
+            route.reserve(order.size());
+            for (size_t index : order) {
+                route.push_back(retailers[index].getId());
             }
-            
-            // Add distance from last retailer back to supplier
-            totalDistance += calculateDistance(
-                retailers[idToIndex[route.back()]].getLatitude(), 
-                retailers[idToIndex[route.back()]].getLongitude(),
-                supplier->getLatitude(), supplier->getLongitude()
-            );
+            double totalDistance = routeStats.finalDistance; // Includes the legs from and back to the supplier
             
             // Display optimized route
             std::cout << "\nOptimized Distribution Route:" << std::endl;
             std::cout << "Starting at Supplier: " << supplier->getName() << " (ID: " << supplier->getId() << ")" << std::endl;
             
-            for (size_t i = 0; i < route.size(); ++i) {
-                for (const auto& retailer : retailers) {
-                    if (retailer.getId() == route[i]) {
-                        std::cout << (i+1) << ". " << retailer.getName() 
-                                  << " (ID: " << retailer.getId() << ")" << std::endl;
-                        break;
-                    }
-                }
+            for (size_t i = 0; i < order.size(); ++i) {
+                const Retailer& retailer = retailers[order[i]];
+                std::cout << (i+1) << ". " << retailer.getName() 
+                          << " (ID: " << retailer.getId() << ")" << std::endl;
             }
             
             std::cout << "Return to Supplier: " << supplier->getName() << std::endl;
             std::cout << "Total Distance: " << std::fixed << std::setprecision(2) 
                       << totalDistance << " km" << std::endl;
             
+            // Report how much local search improved on the greedy tour
+            double improvement = routeStats.greedyDistance > 0.0
+                ? 100.0 * (routeStats.greedyDistance - totalDistance) / routeStats.greedyDistance : 0.0;
+            std::cout << "Greedy Tour Distance: " << routeStats.greedyDistance << " km ("
+                      << improvement << "% saved by " << routeStats.twoOptMoves << " 2-opt and "
+                      << routeStats.orOptMoves << " Or-opt moves in " << routeStats.elapsedMs << " ms)" << std::endl;
+            if (totalDistance > 0.0) {
+                std::cout << "Stops per 100 km of Truck Travel: " << (route.size() * 100.0 / totalDistance) << std::endl;
+            }
+            
             // Create distribution plan with estimated costs
             std::cout << "\nDistribution Plan:" << std::endl;
             
@@ -1749,7 +8086,7 @@ bool loadData() {
                << " | Transporter: " << transporterId 
                << " | Cost: " << transportCost;
             
-            blockchain.addBlock(ss.str());
+            chainWriter.submit(ss.str());
             std::cout << "Route optimization recorded in blockchain." << std::endl;
         }
         catch (const std::exception& e) {
@@ -1757,6 +8094,184 @@ bool loadData() {
         }
     }
 
+    void planFleetRoutes() {
+        try {
+            if (retailers.empty()) {
+                throw std::runtime_error("Need retailers to plan fleet routes");
+            }
+            if (transporters.empty()) {
+                throw std::runtime_error("Need transporters to plan fleet routes");
+            }
+
+            std::cout << "\n===== FLEET ROUTE PLANNING (CAPACITATED) =====" << std::endl;
+            
+            // Select the depot
+            displaySuppliers();
+            int supplierId;
+            std::cout << "Enter depot Supplier ID: ";
+            std::cin >> supplierId;
+            
+            Supplier* supplier = findSupplier(supplierId);
+            if (!supplier) {
+                throw std::runtime_error("Supplier not found");
+            }
+            
+            // Select the product whose deliveries are being planned
+            displayProducts();
+            int productId;
+            std::cout << "Select Product ID to deliver: ";
+            std::cin >> productId;
+            
+            Product* product = findProduct(productId);
+            if (!product) {
+                throw std::runtime_error("Product not found");
+            }
+            
+            double defaultLoad;
+            std::cout << "Enter delivery load (kg) for retailers with no order history: ";
+            std::cin >> defaultLoad;
+            if (defaultLoad < 0) {
+                throw std::runtime_error("Delivery load cannot be negative");
+            }
+            
+            // Each retailer's load is its average completed order of the product (1 unit = 1 kg)
+            std::unordered_map<int, std::pair<long long, int>> history; // retailerId -> (quantity, orders)
+            const TransactionColumns& columns = transactionColumns;
+            for (size_t i = 0; i < columns.size(); ++i) {
+                if (columns.productIds[i] == productId && columns.statuses[i] == TransactionStatus::Completed) {
+                    auto& entry = history[columns.retailerIds[i]];
+                    entry.first += columns.quantities[i];
+                    entry.second++;
+                }
+            }
+            
+            std::vector<RoutePoint> stops;
+            std::vector<double> loads;
+            stops.reserve(retailers.size());
+            loads.reserve(retailers.size());
+            for (const auto& retailer : retailers) {
+                stops.push_back(RoutePoint{retailer.getLatitude(), retailer.getLongitude()});
+                auto it = history.find(retailer.getId());
+                loads.push_back(it != history.end() ? static_cast<double>(it->second.first) / it->second.second : defaultLoad);
+            }
+            
+            FleetRouter router;
+            FleetPlan plan = router.plan(RoutePoint{supplier->getLatitude(), supplier->getLongitude()}, stops, loads, transporters);
+            
+            // Display the trips
+            std::cout << "\nFleet Plan from " << supplier->getName() << " (ID: " << supplier->getId() << ")" << std::endl;
+            std::stringstream ss;
+            ss << "Fleet Plan | Supplier: " << supplier->getId() << " | Product: " << productId;
+            std::vector<char> transporterUsed(transporters.size(), 0);
+            bool transporterShared = false; // Some transporter serves more than one trip
+            for (size_t r = 0; r < plan.routes.size(); ++r) {
+                const VehicleRoute& route = plan.routes[r];
+                const Transporter& transporter = transporters[route.vehicle];
+                transporterShared = transporterShared || transporterUsed[route.vehicle];
+                transporterUsed[route.vehicle] = 1;
+                std::cout << "\nTrip " << (r + 1) << ": " << transporter.getName() << " (ID: " << transporter.getId() << ")"
+                          << " | Stops: " << route.stops.size()
+                          << " | Load: " << std::fixed << std::setprecision(2) << route.load
+                          << "/" << transporter.getMaxCapacity() << " kg"
+                          << " | Distance: " << route.distance << " km"
+                          << " | Cost: RM" << transporter.calculateTransportCost(route.distance) << std::endl;
+                std::cout << "  Route: " << supplier->getName();
+                ss << " | Trip " << (r + 1) << " Transporter " << transporter.getId() << ": ";
+                for (size_t stop : route.stops) {
+                    std::cout << " -> " << retailers[stop].getName();
+                    ss << retailers[stop].getId() << ",";
+                }
+                std::cout << " -> " << supplier->getName() << std::endl;
+            }
+            for (size_t stop : plan.unserved) {
+                std::cout << "Cannot serve " << retailers[stop].getName() << ": load of " << loads[stop]
+                          << " kg exceeds every transporter's capacity" << std::endl;
+            }
+            
+            std::cout << "\nTrips: " << plan.routes.size()
+                      << " | Total Distance: " << std::fixed << std::setprecision(2) << plan.totalDistance << " km"
+                      << " | Total Cost: RM" << plan.totalCost << std::endl;
+            if (transporterShared) {
+                std::cout << "Each transporter is one vehicle; its trips run one after another from the depot." << std::endl;
+            }
+            std::cout << "Planned in " << plan.elapsedMs << " ms (" << plan.relocations
+                      << " stops moved between trips)" << std::endl;
+            
+            ss << " | Distance: " << plan.totalDistance << " | Cost: " << plan.totalCost;
+            chainWriter.submit(ss.str());
+            std::cout << "Fleet plan recorded in blockchain." << std::endl;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error planning fleet routes: " << e.what() << std::endl;
+        }
+    }
+
+    // Helper function to work out one product's allocation plan from its history.
+    // Reads only this product's postings, so products can be planned in parallel.
+    InventoryPlan planProductInventory(const Product& product) const {
+        InventoryPlan plan;
+        plan.productId = product.getId();
+        plan.totalStock = product.getStock();
+        size_t retailerCount = retailers.size();
+        
+        // Demand row of this product, by retailer slot
+        plan.demand.assign(retailerCount, 0);
+        const TransactionColumns& columns = transactionColumns;
+        for (uint32_t slot : historyIndex.productHistory(product.getId())) {
+            if (columns.statuses[slot] == TransactionStatus::Completed) {
+                int retailerSlot = retailerIndex.find(columns.retailerIds[slot]);
+                if (retailerSlot >= 0) {
+                    plan.demand[retailerSlot] += columns.quantities[slot];
+                }
+                plan.totalDemand += columns.quantities[slot];
+            }
+        }
+        
+        // Allocate stock in proportion to historical demand; retailers with no history get
+        // an equal split when the product has no history at all
+        int equalAllocation = retailerCount > 0 ? plan.totalStock / static_cast<int>(retailerCount) : 0;
+        plan.initialAllocation.resize(retailerCount);
+        double totalAllocation = 0;
+        for (size_t r = 0; r < retailerCount; ++r) {
+            int allocation = equalAllocation;
+            if (plan.totalDemand > 0) {
+                double demandPercentage = static_cast<double>(plan.demand[r]) / plan.totalDemand;
+                allocation = static_cast<int>(plan.totalStock * demandPercentage);
+            }
+            allocation = std::max(allocation, 10); // Minimum 10 units of safety stock
+            plan.initialAllocation[r] = allocation;
+            totalAllocation += allocation;
+        }
+        
+        // Scale down if the allocation exceeds the stock on hand
+        plan.allocation = plan.initialAllocation;
+        if (totalAllocation > plan.totalStock) {
+            double adjustmentFactor = plan.totalStock / totalAllocation;
+            for (int& allocation : plan.allocation) {
+                allocation = static_cast<int>(allocation * adjustmentFactor);
+            }
+            plan.adjusted = true;
+        }
+        
+        // Compare holding costs against an equal split
+        double holdingCost = product.getPrice() * 0.2; // 20% of product price as annual holding cost
+        for (size_t r = 0; r < retailerCount; ++r) {
+            plan.currentHoldingCost += equalAllocation * holdingCost;
+            plan.optimizedHoldingCost += plan.allocation[r] * holdingCost;
+        }
+        plan.savings = plan.currentHoldingCost - plan.optimizedHoldingCost;
+        return plan;
+    }
+
+    // Helper function to describe a plan as a blockchain entry
+    static std::string inventoryPlanBlockData(const InventoryPlan& plan) {
+        std::stringstream ss;
+        ss << "Inventory Optimization | Product: " << plan.productId 
+           << " | Total Stock: " << plan.totalStock
+           << " | Optimization Savings: " << plan.savings;
+        return ss.str();
+    }
+
     void optimizeInventory() {
         try {
             std::cout << "\n===== INVENTORY OPTIMIZATION =====" << std::endl;
@@ -1778,105 +8293,39 @@ bool loadData() {
             }
             
             // Analyze transaction history to determine demand patterns
-            std::unordered_map<int, int> retailerDemand; // retailerId -> total quantity
-            std::unordered_map<int, int> transactionCount; // retailerId -> transaction count
-            
-            for (const auto& transaction : transactions) {
-                if (transaction.getProductId() == productId && transaction.getStatus() == "Completed") {
-                    int retailerId = transaction.getRetailerId();
-                    retailerDemand[retailerId] += transaction.getQuantity();
-                    transactionCount[retailerId]++;
-                }
-            }
-            
-            // Calculate total available stock
-            int totalStock = product->getStock();
-            int totalDemand = 0;
-            
-            for (const auto& pair : retailerDemand) {
-                totalDemand += pair.second;
-            }
+            InventoryPlan plan = planProductInventory(*product);
             
-            std::cout << "\nCurrent Product Stock: " << totalStock << " units" << std::endl;
-            std::cout << "Total Historical Demand: " << totalDemand << " units" << std::endl;
+            std::cout << "\nCurrent Product Stock: " << plan.totalStock << " units" << std::endl;
+            std::cout << "Total Historical Demand: " << plan.totalDemand << " units" << std::endl;
             
-            // Calculate allocation based on historical demand percentage
-            std::unordered_map<int, int> optimalAllocation;
+            // Display allocation based on historical demand percentage
             std::cout << "\nOptimal Inventory Allocation:" << std::endl;
             std::cout << "--------------------------------" << std::endl;
             std::cout << "Retailer\t\tHistorical Demand\tOptimal Allocation" << std::endl;
             
-            for (const auto& retailer : retailers) {
-                int retailerId = retailer.getId();
-                int demand = retailerDemand[retailerId];
-                int allocation = 0;
-                
-                // Calculate allocation - retailers with no history get minimum stock
-                if (totalDemand > 0) {
-                    double demandPercentage = static_cast<double>(demand) / totalDemand;
-                    allocation = static_cast<int>(totalStock * demandPercentage);
-                } else {
-                    // Equal distribution if no historical data
-                    allocation = totalStock / retailers.size();
-                }
-                
-                // Ensure minimum allocation (safety stock)
-                allocation = std::max(allocation, 10); // Minimum 10 units
-                
-                optimalAllocation[retailerId] = allocation;
-                
-                std::cout << retailer.getName() << " (ID: " << retailerId << ")\t" 
-                          << demand << " units\t\t" 
-                          << allocation << " units" << std::endl;
-            }
-            
-            // Calculate efficiency metrics
-            double totalAllocation = 0;
-            for (const auto& pair : optimalAllocation) {
-                totalAllocation += pair.second;
+            for (size_t r = 0; r < retailers.size(); ++r) {
+                std::cout << retailers[r].getName() << " (ID: " << retailers[r].getId() << ")\t" 
+                          << plan.demand[r] << " units\t\t" 
+                          << plan.initialAllocation[r] << " units" << std::endl;
             }
             
-            // Adjust if total allocation exceeds stock
-            if (totalAllocation > totalStock) {
-                double adjustmentFactor = totalStock / totalAllocation;
-                
+            if (plan.adjusted) {
                 std::cout << "\nAdjusting allocation to match available stock..." << std::endl;
                 
-                for (auto& pair : optimalAllocation) {
-                    pair.second = static_cast<int>(pair.second * adjustmentFactor);
-                }
-                
                 // Display adjusted allocation
                 std::cout << "\nAdjusted Inventory Allocation:" << std::endl;
                 std::cout << "--------------------------------" << std::endl;
                 
-                for (const auto& retailer : retailers) {
-                    int retailerId = retailer.getId();
-                    std::cout << retailer.getName() << " (ID: " << retailerId << ")\t" 
-                              << optimalAllocation[retailerId] << " units" << std::endl;
+                for (size_t r = 0; r < retailers.size(); ++r) {
+                    std::cout << retailers[r].getName() << " (ID: " << retailers[r].getId() << ")\t" 
+                              << plan.allocation[r] << " units" << std::endl;
                 }
             }
             
-            // Calculate potential savings
-            double serviceLevel = 0.95; // 95% service level target
-            double holdingCost = product->getPrice() * 0.2; // 20% of product price as annual holding cost
-            double currentHoldingCost = 0;
-            double optimizedHoldingCost = 0;
-            
-            // Estimate current inventory distribution (equally distributed)
-            int equalAllocation = totalStock / retailers.size();
-            
-            for (const auto& retailer : retailers) {
-                currentHoldingCost += equalAllocation * holdingCost;
-                optimizedHoldingCost += optimalAllocation[retailer.getId()] * holdingCost;
-            }
-            
-            double savings = currentHoldingCost - optimizedHoldingCost;
-            
             std::cout << "\nInventory Cost Analysis:" << std::endl;
-            std::cout << "Estimated Current Holding Cost: RM" << std::fixed << std::setprecision(2) << currentHoldingCost << std::endl;
-            std::cout << "Optimized Holding Cost: RM" << std::fixed << std::setprecision(2) << optimizedHoldingCost << std::endl;
-            std::cout << "Potential Annual Savings: RM" << std::fixed << std::setprecision(2) << savings << std::endl;
+            std::cout << "Estimated Current Holding Cost: RM" << std::fixed << std::setprecision(2) << plan.currentHoldingCost << std::endl;
+            std::cout << "Optimized Holding Cost: RM" << std::fixed << std::setprecision(2) << plan.optimizedHoldingCost << std::endl;
+            std::cout << "Potential Annual Savings: RM" << std::fixed << std::setprecision(2) << plan.savings << std::endl;
             
             // Ask user if they want to implement the optimization
             char implement;
@@ -1885,12 +8334,7 @@ bool loadData() {
             
             if (implement == 'y' || implement == 'Y') {
                 // Record in blockchain
-                std::stringstream ss;
-                ss << "Inventory Optimization | Product: " << product->getId() 
-                   << " | Total Stock: " << totalStock
-                   << " | Optimization Savings: " << savings;
-                
-                blockchain.addBlock(ss.str());
+                chainWriter.submit(inventoryPlanBlockData(plan));
                 
                 std::cout << "Inventory optimization plan recorded in blockchain." << std::endl;
                 std::cout << "To implement: Create transactions to distribute inventory according to the plan." << std::endl;
@@ -1901,6 +8345,84 @@ bool loadData() {
         }
     }
 
+    // Function to optimize every product's inventory in one run, without prompting, so it
+    // can be scheduled. Products are planned on all cores at once, a summary report is
+    // printed and, when record is set, the plans are recorded in the blockchain in batches.
+    std::vector<InventoryPlan> optimizeAllInventory(bool record = true) {
+        std::vector<InventoryPlan> plans;
+        try {
+            std::cout << "\n===== INVENTORY OPTIMIZATION (ALL PRODUCTS) =====" << std::endl;
+            
+            if (products.empty() || retailers.empty()) {
+                throw std::runtime_error("Need products and retailers to optimize inventory");
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> ledgerLock(ledgerMutex); // Hold the history still while it is read
+                plans.resize(products.size());
+                unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+                parallelFor(products.size(), threads, [this, &plans](size_t p) {
+                    plans[p] = planProductInventory(products[p]);
+                });
+            }
+            double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            
+            std::cout << "Product\t\tStock\tDemand\tAllocated\tCurrent Cost\tOptimized Cost\tSavings" << std::endl;
+            std::cout << "--------------------------------------------------------------------------------" << std::endl;
+            double totalSavings = 0;
+            bool anyAdjusted = false;
+            for (size_t p = 0; p < plans.size(); ++p) {
+                const InventoryPlan& plan = plans[p];
+                long long allocated = 0;
+                for (int allocation : plan.allocation) {
+                    allocated += allocation;
+                }
+                totalSavings += plan.savings;
+                anyAdjusted = anyAdjusted || plan.adjusted;
+                std::cout << products[p].getName() << " (ID: " << plan.productId << ")\t"
+                          << plan.totalStock << "\t" << plan.totalDemand << "\t" << allocated
+                          << (plan.adjusted ? "*" : "") << "\t\t"
+                          << std::fixed << std::setprecision(2)
+                          << "RM" << plan.currentHoldingCost << "\tRM" << plan.optimizedHoldingCost
+                          << "\tRM" << plan.savings << std::endl;
+            }
+            std::cout << "--------------------------------------------------------------------------------" << std::endl;
+            if (anyAdjusted) {
+                std::cout << "* Allocation scaled down to the stock on hand" << std::endl;
+            }
+            std::cout << "Products optimized: " << plans.size() << " across " << retailers.size() << " retailers" << std::endl;
+            std::cout << "Total Potential Annual Savings: RM" << std::fixed << std::setprecision(2) << totalSavings << std::endl;
+            std::cout << "Planning time: " << std::setprecision(3) << elapsedMs << " ms" << std::endl;
+            
+            if (record) {
+                recordInventoryPlans(plans);
+                std::cout << "Inventory optimization plans recorded in blockchain." << std::endl;
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error optimizing inventory: " << e.what() << std::endl;
+        }
+        return plans;
+    }
+
+    // Helper function to record plans as a run of blocks, up to ordersPerBlock plans each
+    void recordInventoryPlans(const std::vector<InventoryPlan>& plans) {
+        if (plans.size() == 1) {
+            chainWriter.submit(inventoryPlanBlockData(plans[0]));
+            return;
+        }
+        for (size_t start = 0; start < plans.size(); start += ordersPerBlock) {
+            size_t end = std::min(plans.size(), start + ordersPerBlock);
+            std::string blockData = "Inventory Optimization Batch | Products: " + std::to_string(end - start);
+            for (size_t p = start; p < end; ++p) {
+                blockData += " || "; // Separator between plans in one block
+                blockData += inventoryPlanBlockData(plans[p]);
+            }
+            chainWriter.submit(std::move(blockData));
+        }
+    }
+
     void addNewProduct() {
         try {
             std::string name;
@@ -1978,8 +8500,7 @@ bool loadData() {
 
                     if (productId == 0) break;
 
-                    if (findProduct(productId)) {
-                        findSupplier(id)->addProduct(productId);
+                    if (linkSupplierProduct(id, productId)) {
                         std::cout << "Product linked to supplier." << std::endl;
                     } else {
                         std::cout << "Product not found. Try again." << std::endl;
@@ -2080,15 +8601,719 @@ bool loadData() {
             std::cerr << "Error adding transporter: " << e.what() << std::endl;
         }
     }
+
+    // Function to list the smart contracts and add new ones (contracts last for the session)
+    void manageContracts() {
+        try {
+            std::cout << "\n===== SMART CONTRACTS =====" << std::endl;
+            for (size_t i = 0; i < contracts.size(); ++i) {
+                std::cout << i + 1 << ". " << contracts[i]->getDescription() << std::endl;
+            }
+            
+            std::cout << "\nAdd contract: 1. Retailer Credit Cap  2. Product Quota  "
+                      << "3. Transporter Capacity  4. Region Embargo  0. Back" << std::endl;
+            std::cout << "Enter your choice: ";
+            int choice;
+            if (!(std::cin >> choice)) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                throw std::runtime_error("Invalid choice");
+            }
+            
+            // Reads an int or a double; "1.5" entered for an int is refused rather than cut to 1
+            auto readPositive = [](const char* prompt, auto& value) {
+                std::cout << prompt;
+                bool read = static_cast<bool>(std::cin >> value);
+                int next = read ? std::cin.peek() : EOF;
+                if (!read || value <= 0 || (next != EOF && !std::isspace(next))) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    throw std::runtime_error("Invalid value");
+                }
+            };
+            
+            switch (choice) {
+                case 0:
+                    return;
+                case 1: {
+                    int retailerId;
+                    double cap;
+                    readPositive("Enter retailer ID: ", retailerId);
+                    if (retailerIndex.find(retailerId) < 0) {
+                        throw std::runtime_error("Retailer not found");
+                    }
+                    readPositive("Enter maximum order cost (RM): ", cap);
+                    addContract(std::make_unique<RetailerCreditCapContract>(
+                        contractContext, std::vector<std::pair<int, double>>{{retailerId, cap}}));
+                    break;
+                }
+                case 2: {
+                    int productId, quota;
+                    readPositive("Enter product ID: ", productId);
+                    if (productIndex.find(productId) < 0) {
+                        throw std::runtime_error("Product not found");
+                    }
+                    readPositive("Enter maximum order quantity: ", quota);
+                    addContract(std::make_unique<ProductQuotaContract>(
+                        contractContext, std::vector<std::pair<int, int>>{{productId, quota}}));
+                    break;
+                }
+                case 3: {
+                    double unitWeight;
+                    readPositive("Enter weight of one unit (kg): ", unitWeight);
+                    addContract(std::make_unique<TransporterCapacityContract>(contractContext, unitWeight));
+                    break;
+                }
+                case 4: {
+                    std::string region;
+                    std::cout << "Enter embargoed region (e.g., Selangor): ";
+                    std::cin.ignore();
+                    std::getline(std::cin, region);
+                    if (region.empty()) {
+                        throw std::runtime_error("Region cannot be empty");
+                    }
+                    addContract(std::make_unique<RegionEmbargoContract>(contractContext, region));
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Invalid choice");
+            }
+            std::cout << "Contract added: " << contracts.back()->getDescription() << std::endl;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error adding contract: " << e.what() << std::endl;
+        }
+    }
+};
+
+// BatchStats struct
+// Counters reported at the end of a headless batch run
+struct BatchStats {
+    size_t lines = 0; // Lines read, including blanks and comments
+    size_t commands = 0; // Commands executed
+    size_t errors = 0; // Commands that failed
+    size_t orders = 0; // Orders submitted
+    size_t completed = 0; // Orders completed
+    size_t failed = 0; // Orders recorded as failed (contract or credit)
+    size_t rejected = 0; // Orders refused before a transaction was created
+    double elapsedMs = 0.0;
+};
+
+// BatchRunner class
+// Headless driver for scripting and bulk imports. Reads one command per line, with fields
+// separated by '|' as in the .dat files, and calls the system directly instead of going
+// through the menu prompts. Consecutive orders are buffered and submitted through batch
+// ingestion; any other command first submits the buffered orders, so commands take effect
+// in file order. Error messages are collected and printed once at the end.
+//
+//   order|supplierId|retailerId|productId|transporterId|quantity[|orderType]
+//                    (supplier or transporter ID 0 lets the order planner pick the cheapest)
+//   product|name|price|stock
+//   supplier|name|location|branch|latitude|longitude
+//   link|supplierId|productId
+//   retailer|name|location|latitude|longitude|credit|annualCredit
+//   transporter|name|type|costPerKm|capacity
+//   metrics[|file]   (file ending in .json writes JSON, otherwise Prometheus text; default metrics.prom)
+//   what-if[|demand multipliers|price threshold scales|fleets]
+//                    (comma separated lists; fleets are transporter ID lists separated by ';', '*' for all)
+//   simulate | optimize-inventory | save | load | export | reset
+//
+// Blank lines and lines starting with '#' are ignored.
+class BatchRunner {
+private:
+    static const size_t orderBatchSize = 4096; // Orders buffered before they are submitted
+    static const size_t maxErrorMessages = 100; // Messages kept for the final report
+    
+    ProductionPlanningSystem& system;
+    std::vector<OrderRequest> pendingOrders;
+    std::vector<size_t> pendingLines; // Line number of each buffered order
+    std::vector<std::pair<size_t, std::string>> errorLog; // (line, message) of the first errors
+    BatchStats stats;
+
+    // Helper function to record a failed command
+    void error(size_t line, const std::string& message) {
+        stats.errors++;
+        if (errorLog.size() < maxErrorMessages) {
+            errorLog.emplace_back(line, message);
+        }
+    }
+
+    // Helper function to submit the buffered orders as one batch
+    void flushOrders() {
+        if (pendingOrders.empty()) {
+            return;
+        }
+        std::vector<OrderResult> results = system.createTransactions(pendingOrders);
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].outcome == OrderOutcome::Completed) {
+                stats.completed++;
+            } else if (results[i].transactionId != -1) {
+                stats.failed++;
+            } else {
+                stats.rejected++;
+                error(pendingLines[i], "order rejected: " + orderOutcomeToString(results[i].outcome));
+            }
+        }
+        pendingOrders.clear();
+        pendingLines.clear();
+    }
+
+    // Helper function to split a line into its '|' separated fields
+    static std::vector<std::string> splitFields(std::string_view line) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (;;) {
+            size_t separator = line.find('|', start);
+            if (separator == std::string_view::npos) {
+                fields.emplace_back(line.substr(start));
+                return fields;
+            }
+            fields.emplace_back(line.substr(start, separator - start));
+            start = separator + 1;
+        }
+    }
+
+    // Helper function to check a command's field count
+    static void expectFields(const std::vector<std::string>& fields, size_t minimum, size_t maximum) {
+        if (fields.size() < minimum || fields.size() > maximum) {
+            throw std::runtime_error("expected " + std::to_string(minimum - 1) + " argument(s) for '" + fields[0] + "'");
+        }
+    }
+
+    // Helper functions to convert a whole argument to a number, so "12abc" is an error
+    // rather than 12
+    static int integerField(const std::vector<std::string>& fields, size_t index) {
+        return FieldReader(fields[index], fields[0].c_str()).integer();
+    }
+    static double numberField(const std::vector<std::string>& fields, size_t index) {
+        return FieldReader(fields[index], fields[0].c_str()).number();
+    }
+
+    // Helper function to execute one command, throws on malformed input
+    void runCommand(const std::vector<std::string>& fields, size_t line) {
+        const std::string& command = fields[0];
+        if (command == "order") {
+            expectFields(fields, 6, 7);
+            OrderType orderType = fields.size() == 7 ? parseOrderType(fields[6]) : OrderType::Regular;
+            pendingOrders.push_back(OrderRequest{integerField(fields, 1), integerField(fields, 2), integerField(fields, 3),
+                                                 integerField(fields, 4), integerField(fields, 5), orderType});
+            pendingLines.push_back(line);
+            stats.orders++;
+            if (pendingOrders.size() >= orderBatchSize) {
+                flushOrders();
+            }
+            return;
+        }
+        
+        flushOrders(); // Earlier orders take effect before anything else
+        bool ok = true;
+        if (command == "product") {
+            expectFields(fields, 4, 4);
+            ok = system.addProduct(fields[1], numberField(fields, 2), integerField(fields, 3)) != -1;
+        } else if (command == "supplier") {
+            expectFields(fields, 6, 6);
+            ok = system.addSupplier(fields[1], fields[2], fields[3], numberField(fields, 4), numberField(fields, 5)) != -1;
+        } else if (command == "link") {
+            expectFields(fields, 3, 3);
+            ok = system.linkSupplierProduct(integerField(fields, 1), integerField(fields, 2));
+        } else if (command == "retailer") {
+            expectFields(fields, 7, 7);
+            ok = system.addRetailer(fields[1], fields[2], numberField(fields, 3), numberField(fields, 4),
+                                    numberField(fields, 5), numberField(fields, 6)) != -1;
+        } else if (command == "transporter") {
+            expectFields(fields, 5, 5);
+            ok = system.addTransporter(fields[1], fields[2], numberField(fields, 3), numberField(fields, 4)) != -1;
+        } else if (command == "simulate") {
+            expectFields(fields, 1, 1);
+            SeasonalRunStats season = system.simulateSeason([&](const OrderRequest& order, const OrderResult& result) {
+                error(line, "seasonal order for retailer " + std::to_string(order.retailerId) + " rejected: " +
+                                orderOutcomeToString(result.outcome));
+            });
+            stats.orders += season.orders;
+            stats.completed += season.completed;
+            stats.failed += season.failed;
+            stats.rejected += season.rejected;
+        } else if (command == "optimize-inventory") {
+            expectFields(fields, 1, 1);
+            system.optimizeAllInventory();
+        } else if (command == "what-if") {
+            expectFields(fields, 1, 4);
+            system.runScenarioGrid(fields.size() > 1 ? fields[1] : "", fields.size() > 2 ? fields[2] : "",
+                                   fields.size() > 3 ? fields[3] : "");
+        } else if (command == "save") {
+            expectFields(fields, 1, 1);
+            ok = system.saveData();
+        } else if (command == "load") {
+            expectFields(fields, 1, 1);
+            ok = system.loadData();
+        } else if (command == "export") {
+            expectFields(fields, 1, 1);
+            ok = system.exportTextData();
+        } else if (command == "reset") {
+            expectFields(fields, 1, 1);
+            system.resetSystem();
+        } else if (command == "metrics") {
+            expectFields(fields, 1, 2);
+            system.settleChain(); // Include the blocks of every order so far
+            ok = system.exportMetrics(fields.size() == 2 ? fields[1] : "metrics.prom");
+        } else {
+            throw std::runtime_error("unknown command '" + command + "'");
+        }
+        if (!ok) {
+            error(line, "'" + command + "' failed");
+        }
+    }
+
+public:
+    // Constructor to attach the runner to a system
+    explicit BatchRunner(ProductionPlanningSystem& target) : system(target) {}
+
+    // Function to execute every command read from input
+    void run(std::istream& input) {
+        auto start = std::chrono::steady_clock::now();
+        std::string line;
+        while (std::getline(input, line)) {
+            stats.lines++;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back(); // Tolerate files written with CRLF line endings
+            }
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            stats.commands++;
+            try {
+                runCommand(splitFields(line), stats.lines);
+            }
+            catch (const std::exception& e) {
+                error(stats.lines, e.what());
+            }
+        }
+        flushOrders();
+        system.settleChain(); // Count the blocks of this run in the elapsed time
+        stats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Function to get the counters of the run so far
+    const BatchStats& getStats() const { return stats; }
+
+    // Function to print the collected errors and throughput figures
+    void printReport(std::ostream& out) const {
+        // Order errors are found when their batch is submitted, so restore file order
+        std::vector<std::pair<size_t, std::string>> errors = errorLog;
+        std::stable_sort(errors.begin(), errors.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& entry : errors) {
+            out << "Line " << entry.first << ": " << entry.second << '\n';
+        }
+        if (stats.errors > maxErrorMessages) {
+            out << "... " << stats.errors - maxErrorMessages << " more error(s)\n";
+        }
+        double seconds = stats.elapsedMs / 1000.0;
+        out << "\n===== BATCH RUN COMPLETE =====\n"
+            << "Lines: " << stats.lines << " | Commands: " << stats.commands << " | Errors: " << stats.errors << '\n'
+            << "Orders: " << stats.orders << " (Completed: " << stats.completed << ", Failed: " << stats.failed
+            << ", Rejected: " << stats.rejected << ")\n"
+            << "Elapsed: " << std::fixed << std::setprecision(1) << stats.elapsedMs << " ms\n";
+        if (seconds > 0) {
+            out << "Throughput: " << std::setprecision(0) << stats.commands / seconds << " commands/s, "
+                << stats.orders / seconds << " orders/s\n";
+        }
+        out.flush();
+    }
+};
+
+// Function to run a command file without the menu ("-" reads standard input)
+int runBatchMode(const std::string& path) {
+    std::ios::sync_with_stdio(false); // Buffered output; nothing here is interleaved with C stdio
+    ProductionPlanningSystem system;
+    BatchRunner runner(system);
+    if (path == "-") {
+        runner.run(std::cin);
+    } else {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Could not open command file: " << path << std::endl;
+            return 1;
+        }
+        runner.run(file);
+    }
+    runner.printReport(std::cout);
+    return runner.getStats().errors == 0 ? 0 : 2;
+}
+
+// Function to load a chain file with its sealed segments and verify it, for scripted checks
+// such as confirming the shipped legacy blockchain.dat still verifies. Returns 0 if valid.
+int runVerifyMode(const std::string& filename) {
+    Blockchain chain;
+    if (!chain.loadFromFile(filename)) {
+        return 1;
+    }
+    ChainVerificationResult verification = chain.verify();
+    std::cout << filename << ": " << chain.size() << " block(s), " << chain.segmentCount() << " sealed segment(s), "
+              << verification.hashedBlocks << " content-hashed, " << verification.legacyBlocks << " legacy" << std::endl;
+    if (!verification.valid) {
+        std::cout << "Blockchain integrity: COMPROMISED at block position " << verification.firstInvalidBlock << std::endl;
+        return 2;
+    }
+    std::cout << "Blockchain integrity: VALID" << std::endl;
+    return 0;
+}
+
+// BenchmarkConfig struct
+// Size of the synthetic world a benchmark run generates
+struct BenchmarkConfig {
+    int products = 1000;
+    int suppliers = 200;
+    int retailers = 5000;
+    int transporters = 50;
+    int transactions = 200000; // Orders ingested while building the world
+    int singleOrders = 10000; // Orders timed one at a time for latency percentiles
+    unsigned seed = 42;
+};
+
+// LatencySample class
+// Wall-clock durations of repeated runs of one operation
+class LatencySample {
+private:
+    std::vector<double> durationsMs;
+    size_t operationsPerRun = 1; // Operations covered by each timed run, for ops/s
+
+public:
+    explicit LatencySample(size_t operations = 1) : operationsPerRun(operations) {}
+
+    // Time one run of work
+    template <typename Work>
+    void time(Work work) {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        durationsMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // Function to get the duration below which the given fraction of runs finished
+    double percentile(double fraction) const {
+        if (durationsMs.empty()) {
+            return 0.0;
+        }
+        std::vector<double> sorted = durationsMs;
+        size_t rank = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+
+    // Function to get operations completed per second over all runs
+    double operationsPerSecond() const {
+        double totalMs = 0;
+        for (double duration : durationsMs) {
+            totalMs += duration;
+        }
+        return totalMs > 0 ? durationsMs.size() * operationsPerRun * 1000.0 / totalMs : 0.0;
+    }
+
+    // Function to get the number of runs
+    size_t runs() const { return durationsMs.size(); }
+};
+
+// ScopedStreamRedirect class
+// Points a standard stream at another buffer for the lifetime of the object. Used to feed
+// prepared answers to the interactive functions and to discard their output while timing.
+class ScopedStreamRedirect {
+private:
+    std::ios& stream;
+    std::streambuf* previous;
+
+public:
+    ScopedStreamRedirect(std::ios& target, std::streambuf* buffer) : stream(target), previous(target.rdbuf(buffer)) {}
+    ~ScopedStreamRedirect() { stream.rdbuf(previous); }
+    ScopedStreamRedirect(const ScopedStreamRedirect&) = delete;
+    ScopedStreamRedirect& operator=(const ScopedStreamRedirect&) = delete;
 };
 
+// Utility function to get the peak resident memory of the process in megabytes
+double peakResidentMegabytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // Bytes on macOS
+#else
+    return usage.ru_maxrss / 1024.0; // Kilobytes on Linux
+#endif
+#endif
+}
+
+// Utility function to build a synthetic world on top of the sample data: entities spread
+// over Peninsular Malaysia, every product stocked by at least one supplier, and enough
+// stock and credit for the generated orders to complete
+void generateSyntheticWorld(ProductionPlanningSystem& system, const BenchmarkConfig& config,
+                            std::vector<OrderRequest>& orders, std::mt19937& random) {
+    std::uniform_real_distribution<double> latitude(1.3, 6.7);
+    std::uniform_real_distribution<double> longitude(100.2, 104.3);
+    std::uniform_real_distribution<double> price(1.0, 20.0);
+    
+    std::vector<int> productIds, supplierIds, retailerIds, transporterIds;
+    for (int i = 0; i < config.products; ++i) {
+        productIds.push_back(system.addProduct("Product " + std::to_string(i), price(random), 1 << 30));
+    }
+    for (int i = 0; i < config.suppliers; ++i) {
+        supplierIds.push_back(system.addSupplier("Supplier " + std::to_string(i), "Synthetic location",
+                                                 "Synthetic branch", latitude(random), longitude(random)));
+    }
+    
+    // Each product gets one to three suppliers
+    std::vector<std::vector<int>> productSuppliers(productIds.size());
+    for (size_t p = 0; p < productIds.size() && !supplierIds.empty(); ++p) {
+        int links = 1 + static_cast<int>(random() % 3);
+        for (int l = 0; l < links; ++l) {
+            int supplierId = supplierIds[random() % supplierIds.size()];
+            if (std::find(productSuppliers[p].begin(), productSuppliers[p].end(), supplierId) == productSuppliers[p].end() &&
+                system.linkSupplierProduct(supplierId, productIds[p])) {
+                productSuppliers[p].push_back(supplierId);
+            }
+        }
+    }
+    
+    for (int i = 0; i < config.retailers; ++i) {
+        retailerIds.push_back(system.addRetailer("Retailer " + std::to_string(i), "Synthetic location",
+                                                 latitude(random), longitude(random), 1e12, 1e13));
+    }
+    for (int i = 0; i < config.transporters; ++i) {
+        transporterIds.push_back(system.addTransporter("Transporter " + std::to_string(i), "Ordinary Ground Transfer",
+                                                       1.0 + (random() % 300) / 100.0, 1e9));
+    }
+    
+    // Orders over random products, each from one of the product's suppliers
+    size_t orderCount = static_cast<size_t>(std::max(0, config.transactions)) + static_cast<size_t>(std::max(0, config.singleOrders));
+    orders.clear();
+    orders.reserve(orderCount);
+    while (orders.size() < orderCount && !productIds.empty() && !retailerIds.empty() && !transporterIds.empty()) {
+        size_t p = random() % productIds.size();
+        if (productSuppliers[p].empty()) {
+            continue;
+        }
+        orders.push_back(OrderRequest{productSuppliers[p][random() % productSuppliers[p].size()],
+                                      retailerIds[random() % retailerIds.size()], productIds[p],
+                                      transporterIds[random() % transporterIds.size()],
+                                      1 + static_cast<int>(random() % 50), OrderType::Regular});
+    }
+}
+
+// Function to run the benchmark suite in a scratch directory and print its figures
+int runBenchmarkMode(const BenchmarkConfig& config) {
+    namespace fs = std::filesystem;
+    fs::path originalDirectory = fs::current_path();
+    fs::path scratch = fs::temp_directory_path() / ("mads-benchmark-" + std::to_string(std::random_device()()));
+    fs::create_directories(scratch);
+    fs::current_path(scratch); // The system reads and writes its data files in the working directory
+    
+    std::ostringstream discarded;
+    std::vector<std::pair<std::string, LatencySample>> results;
+    {
+        ProductionPlanningSystem system;
+        std::mt19937 random(config.seed);
+        std::vector<OrderRequest> orders;
+        
+        std::cout << "Generating world: " << config.products << " products, " << config.suppliers << " suppliers, "
+                  << config.retailers << " retailers, " << config.transporters << " transporters" << std::endl;
+        generateSyntheticWorld(system, config, orders, random);
+        size_t bulkOrders = std::min(orders.size(), static_cast<size_t>(std::max(0, config.transactions)));
+        
+        // Batch ingestion of the bulk orders
+        const size_t batchSize = 4096;
+        LatencySample ingestion(batchSize);
+        for (size_t start = 0; start < bulkOrders; start += batchSize) {
+            size_t count = std::min(batchSize, bulkOrders - start);
+            ingestion.time([&]() { system.createTransactions(orders.data() + start, count); });
+        }
+        results.emplace_back("createTransactions (batch of 4096)", ingestion);
+        
+        // One order at a time, for per-order latency
+        LatencySample single;
+        for (size_t i = bulkOrders; i < orders.size(); ++i) {
+            single.time([&]() { system.createTransactions(&orders[i], 1); });
+        }
+        system.settleChain();
+        results.emplace_back("createTransaction (single order)", single);
+        
+        // Automatic sourcing of the same orders, planning only
+        LatencySample planning;
+        SourcePlan plan;
+        size_t candidates = 0;
+        for (size_t i = bulkOrders; i < orders.size(); ++i) {
+            planning.time([&]() { system.planOrder(orders[i].retailerId, orders[i].productId, orders[i].quantity, plan); });
+            candidates += plan.candidates;
+        }
+        size_t plannedOrders = orders.size() - bulkOrders;
+        results.emplace_back("planOrder (" + std::to_string(plannedOrders ? candidates / plannedOrders : 0) +
+                             " candidates per order)", planning);
+        
+        ScopedStreamRedirect silence(std::cout, discarded.rdbuf()); // The timed functions print reports
+        
+        LatencySample report;
+        for (int run = 0; run < 20; ++run) {
+            report.time([&]() { system.generateDistributionReport(); });
+            discarded.str("");
+        }
+        results.emplace_back("generateDistributionReport", report);
+        
+        LatencySample route;
+        for (int run = 0; run < 3; ++run) {
+            std::istringstream answers("1\n1\n"); // Supplier 1, transporter 1
+            ScopedStreamRedirect input(std::cin, answers.rdbuf());
+            route.time([&]() { system.optimizeDistributionRoute(); });
+            discarded.str("");
+        }
+        results.emplace_back("optimizeDistributionRoute", route);
+        
+        LatencySample inventory;
+        for (int run = 0; run < 5; ++run) {
+            std::istringstream answers("1\nn\n"); // Product 1, do not record
+            ScopedStreamRedirect input(std::cin, answers.rdbuf());
+            inventory.time([&]() { system.optimizeInventory(); });
+            discarded.str("");
+        }
+        results.emplace_back("optimizeInventory (one product)", inventory);
+        
+        LatencySample allInventory;
+        for (int run = 0; run < 3; ++run) {
+            allInventory.time([&]() { system.optimizeAllInventory(false); });
+            discarded.str("");
+        }
+        results.emplace_back("optimizeAllInventory", allInventory);
+        
+        std::vector<ScenarioSpec> specs = ProductionPlanningSystem::scenarioGrid({0.8, 1.0, 1.2, 1.5}, {0.5, 1.0, 2.0}, {{}});
+        LatencySample scenarios;
+        for (int run = 0; run < 3; ++run) {
+            scenarios.time([&]() { system.runScenarios(specs); });
+        }
+        results.emplace_back("runScenarios (" + std::to_string(specs.size()) + " scenarios)", scenarios);
+        
+        LatencySample save;
+        for (int run = 0; run < 3; ++run) {
+            save.time([&]() { system.checkpoint(); });
+        }
+        results.emplace_back("saveData (full checkpoint)", save);
+        
+        // What a save past checkpointInterval blocks for; the write itself runs on the snapshot writer
+        LatencySample capture;
+        for (int run = 0; run < 3; ++run) {
+            capture.time([&]() { system.startCheckpoint(); });
+            system.settleSnapshots();
+        }
+        results.emplace_back("saveData (background checkpoint capture)", capture);
+        
+        LatencySample load;
+        for (int run = 0; run < 3; ++run) {
+            load.time([&]() { system.loadData(); });
+            discarded.str("");
+        }
+        results.emplace_back("loadData", load);
+        
+        Blockchain chain;
+        LatencySample chainLoad;
+        for (int run = 0; run < 3; ++run) {
+            chainLoad.time([&]() { chain.loadFromFile("blockchain.dat"); });
+        }
+        results.emplace_back("Blockchain::loadFromFile (" + std::to_string(chain.size()) + " blocks)", chainLoad);
+        
+        LatencySample chainVerify;
+        bool valid = true;
+        for (int run = 0; run < 3; ++run) {
+            chainVerify.time([&]() { valid = chain.isChainValid() && valid; });
+        }
+        results.emplace_back(std::string("Blockchain::isChainValid") + (valid ? "" : " (INVALID)"), chainVerify);
+    }
+    
+    std::cout << "\n===== BENCHMARK RESULTS =====" << std::endl;
+    std::cout << std::left << std::setw(46) << "Operation" << std::right << std::setw(6) << "Runs"
+              << std::setw(14) << "ops/s" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms" << std::endl;
+    std::cout << std::fixed;
+    for (const auto& result : results) {
+        std::cout << std::left << std::setw(46) << result.first << std::right << std::setw(6) << result.second.runs()
+                  << std::setw(14) << std::setprecision(0) << result.second.operationsPerSecond()
+                  << std::setw(12) << std::setprecision(3) << result.second.percentile(0.50)
+                  << std::setw(12) << result.second.percentile(0.99) << std::endl;
+    }
+    std::cout << "Peak RSS: " << std::setprecision(1) << peakResidentMegabytes() << " MB" << std::endl;
+    
+    fs::current_path(originalDirectory);
+    std::error_code ignored;
+    fs::remove_all(scratch, ignored);
+    return 0;
+}
+
+// Utility function to read benchmark options of the form --name value
+bool parseBenchmarkOptions(int argc, char* argv[], int first, BenchmarkConfig& config) {
+    for (int i = first; i < argc; i += 2) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        int value;
+        std::string_view text(argv[i + 1]);
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size() || value < 0) {
+            return false;
+        }
+        if (option == "--products") config.products = value;
+        else if (option == "--suppliers") config.suppliers = value;
+        else if (option == "--retailers") config.retailers = value;
+        else if (option == "--transporters") config.transporters = value;
+        else if (option == "--transactions") config.transactions = value;
+        else if (option == "--single-orders") config.singleOrders = value;
+        else if (option == "--seed") config.seed = static_cast<unsigned>(value);
+        else return false;
+    }
+    return true;
+}
+
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // --resume starts from the saved data instead of the sample data
+    bool resume = argc == 2 && std::string(argv[1]) == "--resume";
+    if (argc > 1 && !resume) {
+        std::string option = argv[1];
+        if (option == "--batch" && argc == 3) {
+            try {
+                return runBatchMode(argv[2]);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Critical error: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+        if (option == "--verify-chain" && argc <= 3) {
+            return runVerifyMode(argc == 3 ? argv[2] : "blockchain.dat");
+        }
+        BenchmarkConfig config;
+        if (option == "--benchmark" && parseBenchmarkOptions(argc, argv, 2, config)) {
+            try {
+                return runBenchmarkMode(config);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Critical error: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+        std::cerr << "Usage: " << argv[0] << " [--resume | --batch <command file>|- | --verify-chain [chain file]]" << std::endl;
+        std::cerr << "       " << argv[0] << " --benchmark [--products N] [--suppliers N] [--retailers N]"
+                  << " [--transporters N] [--transactions N] [--single-orders N] [--seed N]" << std::endl;
+        return 1;
+    }
+    
     try {
-        ProductionPlanningSystem system; // Create an instance of the production planning system
+        ProductionPlanningSystem system(resume ? ProductionPlanningSystem::StartupMode::Resume
+                                               : ProductionPlanningSystem::StartupMode::SampleData); // Create an instance of the production planning system
         
         int choice;
         bool running = true;
@@ -2114,6 +9339,13 @@ int main() {
             std::cout << "16. Add New Supplier" << std::endl; // New option
             std::cout << "17. Add New Retailer" << std::endl; // New option
             std::cout << "18. Add New Transporter" << std::endl; // New option
+            std::cout << "19. Export Data (Text Format)" << std::endl;
+            std::cout << "20. Plan Fleet Routes (Capacitated)" << std::endl;
+            std::cout << "21. Manage Smart Contracts" << std::endl;
+            std::cout << "22. Query Transaction History" << std::endl;
+            std::cout << "23. Optimize Inventory (All Products)" << std::endl;
+            std::cout << "24. Show Metrics" << std::endl;
+            std::cout << "25. Run What-If Scenarios" << std::endl;
             std::cout << "0. Exit" << std::endl;
             std::cout << "Enter your choice: ";
             
@@ -2194,6 +9426,31 @@ int main() {
                 case 18:
                     system.addNewTransporter(); // Add new transporter
                     break;
+                case 19:
+                    if (system.exportTextData()) {
+                        std::cout << "Data exported to .dat files successfully." << std::endl;
+                    } else {
+                        std::cout << "Failed to export data." << std::endl;
+                    }
+                    break;
+                case 20:
+                    system.planFleetRoutes();
+                    break;
+                case 21:
+                    system.manageContracts();
+                    break;
+                case 22:
+                    system.queryTransactionHistory();
+                    break;
+                case 23:
+                    system.optimizeAllInventory();
+                    break;
+                case 24:
+                    system.showMetrics();
+                    break;
+                case 25:
+                    system.runWhatIfScenarios();
+                    break;
                 case 0:
                     running = false; // Exit the system
                     std::cout << "Exiting system. Thank you!" << std::endl;